@@ -0,0 +1,173 @@
+// Operations/sec of a user database shared by 1 to 32 threads: the sharded
+// ConcurrentUserManager against one UserManager behind a single
+// reader-writer lock
+#include <cstdint>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <fmt/format.h>
+
+#include "user/concurrent.hpp"
+#include "user/manager.hpp"
+
+namespace {
+
+constexpr size_t kUsers = 100000;
+constexpr size_t kGroups = 100;
+
+/// @brief The whole store behind one lock, the obvious way to share a UserManager
+class SingleLockManager {
+private:
+    mutable std::shared_mutex mutex;
+    UserManager users;
+
+public:
+    bool createUser(std::string_view username) {
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        return users.createUser(username);
+    }
+
+    bool createUsers(const std::string_view* usernames, size_t count) {
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        return users.createUsers(usernames, count);
+    }
+
+    bool userExists(std::string_view username) const {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        return users.userExists(username);
+    }
+
+    bool isUserEnabled(std::string_view username) const {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        return users.isUserEnabled(username);
+    }
+
+    bool addUserToGroup(std::string_view username, std::string_view group) {
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        return users.addUserToGroup(username, group);
+    }
+
+    bool removeUserFromGroup(std::string_view username, std::string_view group) {
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        return users.removeUserFromGroup(username, group);
+    }
+
+    // The listing cache is updated on read, so this takes the lock exclusively
+    std::vector<std::string> getUsers(std::string_view prefix) const {
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        auto listing = users.getUsers(prefix);
+        return std::vector<std::string>(listing.begin(), listing.end());
+    }
+};
+
+const std::vector<std::string>& userNames() {
+    static const std::vector<std::string> names = [] {
+        std::vector<std::string> result;
+        for (size_t i = 0; i < kUsers; ++i) {
+            result.push_back(fmt::format("user{}", i));
+        }
+        return result;
+    }();
+    return names;
+}
+
+/// @brief One populated store of each kind, shared by every benchmark thread
+template<typename Store>
+Store& population() {
+    static Store* store = [] {
+        auto* populated = new Store;
+        const auto& names = userNames();
+        std::vector<std::string_view> batch(names.begin(), names.end());
+        populated->createUsers(batch.data(), batch.size());
+        for (size_t i = 0; i < names.size(); ++i) {
+            populated->addUserToGroup(names[i], fmt::format("group{}", i % kGroups));
+        }
+        return populated;
+    }();
+    return *store;
+}
+
+/// @brief Per-thread xorshift, so threads do not share a generator
+struct Picker {
+    std::uint64_t x;
+
+    explicit Picker(const benchmark::State& state) : x(0x9E3779B97F4A7C15ull * (state.thread_index() + 1)) {}
+
+    std::string_view user() {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        return userNames()[x % kUsers];
+    }
+};
+
+template<typename Store>
+void BM_Reads(benchmark::State& state) {
+    Store& store = population<Store>();
+    Picker pick(state);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(store.userExists(pick.user()));
+        benchmark::DoNotOptimize(store.isUserEnabled(pick.user()));
+    }
+    state.SetItemsProcessed(state.iterations() * 2);
+}
+
+// Every 20th operation joins a group and leaves it again
+template<typename Store>
+void BM_ReadMostly(benchmark::State& state) {
+    Store& store = population<Store>();
+    Picker pick(state);
+    size_t i = 0;
+    for (auto _ : state) {
+        auto name = pick.user();
+        if (++i % 20 == 0) {
+            store.addUserToGroup(name, "visitors");
+            store.removeUserFromGroup(name, "visitors");
+        } else {
+            benchmark::DoNotOptimize(store.userExists(name));
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+template<typename Store>
+void BM_Writes(benchmark::State& state) {
+    Store& store = population<Store>();
+    Picker pick(state);
+    for (auto _ : state) {
+        auto name = pick.user();
+        benchmark::DoNotOptimize(store.addUserToGroup(name, "visitors"));
+        benchmark::DoNotOptimize(store.removeUserFromGroup(name, "visitors"));
+    }
+    state.SetItemsProcessed(state.iterations() * 2);
+}
+
+// Listings of about 1100 users against point reads on other threads
+template<typename Store>
+void BM_ListingWithReads(benchmark::State& state) {
+    Store& store = population<Store>();
+    Picker pick(state);
+    for (auto _ : state) {
+        if (state.thread_index() == 0) {
+            benchmark::DoNotOptimize(store.getUsers("user99").size());
+        } else {
+            benchmark::DoNotOptimize(store.userExists(pick.user()));
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+#define CONCURRENCY_BENCHMARK(name)                                                                   \
+    BENCHMARK_TEMPLATE(name, ConcurrentUserManager)->ThreadRange(1, 32)->UseRealTime();              \
+    BENCHMARK_TEMPLATE(name, SingleLockManager)->ThreadRange(1, 32)->UseRealTime()
+
+CONCURRENCY_BENCHMARK(BM_Reads);
+CONCURRENCY_BENCHMARK(BM_ReadMostly);
+CONCURRENCY_BENCHMARK(BM_Writes);
+CONCURRENCY_BENCHMARK(BM_ListingWithReads);
+
+} // namespace
@@ -0,0 +1,25 @@
+// Writes the benchmark workloads as task files, for timing the main binary
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+#include "workloads.hpp"
+
+int main(int argc, char* argv[]) {
+    if (argc < 2 || argc > 3) {
+        std::cerr << "Usage: " << argv[0] << " DIRECTORY [USERS]\n"
+                  << "  writes one task file per workload (default 10000 users each)\n";
+        return EXIT_FAILURE;
+    }
+    size_t users = argc == 3 ? std::strtoul(argv[2], nullptr, 10) : 10000;
+    try {
+        for (const auto& path : writeTasks(argv[1], allWorkloads(users))) {
+            std::cout << path << "\n";
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+    return 0;
+}
@@ -0,0 +1,208 @@
+// Operations/sec of each UserManager operation, against a manager holding
+// range(0) users spread over 100 groups
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <fmt/format.h>
+
+#include "user/manager.hpp"
+
+namespace {
+
+constexpr size_t kGroups = 100;
+
+std::vector<std::string> names(const char* prefix, size_t count) {
+    std::vector<std::string> result;
+    result.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        result.push_back(fmt::format("{}{}", prefix, i));
+    }
+    return result;
+}
+
+/// @brief Manager with the given users, each in one group and with one message
+struct Population {
+    std::vector<std::string> users;
+    std::vector<std::string> groups = names("group", kGroups);
+    UserManager manager;
+
+    explicit Population(size_t count) : users(names("user", count)) {
+        for (size_t i = 0; i < users.size(); ++i) {
+            manager.createUser(users[i]);
+            manager.addUserToGroup(users[i], groups[i % kGroups]);
+            manager.sendMessage(users[i], "Welcome");
+        }
+    }
+
+    // The i-th user, cycling
+    std::string_view user(size_t i) const { return users[i % users.size()]; }
+};
+
+size_t populationSize(const benchmark::State& state) {
+    return static_cast<size_t>(state.range(0));
+}
+
+// Creating range(0) users into an emptied manager
+void BM_CreateUser(benchmark::State& state) {
+    const auto users = names("user", populationSize(state));
+    UserManager manager;
+    for (auto _ : state) {
+        for (const auto& name : users) {
+            benchmark::DoNotOptimize(manager.createUser(name));
+        }
+        manager.reset();
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(users.size()));
+}
+
+void BM_CreateUsersBulk(benchmark::State& state) {
+    const auto users = names("user", populationSize(state));
+    const std::vector<std::string_view> views(users.begin(), users.end());
+    UserManager manager;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(manager.createUsers(views.data(), views.size()));
+        manager.reset();
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(users.size()));
+}
+
+// Deleting a user and creating it again, so the population stays the same
+void BM_DeleteUser(benchmark::State& state) {
+    Population population(populationSize(state));
+    size_t i = 0;
+    for (auto _ : state) {
+        auto name = population.user(i++);
+        benchmark::DoNotOptimize(population.manager.deleteUser(name));
+        population.manager.createUser(name);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+void BM_DisableUser(benchmark::State& state) {
+    Population population(populationSize(state));
+    size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(population.manager.disableUser(population.user(i++)));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+void BM_UserExists(benchmark::State& state) {
+    Population population(populationSize(state));
+    size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(population.manager.userExists(population.user(i++)));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+void BM_SendMessage(benchmark::State& state) {
+    Population population(populationSize(state));
+    size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(population.manager.sendMessage(population.user(i++), "Hello there"));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+// Joining a second group and leaving it again
+void BM_AddAndRemoveGroup(benchmark::State& state) {
+    Population population(populationSize(state));
+    size_t i = 0;
+    for (auto _ : state) {
+        auto name = population.user(i++);
+        benchmark::DoNotOptimize(population.manager.addUserToGroup(name, "visitors"));
+        benchmark::DoNotOptimize(population.manager.removeUserFromGroup(name, "visitors"));
+    }
+    state.SetItemsProcessed(state.iterations() * 2);
+}
+
+void BM_AddUsersToGroupBulk(benchmark::State& state) {
+    Population population(populationSize(state));
+    const std::vector<std::string_view> views(population.users.begin(), population.users.end());
+    size_t round = 0;
+    for (auto _ : state) {
+        auto group = fmt::format("cohort{}", round++);
+        benchmark::DoNotOptimize(population.manager.addUsersToGroup(views.data(), views.size(), group));
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(views.size()));
+}
+
+// Listing with no change in between: served from the sorted cache
+void BM_GetUsersCached(benchmark::State& state) {
+    Population population(populationSize(state));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(population.manager.getUsers().size());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+// Listing after every create: the new user is merged into the cache
+void BM_GetUsersAfterCreate(benchmark::State& state) {
+    Population population(populationSize(state));
+    size_t i = 0;
+    for (auto _ : state) {
+        population.manager.createUser(fmt::format("late{}", i++));
+        benchmark::DoNotOptimize(population.manager.getUsers().size());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+void BM_GetUsersWithPrefix(benchmark::State& state) {
+    Population population(populationSize(state));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(population.manager.getUsers("user1").size());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+void BM_GetGroups(benchmark::State& state) {
+    Population population(populationSize(state));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(population.manager.getGroups().size());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+void BM_GetMessageHistory(benchmark::State& state) {
+    Population population(populationSize(state));
+    size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(population.manager.getMessageHistory(population.user(i++), 0, 20).size());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+void BM_Reset(benchmark::State& state) {
+    Population population(populationSize(state));
+    for (auto _ : state) {
+        state.PauseTiming();
+        for (size_t i = 0; i < population.users.size(); ++i) {
+            population.manager.createUser(population.users[i]);
+        }
+        state.ResumeTiming();
+        population.manager.reset();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+#define MANAGER_BENCHMARK(name) BENCHMARK(name)->Arg(1000)->Arg(100000)
+
+MANAGER_BENCHMARK(BM_CreateUser);
+MANAGER_BENCHMARK(BM_CreateUsersBulk);
+MANAGER_BENCHMARK(BM_DeleteUser);
+MANAGER_BENCHMARK(BM_DisableUser);
+MANAGER_BENCHMARK(BM_UserExists);
+MANAGER_BENCHMARK(BM_SendMessage);
+MANAGER_BENCHMARK(BM_AddAndRemoveGroup);
+MANAGER_BENCHMARK(BM_AddUsersToGroupBulk);
+MANAGER_BENCHMARK(BM_GetUsersCached);
+MANAGER_BENCHMARK(BM_GetUsersAfterCreate);
+MANAGER_BENCHMARK(BM_GetUsersWithPrefix);
+MANAGER_BENCHMARK(BM_GetGroups);
+MANAGER_BENCHMARK(BM_GetMessageHistory);
+MANAGER_BENCHMARK(BM_Reset);
+
+} // namespace
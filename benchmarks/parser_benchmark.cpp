@@ -0,0 +1,116 @@
+// Lines/sec of CommandParser::parse, per command kind and over a
+// generated workload with and without token masks, and of the LineScanner
+// kernels that split task text
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "parser/grammar.hpp"
+#include "parser/parser.hpp"
+#include "task/scan.hpp"
+#include "workloads.hpp"
+
+namespace {
+
+void BM_ParseLine(benchmark::State& state, std::string_view line) {
+    for (auto _ : state) {
+        auto result = CommandParser::parse(line);
+        benchmark::DoNotOptimize(result);
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(line.size()));
+}
+BENCHMARK_CAPTURE(BM_ParseLine, create_user, "CREATE USER alice");
+BENCHMARK_CAPTURE(BM_ParseLine, create_users, "CREATE USERS user[1..1000]");
+BENCHMARK_CAPTURE(BM_ParseLine, delete_user, "DELETE USER alice");
+BENCHMARK_CAPTURE(BM_ParseLine, disable_user, "DISABLE USER alice");
+BENCHMARK_CAPTURE(BM_ParseLine, send_message, "SEND MESSAGE alice \"Welcome to the system!\"");
+BENCHMARK_CAPTURE(BM_ParseLine, ping, "PING alice 3");
+BENCHMARK_CAPTURE(BM_ParseLine, ping_many, "PING alice,bob,carol,dave 100 SUMMARY");
+BENCHMARK_CAPTURE(BM_ParseLine, add_to_group, "ADD USER alice TO GROUP admins");
+BENCHMARK_CAPTURE(BM_ParseLine, add_users_to_group, "ADD USERS alice,bob,carol TO GROUP admins");
+BENCHMARK_CAPTURE(BM_ParseLine, remove_from_group, "REMOVE USER alice FROM GROUP admins");
+BENCHMARK_CAPTURE(BM_ParseLine, get_users, "GET USERS");
+BENCHMARK_CAPTURE(BM_ParseLine, get_users_prefix, "GET USERS WITH PREFIX al");
+BENCHMARK_CAPTURE(BM_ParseLine, get_groups, "GET GROUPS");
+BENCHMARK_CAPTURE(BM_ParseLine, get_history, "GET MESSAGE HISTORY alice FROM 10 LIMIT 20");
+BENCHMARK_CAPTURE(BM_ParseLine, exit, "EXIT");
+BENCHMARK_CAPTURE(BM_ParseLine, invalid, "FROBNICATE alice");
+
+// Parsing every line of a generated task, as the processor would
+void BM_ParseWorkload(benchmark::State& state) {
+    const auto lines = generateLines(mixedWorkload(static_cast<size_t>(state.range(0))));
+    int64_t bytes = 0;
+    for (const auto& line : lines) {
+        bytes += static_cast<int64_t>(line.size());
+    }
+    for (auto _ : state) {
+        for (const auto& line : lines) {
+            auto result = CommandParser::parse(line);
+            benchmark::DoNotOptimize(result);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(lines.size()));
+    state.SetBytesProcessed(state.iterations() * bytes);
+}
+BENCHMARK(BM_ParseWorkload)->Arg(1000)->Arg(10000);
+
+// The same, with the token masks a scan of the task made for each line
+void BM_ParseTokenizedWorkload(benchmark::State& state) {
+    const std::string text = generateTask(mixedWorkload(static_cast<size_t>(state.range(0))));
+    LineScanner scanner;
+    std::vector<LineSpan> spans;
+    TextTokens tokens;
+    tokens.restart(0);
+    scanner.scan(text, 0, text.size(), spans, &tokens);
+    scanner.finish(text.size(), spans);
+    std::vector<grammar::Line> lines;
+    for (const auto& span : spans) {
+        if (span.end > span.start) {
+            lines.emplace_back(std::string_view(text.data() + span.start, span.end - span.start),
+                               tokens.spaces.data(), tokens.words.data(), tokens.quotes.data(), span.start);
+        }
+    }
+    for (auto _ : state) {
+        for (const auto& line : lines) {
+            auto result = CommandParser::parse(line);
+            benchmark::DoNotOptimize(result);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(lines.size()));
+}
+BENCHMARK(BM_ParseTokenizedWorkload)->Arg(1000)->Arg(10000);
+
+// Splitting a generated task into lines, one piece as TaskSource would scan,
+// with or without classifying its bytes for the parser
+void BM_ScanLines(benchmark::State& state, ScanKernel kernel, bool tokenize) {
+    if (!LineScanner::supported(kernel)) {
+        state.SkipWithError("kernel not supported on this CPU");
+        return;
+    }
+    const std::string text = generateTask(mixedWorkload(10000));
+    std::vector<LineSpan> lines;
+    TextTokens tokens;
+    for (auto _ : state) {
+        LineScanner scanner(kernel);
+        lines.clear();
+        tokens.restart(0);
+        scanner.scan(text, 0, text.size(), lines, tokenize ? &tokens : nullptr);
+        scanner.finish(text.size(), lines);
+        benchmark::DoNotOptimize(lines.data());
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(lines.size()));
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(text.size()));
+}
+BENCHMARK_CAPTURE(BM_ScanLines, scalar, ScanKernel::Scalar, false);
+BENCHMARK_CAPTURE(BM_ScanLines, sse2, ScanKernel::Sse2, false);
+BENCHMARK_CAPTURE(BM_ScanLines, avx2, ScanKernel::Avx2, false);
+BENCHMARK_CAPTURE(BM_ScanLines, neon, ScanKernel::Neon, false);
+BENCHMARK_CAPTURE(BM_ScanLines, scalar_tokens, ScanKernel::Scalar, true);
+BENCHMARK_CAPTURE(BM_ScanLines, sse2_tokens, ScanKernel::Sse2, true);
+BENCHMARK_CAPTURE(BM_ScanLines, avx2_tokens, ScanKernel::Avx2, true);
+BENCHMARK_CAPTURE(BM_ScanLines, neon_tokens, ScanKernel::Neon, true);
+
+} // namespace
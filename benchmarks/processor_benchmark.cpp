@@ -0,0 +1,99 @@
+// End-to-end TaskProcessor::processTasks over generated task files, text and
+// compiled, sequential and parallel; transcripts go to a NullSink
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "output/sink.hpp"
+#include "task/compiled.hpp"
+#include "task/processor.hpp"
+#include "workloads.hpp"
+
+namespace {
+
+constexpr size_t kUsers = 5000;
+
+/// @brief One generated file per workload, written once per run
+struct Corpus {
+    std::vector<Workload> workloads = allWorkloads(kUsers);
+    std::vector<std::string> textFiles;
+    std::vector<std::string> compiledFiles;
+    int64_t bytes = 0;
+
+    Corpus() {
+        auto directory = std::filesystem::temp_directory_path() / "wzh-assesment-benchmark";
+        textFiles = writeTasks(directory.string(), workloads);
+        for (const auto& file : textFiles) {
+            bytes += static_cast<int64_t>(std::filesystem::file_size(file));
+            auto compiled = std::filesystem::path(file).replace_extension(".wzt").string();
+            compileTask(file, compiled);
+            compiledFiles.push_back(compiled);
+        }
+    }
+
+    static const Corpus& get() {
+        static const Corpus corpus;
+        return corpus;
+    }
+};
+
+void runFiles(benchmark::State& state, const std::vector<std::string>& files, ProcessorOptions options) {
+    NullSink sink;
+    TaskProcessor processor(options, sink);
+    const size_t jobs = static_cast<size_t>(state.range(0));
+    for (auto _ : state) {
+        processor.processTasks(files, jobs);
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(files.size()));
+    state.SetBytesProcessed(state.iterations() * Corpus::get().bytes);
+}
+
+// Each workload on its own, so a regression points at a command mix
+void BM_ProcessWorkload(benchmark::State& state) {
+    const auto& corpus = Corpus::get();
+    size_t index = static_cast<size_t>(state.range(0));
+    state.SetLabel(corpus.workloads[index].name);
+    NullSink sink;
+    TaskProcessor processor({}, sink);
+    const std::vector<std::string> files{corpus.textFiles[index]};
+    for (auto _ : state) {
+        processor.processTasks(files, 1);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ProcessWorkload)->DenseRange(0, 5)->Unit(benchmark::kMillisecond);
+
+void BM_ProcessText(benchmark::State& state) {
+    runFiles(state, Corpus::get().textFiles, {});
+}
+BENCHMARK(BM_ProcessText)->Arg(1)->Arg(4)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+void BM_ProcessTextQuiet(benchmark::State& state) {
+    ProcessorOptions options;
+    options.quiet = true;
+    runFiles(state, Corpus::get().textFiles, options);
+}
+BENCHMARK(BM_ProcessTextQuiet)->Arg(1)->Arg(4)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+void BM_ProcessTextPipelined(benchmark::State& state) {
+    ProcessorOptions options;
+    options.pipeline = true;
+    runFiles(state, Corpus::get().textFiles, options);
+}
+BENCHMARK(BM_ProcessTextPipelined)->Arg(1)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+void BM_ProcessTextSplitParse(benchmark::State& state) {
+    ProcessorOptions options;
+    options.parseWorkers = 4;
+    runFiles(state, Corpus::get().textFiles, options);
+}
+BENCHMARK(BM_ProcessTextSplitParse)->Arg(1)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+void BM_ProcessCompiled(benchmark::State& state) {
+    runFiles(state, Corpus::get().compiledFiles, {});
+}
+BENCHMARK(BM_ProcessCompiled)->Arg(1)->Arg(4)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+} // namespace
@@ -0,0 +1,105 @@
+// Commands/sec of CommandRegistry::execute: the compile-time dispatch table
+// against the type_index map + virtual call scheme it replaced
+#include <memory>
+#include <typeindex>
+#include <unordered_map>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "commands/executor.hpp"
+#include "registry/registry.hpp"
+#include "user/manager.hpp"
+
+namespace {
+
+// Previous registry: hash lookup by type, virtual call, std::get in the executor
+class LegacyRegistry {
+private:
+    std::unordered_map<std::type_index, std::unique_ptr<CommandExecutor>> executors;
+
+public:
+    template<typename T>
+    void registerExecutor(std::unique_ptr<CommandExecutor> executor) {
+        executors[std::type_index(typeid(T))] = std::move(executor);
+    }
+
+    CommandResult execute(const Command& cmd, UserManager& userManager) const {
+        return std::visit([&](const auto& command) -> CommandResult {
+            using T = std::decay_t<decltype(command)>;
+            auto it = executors.find(std::type_index(typeid(T)));
+            if (it != executors.end()) {
+                return it->second->execute(command, userManager);
+            }
+            return {ResultStatus::UserNotFound};
+        }, cmd);
+    }
+};
+
+template<typename Registry>
+void registerAll(Registry& registry) {
+    registry.template registerExecutor<CreateUserCommand>(std::make_unique<CreateUserExecutor>());
+    registry.template registerExecutor<CreateUsersCommand>(std::make_unique<CreateUsersExecutor>());
+    registry.template registerExecutor<DeleteUserCommand>(std::make_unique<DeleteUserExecutor>());
+    registry.template registerExecutor<DisableUserCommand>(std::make_unique<DisableUserExecutor>());
+    registry.template registerExecutor<SendMessageCommand>(std::make_unique<SendMessageExecutor>());
+    registry.template registerExecutor<PingCommand>(std::make_unique<PingExecutor>());
+    registry.template registerExecutor<AddUserToGroupCommand>(std::make_unique<AddUserToGroupExecutor>());
+    registry.template registerExecutor<AddUsersToGroupCommand>(std::make_unique<AddUsersToGroupExecutor>());
+    registry.template registerExecutor<RemoveUserFromGroupCommand>(std::make_unique<RemoveUserFromGroupExecutor>());
+    registry.template registerExecutor<GetUsersCommand>(std::make_unique<GetUsersExecutor>());
+    registry.template registerExecutor<GetGroupsCommand>(std::make_unique<GetGroupsExecutor>());
+    registry.template registerExecutor<GetMessageHistoryCommand>(std::make_unique<GetMessageHistoryExecutor>());
+    registry.template registerExecutor<ExitCommand>(std::make_unique<ExitExecutor>());
+}
+
+// Idempotent mix, so the user state stays the same across iterations
+std::vector<Command> commandMix() {
+    return {
+        CreateUserCommand{"alice"},
+        DisableUserCommand{"bob"},
+        AddUserToGroupCommand{"alice", "admins"},
+        RemoveUserFromGroupCommand{"bob", "guests"},
+        PingCommand{"alice", 1, false},
+        SendMessageCommand{"carol", "unknown user"},
+        DeleteUserCommand{"carol"},
+        ExitCommand{},
+    };
+}
+
+template<typename Registry>
+void runMix(benchmark::State& state, const Registry& registry) {
+    UserManager userManager;
+    userManager.createUser("alice");
+    userManager.createUser("bob");
+    const auto commands = commandMix();
+
+    for (auto _ : state) {
+        for (const auto& cmd : commands) {
+            benchmark::DoNotOptimize(registry.execute(cmd, userManager));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(commands.size()));
+}
+
+void BM_LegacyTypeIndexDispatch(benchmark::State& state) {
+    LegacyRegistry registry;
+    registerAll(registry);
+    runMix(state, registry);
+}
+BENCHMARK(BM_LegacyTypeIndexDispatch);
+
+void BM_RuntimeOverrideDispatch(benchmark::State& state) {
+    CommandRegistry registry;
+    registerAll(registry);
+    runMix(state, registry);
+}
+BENCHMARK(BM_RuntimeOverrideDispatch);
+
+void BM_StaticDispatch(benchmark::State& state) {
+    CommandRegistry registry;
+    runMix(state, registry);
+}
+BENCHMARK(BM_StaticDispatch);
+
+} // namespace
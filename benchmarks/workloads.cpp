@@ -0,0 +1,176 @@
+#include "workloads.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <random>
+#include <fmt/format.h>
+
+#include "output/sink.hpp"
+
+Workload onboardingWorkload(size_t users) {
+    Workload w;
+    w.name = "onboarding";
+    w.users = users;
+    w.groups = std::max<size_t>(1, users / 100);
+    w.messagesPerUser = 0;
+    w.pings = 0;
+    w.listings = 1;
+    w.churn = 0;
+    return w;
+}
+
+Workload bulkOnboardingWorkload(size_t users) {
+    Workload w = onboardingWorkload(users);
+    w.name = "bulk_onboarding";
+    w.bulk = true;
+    return w;
+}
+
+Workload messageHeavyWorkload(size_t users) {
+    Workload w;
+    w.name = "message_heavy";
+    w.users = users;
+    w.messagesPerUser = 20;
+    w.pings = users / 100;
+    w.listings = 20;
+    w.seed = 2;
+    return w;
+}
+
+Workload pingHeavyWorkload(size_t users) {
+    Workload w;
+    w.name = "ping_heavy";
+    w.users = users;
+    w.messagesPerUser = 0;
+    w.pings = users * 2;
+    w.pingTimes = 50;
+    w.seed = 3;
+    return w;
+}
+
+Workload mixedWorkload(size_t users) {
+    Workload w;
+    w.name = "mixed";
+    w.users = users;
+    w.churn = users / 20;
+    w.seed = 4;
+    return w;
+}
+
+Workload failingWorkload(size_t users) {
+    Workload w = mixedWorkload(users);
+    w.name = "failing";
+    w.fails = true;
+    w.seed = 5;
+    return w;
+}
+
+std::vector<Workload> allWorkloads(size_t users) {
+    return {
+        onboardingWorkload(users),
+        bulkOnboardingWorkload(users),
+        messageHeavyWorkload(users),
+        pingHeavyWorkload(users),
+        mixedWorkload(users),
+        failingWorkload(users),
+    };
+}
+
+std::vector<std::string> generateLines(const Workload& w) {
+    std::mt19937 random(w.seed);
+    auto pick = [&](size_t n) { return std::uniform_int_distribution<size_t>(0, n - 1)(random); };
+    auto user = [](size_t i) { return fmt::format("user{}", i); };
+    auto group = [](size_t i) { return fmt::format("group{}", i); };
+
+    std::vector<std::string> lines;
+    if (w.bulk) {
+        lines.push_back(fmt::format("CREATE USERS user[0..{}]", static_cast<long long>(w.users) - 1));
+    } else {
+        for (size_t i = 0; i < w.users; ++i) {
+            lines.push_back("CREATE USER " + user(i));
+        }
+    }
+    if (w.groups > 0 && w.users > 0) {
+        if (w.bulk) {
+            // The memberships of the per-line form: in round r, group g gets every
+            // user i with (i + r) % groups == g
+            for (size_t round = 0; round < w.groupsPerUser; ++round) {
+                for (size_t g = 0; g < w.groups; ++g) {
+                    std::string members;
+                    for (size_t i = (g + w.groups - round % w.groups) % w.groups; i < w.users; i += w.groups) {
+                        members += (members.empty() ? "" : ",") + user(i);
+                    }
+                    if (!members.empty()) {
+                        lines.push_back(fmt::format("ADD USERS {} TO GROUP {}", members, group(g)));
+                    }
+                }
+            }
+        } else {
+            for (size_t i = 0; i < w.users; ++i) {
+                for (size_t round = 0; round < w.groupsPerUser; ++round) {
+                    lines.push_back(fmt::format("ADD USER {} TO GROUP {}", user(i), group((i + round) % w.groups)));
+                }
+            }
+        }
+    }
+
+    // The rest runs in a random order against the users created above. The
+    // last `reserved` users are the ones disabled and finally deleted, so no
+    // message goes to a user that cannot take it.
+    size_t reserved = std::min(w.churn, w.users / 2);
+    size_t active = w.users - reserved;
+    std::vector<std::string> mix;
+    if (active > 0) {
+        for (size_t k = 0; k < w.users * w.messagesPerUser; ++k) {
+            mix.push_back(fmt::format("SEND MESSAGE {} \"Message {} of the benchmark\"", user(pick(active)), k));
+        }
+        for (size_t k = 0; k < w.pings; ++k) {
+            std::string target = k % 10 == 9 ? fmt::format("missing{}", k) : user(pick(active));
+            mix.push_back(fmt::format("PING {} {}", target, w.pingTimes));
+        }
+        for (size_t k = 0; k < w.listings; ++k) {
+            mix.push_back("GET USERS");
+            mix.push_back("GET GROUPS");
+            mix.push_back(fmt::format("GET MESSAGE HISTORY {} LIMIT 20", user(pick(active))));
+        }
+    }
+    for (size_t k = 0; k < reserved; ++k) {
+        mix.push_back("DISABLE USER " + user(active + pick(reserved)));
+        if (w.groups > 0) {
+            mix.push_back(fmt::format("REMOVE USER {} FROM GROUP {}", user(pick(w.users)), group(pick(w.groups))));
+        }
+    }
+    std::shuffle(mix.begin(), mix.end(), random);
+    lines.insert(lines.end(), mix.begin(), mix.end());
+
+    for (size_t i = active; i < w.users; ++i) {
+        lines.push_back("DELETE USER " + user(i));
+    }
+    if (w.fails) {
+        size_t at = lines.size() * 3 / 4;
+        lines.insert(lines.begin() + static_cast<std::ptrdiff_t>(at), "SEND MESSAGE nobody \"Never delivered\"");
+    }
+    lines.push_back("EXIT");
+    return lines;
+}
+
+std::string generateTask(const Workload& workload) {
+    std::string text;
+    for (const auto& line : generateLines(workload)) {
+        text += line;
+        text += '\n';
+    }
+    return text;
+}
+
+std::vector<std::string> writeTasks(const std::string& directory, const std::vector<Workload>& workloads) {
+    std::filesystem::create_directories(directory);
+    std::vector<std::string> paths;
+    for (size_t i = 0; i < workloads.size(); ++i) {
+        auto path = (std::filesystem::path(directory) / fmt::format("{:02}_{}.txt", i, workloads[i].name)).string();
+        FileSink file(path);
+        file.write(generateTask(workloads[i]));
+        paths.push_back(path);
+    }
+    return paths;
+}
@@ -0,0 +1,62 @@
+#ifndef BENCHMARKS_WORKLOADS_HPP
+#define BENCHMARKS_WORKLOADS_HPP
+
+// Standard Library
+#include <cstddef>       // For size_t
+#include <cstdint>       // For uint32_t
+#include <string>        // For std::string
+#include <vector>        // For std::vector
+
+/// @brief Shape of a synthetic task file
+///
+/// A task creates its users, spreads them over the groups and then runs a
+/// shuffled mix of messages, pings, listings and state changes against
+/// them. The same workload always generates the same text.
+struct Workload {
+    std::string name;
+    size_t users = 1000;
+    size_t groups = 20;
+    size_t groupsPerUser = 2;
+    size_t messagesPerUser = 2;
+    size_t pings = 100;             // PING commands, a tenth of them to missing users
+    int pingTimes = 3;
+    size_t listings = 4;            // Each of GET USERS, GET GROUPS and GET MESSAGE HISTORY
+    size_t churn = 50;              // DISABLE, REMOVE FROM GROUP and DELETE commands each, at most users / 2
+    bool bulk = false;              // Create and group users with the bulk commands
+    bool fails = false;             // Stop three quarters in on a command that fails
+    std::uint32_t seed = 1;
+};
+
+/// @brief Many users joining groups, nothing else: a tenant import
+Workload onboardingWorkload(size_t users);
+
+/// @brief onboardingWorkload() written with CREATE USERS / ADD USERS TO GROUP
+Workload bulkOnboardingWorkload(size_t users);
+
+/// @brief Mostly SEND MESSAGE, with history reads
+Workload messageHeavyWorkload(size_t users);
+
+/// @brief Mostly PING with large repeat counts
+Workload pingHeavyWorkload(size_t users);
+
+/// @brief A bit of everything
+Workload mixedWorkload(size_t users);
+
+/// @brief mixedWorkload() that stops on a failing command
+Workload failingWorkload(size_t users);
+
+/// @brief Every workload above, for the given user count
+std::vector<Workload> allWorkloads(size_t users);
+
+/// @brief Command lines of the task, in order
+std::vector<std::string> generateLines(const Workload& workload);
+
+/// @brief Task file text: the lines, each ending in a newline
+std::string generateTask(const Workload& workload);
+
+/// @brief Write one task file per workload into directory (created if needed)
+/// @return the paths written, in order
+/// @throws std::runtime_error if a file cannot be written
+std::vector<std::string> writeTasks(const std::string& directory, const std::vector<Workload>& workloads);
+
+#endif // BENCHMARKS_WORKLOADS_HPP
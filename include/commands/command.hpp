@@ -1,60 +1,147 @@
 #ifndef COMMANDS_COMMAND_HPP
 #define COMMANDS_COMMAND_HPP
 
+#include <algorithm>
+#include <charconv>
+#include <cstddef>
+#include <optional>
 #include <string>
+#include <string_view>
 #include <variant>
 #include <cstdint> // For fixed size integers as int32_t
 
 // Command structures
+//
+// Commands are views over the line they were parsed from: every string field
+// points into the buffer owned by the running task, so a command must not
+// outlive it. UserManager copies a name or message only when it stores it.
 
 /// @brief Command to create a new user
 struct CreateUserCommand {
-    std::string username;
+    std::string_view username;
+};
+
+/// @brief Names given to a bulk command
+///
+/// Either a comma-separated list ("alice,bob") or a numbered range:
+/// user[1..3] stands for user1, user2 and user3. A range counts up, so its
+/// first bound is at most its last, and names at most kMaxRangeNames users;
+/// the parser rejects any other, as their names are all formatted before
+/// the command runs.
+struct NameList {
+    static constexpr size_t kMaxRangeNames = 1000000;
+
+    std::string_view text;   // The list, or the name prefix of a range
+    bool isRange = false;
+    int32_t first = 0;       // Range bounds, inclusive; first <= last
+    int32_t last = 0;
+
+    size_t count() const {
+        if (isRange) {
+            return static_cast<size_t>(int64_t(last) - first + 1);
+        }
+        return static_cast<size_t>(std::count(text.begin(), text.end(), ',')) + 1;
+    }
+
+    /// @brief Call f with each name in order
+    ///
+    /// A range name is formatted into a scratch buffer, so it is only valid
+    /// during its call.
+    template<typename F>
+    void forEach(F&& f) const {
+        if (!isRange) {
+            std::string_view rest = text;
+            for (size_t comma; (comma = rest.find(',')) != std::string_view::npos; rest.remove_prefix(comma + 1)) {
+                f(rest.substr(0, comma));
+            }
+            f(rest);
+            return;
+        }
+        std::string name(text.size() + 11, '\0');
+        std::copy(text.begin(), text.end(), name.begin());
+        for (int64_t n = first; n <= last; ++n) {
+            char* end = std::to_chars(name.data() + text.size(), name.data() + name.size(), n).ptr;
+            f(std::string_view(name.data(), static_cast<size_t>(end - name.data())));
+        }
+    }
+};
+
+/// @brief Command to create several users at once; all or none are created
+struct CreateUsersCommand {
+    NameList names;
 };
 
 /// @brief Command to delete an existing user
 struct DeleteUserCommand {
-    std::string username;
+    std::string_view username;
 };
 
 /// @brief Command to disable a user
 struct DisableUserCommand {
-    std::string username;
+    std::string_view username;
 };
 
 /// @brief Command to send a message to a user
 struct SendMessageCommand {
-    std::string username;
-    std::string message;
+    std::string_view username;
+    std::string_view message;
 };
 
-/// @brief Command to ping a user multiple times
+/// @brief Command to ping one or more users multiple times
 struct PingCommand {
-    std::string username;
+    static constexpr size_t kMaxTargets = 64;  // Enforced by the parser
+
+    std::string_view targets;  // One username, or up to kMaxTargets separated by commas
     int32_t times;  // Tipo más explícito para el número de veces
+    bool summary = false;  // Report the counts instead of a line per ping
+
+    /// @brief Split targets into names, returning how many there are
+    size_t splitTargets(std::string_view (&names)[kMaxTargets]) const {
+        size_t count = 0;
+        std::string_view rest = targets;
+        while (count < kMaxTargets) {
+            size_t comma = rest.find(',');
+            names[count++] = rest.substr(0, comma);
+            if (comma == std::string_view::npos) {
+                break;
+            }
+            rest.remove_prefix(comma + 1);
+        }
+        return count;
+    }
 };
 
 /// @brief Command to add user to a group
 struct AddUserToGroupCommand {
-    std::string username;
-    std::string group;
+    std::string_view username;
+    std::string_view group;
+};
+
+/// @brief Command to add several existing users to a group; all or none are added
+struct AddUsersToGroupCommand {
+    NameList names;
+    std::string_view group;
 };
 
 /// @brief Command to remove user from a group
 struct RemoveUserFromGroupCommand {
-    std::string username;
-    std::string group;
+    std::string_view username;
+    std::string_view group;
 };
 
 /// @brief Command to list all users
-struct GetUsersCommand {};
+struct GetUsersCommand {
+    std::optional<std::string_view> prefix;   // WITH PREFIX x: only names starting with x
+};
 
 /// @brief Command to list all groups
 struct GetGroupsCommand {};
 
 /// @brief Command to get message history for a user
 struct GetMessageHistoryCommand {
-    std::string username;
+    std::string_view username;
+    std::optional<int32_t> from;    // FROM n: skip the first n messages
+    std::optional<int32_t> limit;   // LIMIT k: return at most k messages
 };
 
 /// @brief Command to exit the application
@@ -63,11 +150,13 @@ struct ExitCommand {};
 // Command variant
 using Command = std::variant<
     CreateUserCommand,
+    CreateUsersCommand,
     DeleteUserCommand,
     DisableUserCommand,
     SendMessageCommand,
     PingCommand,
     AddUserToGroupCommand,
+    AddUsersToGroupCommand,
     RemoveUserFromGroupCommand,
     GetUsersCommand,
     GetGroupsCommand,
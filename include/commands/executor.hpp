@@ -6,74 +6,124 @@
 #include <fmt/format.h>
 #include <string>
 #include <memory>
-#include <typeindex>
+#include <variant>
 
 #include "result.hpp"
 
 // Forward declarations
 class UserManager;
+class ConcurrentUserManager;
 
 // Base command executor interface
+//
+// A command runs against a task's own UserManager, or against the store
+// all tasks share (see ProcessorOptions::sharedState).
 class CommandExecutor {
 public:
     virtual ~CommandExecutor() = default;
     virtual CommandResult execute(const Command& cmd, UserManager& userManager) = 0;
+    virtual CommandResult execute(const Command& cmd, ConcurrentUserManager& users) = 0;
+};
+
+/// @brief Adapts an executor with a typed static run() to the runtime interface
+///
+/// CommandRegistry calls Derived::run directly; the virtual execute() is only
+/// used when the executor is registered as a runtime override.
+template<typename Derived, typename T>
+class TypedExecutor : public CommandExecutor {
+public:
+    using CommandType = T;
+
+    CommandResult execute(const Command& cmd, UserManager& userManager) override {
+        return Derived::run(std::get<T>(cmd), userManager);
+    }
+
+    CommandResult execute(const Command& cmd, ConcurrentUserManager& users) override {
+        return Derived::run(std::get<T>(cmd), users);
+    }
 };
 
 // Command executors
-class CreateUserExecutor : public CommandExecutor {
+//
+// Most run the same way on either store, so run() is a template
+// instantiated for both; those returning listings or histories have an
+// overload per store, as a shared store copies them out.
+class CreateUserExecutor : public TypedExecutor<CreateUserExecutor, CreateUserCommand> {
+public:
+    template<typename Users>
+    static CommandResult run(const CreateUserCommand& cmd, Users& users);
+};
+
+class CreateUsersExecutor : public TypedExecutor<CreateUsersExecutor, CreateUsersCommand> {
+public:
+    template<typename Users>
+    static CommandResult run(const CreateUsersCommand& cmd, Users& users);
+};
+
+class DeleteUserExecutor : public TypedExecutor<DeleteUserExecutor, DeleteUserCommand> {
 public:
-    CommandResult execute(const Command& cmd, UserManager& userManager) override;
+    template<typename Users>
+    static CommandResult run(const DeleteUserCommand& cmd, Users& users);
 };
 
-class DeleteUserExecutor : public CommandExecutor {
+class DisableUserExecutor : public TypedExecutor<DisableUserExecutor, DisableUserCommand> {
 public:
-    CommandResult execute(const Command& cmd, UserManager& userManager) override;
+    template<typename Users>
+    static CommandResult run(const DisableUserCommand& cmd, Users& users);
 };
 
-class DisableUserExecutor : public CommandExecutor {
+class SendMessageExecutor : public TypedExecutor<SendMessageExecutor, SendMessageCommand> {
 public:
-    CommandResult execute(const Command& cmd, UserManager& userManager) override;
+    template<typename Users>
+    static CommandResult run(const SendMessageCommand& cmd, Users& users);
 };
 
-class SendMessageExecutor : public CommandExecutor {
+class PingExecutor : public TypedExecutor<PingExecutor, PingCommand> {
 public:
-    CommandResult execute(const Command& cmd, UserManager& userManager) override;
+    template<typename Users>
+    static CommandResult run(const PingCommand& cmd, Users& users);
 };
 
-class PingExecutor : public CommandExecutor {
+class AddUserToGroupExecutor : public TypedExecutor<AddUserToGroupExecutor, AddUserToGroupCommand> {
 public:
-    CommandResult execute(const Command& cmd, UserManager& userManager) override;
+    template<typename Users>
+    static CommandResult run(const AddUserToGroupCommand& cmd, Users& users);
 };
 
-class AddUserToGroupExecutor : public CommandExecutor {
+class AddUsersToGroupExecutor : public TypedExecutor<AddUsersToGroupExecutor, AddUsersToGroupCommand> {
 public:
-    CommandResult execute(const Command& cmd, UserManager& userManager) override;
+    template<typename Users>
+    static CommandResult run(const AddUsersToGroupCommand& cmd, Users& users);
 };
 
-class RemoveUserFromGroupExecutor : public CommandExecutor {
+class RemoveUserFromGroupExecutor : public TypedExecutor<RemoveUserFromGroupExecutor, RemoveUserFromGroupCommand> {
 public:
-    CommandResult execute(const Command& cmd, UserManager& userManager) override;
+    template<typename Users>
+    static CommandResult run(const RemoveUserFromGroupCommand& cmd, Users& users);
 };
 
-class GetUsersExecutor : public CommandExecutor {
+class GetUsersExecutor : public TypedExecutor<GetUsersExecutor, GetUsersCommand> {
 public:
-    CommandResult execute(const Command& cmd, UserManager& userManager) override;
+    static CommandResult run(const GetUsersCommand& cmd, UserManager& userManager);
+    static CommandResult run(const GetUsersCommand& cmd, ConcurrentUserManager& users);
 };
 
-class GetGroupsExecutor : public CommandExecutor {
+class GetGroupsExecutor : public TypedExecutor<GetGroupsExecutor, GetGroupsCommand> {
 public:
-    CommandResult execute(const Command& cmd, UserManager& userManager) override;
+    static CommandResult run(const GetGroupsCommand& cmd, UserManager& userManager);
+    static CommandResult run(const GetGroupsCommand& cmd, ConcurrentUserManager& users);
 };
 
-class GetMessageHistoryExecutor : public CommandExecutor {
+class GetMessageHistoryExecutor : public TypedExecutor<GetMessageHistoryExecutor, GetMessageHistoryCommand> {
 public:
-    CommandResult execute(const Command& cmd, UserManager& userManager) override;
+    static CommandResult run(const GetMessageHistoryCommand& cmd, UserManager& userManager);
+    static CommandResult run(const GetMessageHistoryCommand& cmd, ConcurrentUserManager& users);
 };
 
-class ExitExecutor : public CommandExecutor {
+class ExitExecutor : public TypedExecutor<ExitExecutor, ExitCommand> {
 public:
-    CommandResult execute(const Command& cmd, UserManager& userManager) override;
+    template<typename Users>
+    static CommandResult run(const ExitCommand& cmd, Users& users);
 };
 
 #endif // COMMANDS_EXECUTOR_HPP
\ No newline at end of file
@@ -0,0 +1,35 @@
+#ifndef COMMANDS_RENDER_HPP
+#define COMMANDS_RENDER_HPP
+
+// Standard Library
+#include <cstddef>      // For size_t
+#include <cstdint>      // For uint64_t
+
+// Project Headers
+#include "commands/result.hpp"    // For CommandResult
+#include "output/buffered.hpp"    // For BufferedOutput
+
+/// @brief Append the transcript text of an executed command to out
+///
+/// The text ends with a newline. Items of the result view UserManager
+/// storage, so it must be rendered before the next command runs. Long
+/// PING transcripts are handed to out block by block as they are written.
+void renderResult(const CommandResult& result, BufferedOutput& out);
+
+/// @brief How far renderSome() has written a result's transcript
+struct RenderCursor {
+    size_t item = 0;            // PING target, or listing item, to go on from
+    std::uint64_t repeats = 0;  // PING lines of that target written
+    bool opened = false;        // Whether the text before it is written
+};
+
+/// @brief renderResult() in pieces: stop once about room bytes have been
+///        appended, at a point the cursor records
+///
+/// Only PING repetitions and listings are split, so a piece may overrun
+/// room by about a quarter block. Pass the same cursor, starting from a
+/// default one, until it returns true.
+/// @return Whether the transcript is complete
+bool renderSome(const CommandResult& result, BufferedOutput& out, RenderCursor& cursor, size_t room);
+
+#endif // COMMANDS_RENDER_HPP
@@ -1,11 +1,43 @@
 #ifndef COMMANDS_RESULT_HPP
 #define COMMANDS_RESULT_HPP
 
+// Standard Library
+#include <cstdint>        // For uint8_t, uint64_t
+#include <memory>         // For std::shared_ptr
+
+// Project Headers
+#include "commands/command.hpp"   // For Command
+#include "user/messages.hpp"      // For MessageRange
+#include "user/range.hpp"         // For ViewRange, OwnedRange
+
+/// @brief What happened when a command ran
+enum class ResultStatus : std::uint8_t {
+    Ok,
+    Unanswered,     // Succeeded, but a target did not answer (PING to a missing user)
+    UserExists,     // Failed: user already exists
+    UserNotFound,   // Failed: user does not exist
+};
+
 // Command execution result
+//
+// Results are structured: the transcript text is rendered from them only
+// when it is written (see renderResult), so runs that discard it never
+// format anything.
 struct CommandResult {
-    bool success;
-    std::string message;
+    ResultStatus status = ResultStatus::Ok;
+    const Command* command = nullptr;       // The executed command, set by CommandRegistry
+    std::uint64_t answered = 0;             // PING: bit i set when target i exists
+    ViewRange items;                        // GET USERS / GET GROUPS listing, viewing UserManager storage
+    MessageRange history;                   // GET MESSAGE HISTORY page, viewing the message log
+    std::shared_ptr<const OwnedRange> owned; // What items or history view when copied out of a ConcurrentUserManager
     bool shouldExit = false;
+
+    // Implicit, so an executor can return just a status
+    CommandResult(ResultStatus status = ResultStatus::Ok) : status(status) {}
+
+    bool success() const {
+        return status == ResultStatus::Ok || status == ResultStatus::Unanswered;
+    }
 };
 
 #endif // COMMANDS_RESULT_HPP
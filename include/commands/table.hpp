@@ -0,0 +1,102 @@
+#ifndef COMMANDS_TABLE_HPP
+#define COMMANDS_TABLE_HPP
+
+// Project Headers
+#include "commands/command.hpp"    // For Command and its alternatives
+#include "commands/executor.hpp"   // For the executors
+#include "parser/grammar.hpp"      // For grammar::Table, grammar::Row
+
+/// @brief Every command: the executor that runs it and the syntax of its line
+///
+/// This is the one place a command is declared to the parser and to
+/// CommandRegistry. Rows that share a verb are tried top to bottom, and the
+/// first one to match decides the line.
+namespace command_table {
+
+using namespace grammar;
+
+inline constexpr char ADD[] = "ADD";
+inline constexpr char CREATE[] = "CREATE";
+inline constexpr char DELETE[] = "DELETE";
+inline constexpr char DISABLE[] = "DISABLE";
+inline constexpr char EXIT[] = "EXIT";
+inline constexpr char FROM[] = "FROM";
+inline constexpr char GET[] = "GET";
+inline constexpr char GROUP[] = "GROUP";
+inline constexpr char GROUPS[] = "GROUPS";
+inline constexpr char HISTORY[] = "HISTORY";
+inline constexpr char LIMIT[] = "LIMIT";
+inline constexpr char MESSAGE[] = "MESSAGE";
+inline constexpr char PING[] = "PING";
+inline constexpr char PREFIX[] = "PREFIX";
+inline constexpr char REMOVE[] = "REMOVE";
+inline constexpr char SEND[] = "SEND";
+inline constexpr char SUMMARY[] = "SUMMARY";
+inline constexpr char TO[] = "TO";
+inline constexpr char USER[] = "USER";
+inline constexpr char USERS[] = "USERS";
+inline constexpr char WITH[] = "WITH";
+
+using Bulk = Names<NameList>;
+
+using Table = grammar::Table<Command,
+    // CREATE USER alice
+    Row<CreateUserExecutor, Keyword<CREATE>, Space, Keyword<USER>, Space,
+        Field<&CreateUserCommand::username, Identifier>>,
+    // CREATE USERS alice,bob | CREATE USERS user[1..100]
+    Row<CreateUsersExecutor, Keyword<CREATE>, Space, Keyword<USERS>, Space,
+        Field<&CreateUsersCommand::names, Bulk>>,
+    // DELETE USER alice
+    Row<DeleteUserExecutor, Keyword<DELETE>, Space, Keyword<USER>, Space,
+        Field<&DeleteUserCommand::username, Identifier>>,
+    // DISABLE USER alice
+    Row<DisableUserExecutor, Keyword<DISABLE>, Space, Keyword<USER>, Space,
+        Field<&DisableUserCommand::username, Identifier>>,
+    // SEND MESSAGE alice "text"
+    Row<SendMessageExecutor, Keyword<SEND>, Space, Keyword<MESSAGE>, Space,
+        Field<&SendMessageCommand::username, Identifier>, Space,
+        Field<&SendMessageCommand::message, QuotedString>>,
+    // PING alice,bob 3 [SUMMARY]
+    Row<PingExecutor, Keyword<PING>, Space,
+        Field<&PingCommand::targets, IdentifierList<PingCommand::kMaxTargets>>, Space,
+        Field<&PingCommand::times, Number>,
+        Optional<Space, Keyword<SUMMARY>, Set<&PingCommand::summary>>>,
+    // ADD USER alice TO GROUP admins
+    Row<AddUserToGroupExecutor, Keyword<ADD>, Space, Keyword<USER>, Space,
+        Field<&AddUserToGroupCommand::username, Identifier>, Space, Keyword<TO>, Space, Keyword<GROUP>, Space,
+        Field<&AddUserToGroupCommand::group, Identifier>>,
+    // ADD USERS alice,bob TO GROUP admins
+    Row<AddUsersToGroupExecutor, Keyword<ADD>, Space, Keyword<USERS>, Space,
+        Field<&AddUsersToGroupCommand::names, Bulk>, Space, Keyword<TO>, Space, Keyword<GROUP>, Space,
+        Field<&AddUsersToGroupCommand::group, Identifier>>,
+    // REMOVE USER alice FROM GROUP admins
+    Row<RemoveUserFromGroupExecutor, Keyword<REMOVE>, Space, Keyword<USER>, Space,
+        Field<&RemoveUserFromGroupCommand::username, Identifier>, Space, Keyword<FROM>, Space, Keyword<GROUP>, Space,
+        Field<&RemoveUserFromGroupCommand::group, Identifier>>,
+    // GET USERS [WITH PREFIX al]
+    Row<GetUsersExecutor, Keyword<GET>, Space, Keyword<USERS>,
+        Optional<Space, Keyword<WITH>, Space, Keyword<PREFIX>, Space, Field<&GetUsersCommand::prefix, Identifier>>>,
+    // GET GROUPS
+    Row<GetGroupsExecutor, Keyword<GET>, Space, Keyword<GROUPS>>,
+    // GET MESSAGE HISTORY alice [FROM 10] [LIMIT 20]
+    Row<GetMessageHistoryExecutor, Keyword<GET>, Space, Keyword<MESSAGE>, Space, Keyword<HISTORY>, Space,
+        Field<&GetMessageHistoryCommand::username, Identifier>,
+        Optional<Space, Keyword<FROM>, Space, Field<&GetMessageHistoryCommand::from, Number>>,
+        Optional<Space, Keyword<LIMIT>, Space, Field<&GetMessageHistoryCommand::limit, Number>>>,
+    // EXIT
+    Row<ExitExecutor, Keyword<EXIT>>
+>;
+
+} // namespace command_table
+
+using CommandTable = command_table::Table;
+
+static_assert(CommandTable::complete(), "Every Command alternative needs exactly one row");
+
+/// @brief Default executor of each command type, bound at compile time by CommandRegistry
+template<typename T>
+struct ExecutorFor {
+    using type = typename CommandTable::RowFor<T>::Executor;
+};
+
+#endif // COMMANDS_TABLE_HPP
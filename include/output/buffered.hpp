@@ -0,0 +1,81 @@
+#ifndef OUTPUT_BUFFERED_HPP
+#define OUTPUT_BUFFERED_HPP
+
+// Standard Library
+#include <cstddef>       // For size_t
+#include <cstdint>       // For uint64_t
+#include <iterator>      // For std::back_inserter
+#include <string_view>   // For std::string_view
+#include <utility>       // For std::forward
+
+// Third Party
+#include <fmt/format.h>  // For fmt::memory_buffer, fmt::format_to
+
+// Project Headers
+#include "output/sink.hpp"  // For OutputSink
+
+/// @brief Appending buffer in front of an OutputSink
+///
+/// Text is formatted straight into the buffer and handed to the sink in
+/// blocks of about kBlockBytes (or the block size given); the rest goes
+/// out on flush() or destruction.
+class BufferedOutput {
+private:
+    OutputSink& sink;
+    fmt::memory_buffer data;
+    size_t blockBytes;
+    std::uint64_t flushed = 0;
+
+public:
+    static constexpr size_t kBlockBytes = size_t(256) << 10;
+
+    explicit BufferedOutput(OutputSink& sink, size_t blockBytes = kBlockBytes) : sink(sink), blockBytes(blockBytes) {
+        data.reserve(blockBytes);
+    }
+
+    ~BufferedOutput() {
+        try {
+            flush();
+        } catch (...) {
+            // Nowhere to report it from a destructor; call flush() to see errors
+        }
+    }
+
+    BufferedOutput(const BufferedOutput&) = delete;
+    BufferedOutput& operator=(const BufferedOutput&) = delete;
+
+    template<typename... Args>
+    void print(fmt::format_string<Args...> format, Args&&... args) {
+        fmt::format_to(std::back_inserter(data), format, std::forward<Args>(args)...);
+        commit();
+    }
+
+    void append(std::string_view text) {
+        data.append(text.data(), text.data() + text.size());
+        commit();
+    }
+
+    /// @brief Buffer to format into directly; call commit() afterwards
+    fmt::memory_buffer& buffer() { return data; }
+
+    /// @brief Hand the buffer to the sink once a full block has accumulated
+    void commit() {
+        if (data.size() >= blockBytes) {
+            flush();
+        }
+    }
+
+    /// @brief Bytes appended so far, whether handed to the sink yet or not
+    std::uint64_t written() const { return flushed + data.size(); }
+
+    /// @brief Hand everything buffered to the sink
+    void flush() {
+        if (data.size() > 0) {
+            sink.write(std::string_view(data.data(), data.size()));
+            flushed += data.size();
+            data.clear();
+        }
+    }
+};
+
+#endif // OUTPUT_BUFFERED_HPP
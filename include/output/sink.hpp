@@ -0,0 +1,104 @@
+#ifndef OUTPUT_SINK_HPP
+#define OUTPUT_SINK_HPP
+
+// Standard Library
+#include <cstddef>       // For size_t
+#include <string>        // For std::string
+#include <string_view>   // For std::string_view
+#include <utility>       // For std::move, std::exchange
+#include <vector>        // For std::vector
+
+/// @brief Destination of transcript bytes
+///
+/// Sinks receive large blocks from a BufferedOutput, never single lines.
+class OutputSink {
+public:
+    virtual ~OutputSink() = default;
+
+    /// @brief Write one block
+    virtual void write(std::string_view block) = 0;
+
+    /// @brief Write several blocks back to back, as one operation where possible
+    virtual void write(const std::vector<std::string_view>& blocks) {
+        for (auto block : blocks) {
+            write(block);
+        }
+    }
+};
+
+/// @brief Writes to a file descriptor with write(2)/writev(2)
+class FileSink : public OutputSink {
+private:
+    int fd;
+    bool owned;
+
+    FileSink(int fd, bool owned) : fd(fd), owned(owned) {}
+
+public:
+    /// @brief What happens to the file at the path if it exists already
+    enum class Mode { Truncate, Append };
+
+    /// @brief Create the file at path, or open it in the given mode
+    /// @throws std::runtime_error if the file cannot be opened
+    explicit FileSink(const std::string& path, Mode mode = Mode::Truncate);
+    ~FileSink() override;
+
+    FileSink(const FileSink&) = delete;
+    FileSink& operator=(const FileSink&) = delete;
+
+    /// @brief Sink on the process's standard output
+    static FileSink& standardOutput();
+
+    /// @throws std::runtime_error if the descriptor rejects the write
+    void write(std::string_view block) override;
+    void write(const std::vector<std::string_view>& blocks) override;
+
+    /// @brief Return once everything written has reached the storage device
+    /// @throws std::runtime_error if the device reports an error
+    void sync();
+};
+
+/// @brief Discards everything
+class NullSink : public OutputSink {
+public:
+    void write(std::string_view) override {}
+    void write(const std::vector<std::string_view>&) override {}
+};
+
+/// @brief Collects everything in memory
+///
+/// Bytes can be taken off the front with discard(), say as they are sent;
+/// the buffer is compacted only once they are half of it, so draining it
+/// in small pieces stays linear.
+class MemorySink : public OutputSink {
+private:
+    std::string data;
+    size_t start = 0;   // Bytes of data discarded
+
+public:
+    void write(std::string_view block) override { data.append(block); }
+
+    /// @brief Everything written and not discarded
+    std::string_view contents() const { return std::string_view(data).substr(start); }
+
+    std::string take() {
+        data.erase(0, std::exchange(start, 0));
+        return std::move(data);
+    }
+
+    /// @brief Drop the first count bytes of contents()
+    void discard(size_t count) {
+        start += count;
+        if (start == data.size()) {
+            data.clear();
+            start = 0;
+        } else if (start > data.size() / 2) {
+            data.erase(0, std::exchange(start, 0));
+        }
+    }
+
+    /// @brief Bytes held, discarded ones not yet compacted away included
+    size_t retained() const { return data.size(); }
+};
+
+#endif // OUTPUT_SINK_HPP
@@ -0,0 +1,48 @@
+#ifndef PARSER_CHARS_HPP
+#define PARSER_CHARS_HPP
+
+// Standard Library
+#include <array>
+#include <cstdint>
+
+/// @brief Character classes of the task grammar, as in the "C" locale
+///
+/// A table lookup per byte instead of a call into <cctype>, which consults
+/// the current locale and is undefined for negative chars; bytes outside
+/// ASCII belong to no class.
+namespace chars {
+
+enum Class : std::uint8_t {
+    Space = 1 << 0,   // ' ', \t, \n, \v, \f, \r
+    Alpha = 1 << 1,   // A-Z, a-z
+    Digit = 1 << 2,   // 0-9
+    Word = 1 << 3,    // Alpha, Digit or '_'
+};
+
+inline constexpr std::array<std::uint8_t, 256> kClasses = [] {
+    std::array<std::uint8_t, 256> classes{};
+    for (char c : {' ', '\t', '\n', '\v', '\f', '\r'}) {
+        classes[static_cast<unsigned char>(c)] = Space;
+    }
+    for (int c = 'A'; c <= 'Z'; ++c) {
+        classes[c] = classes[c - 'A' + 'a'] = Alpha | Word;
+    }
+    for (int c = '0'; c <= '9'; ++c) {
+        classes[c] = Digit | Word;
+    }
+    classes['_'] = Word;
+    return classes;
+}();
+
+constexpr bool is(char c, Class cls) {
+    return (kClasses[static_cast<unsigned char>(c)] & cls) != 0;
+}
+
+constexpr bool isSpace(char c) { return is(c, Space); }
+constexpr bool isAlpha(char c) { return is(c, Alpha); }
+constexpr bool isDigit(char c) { return is(c, Digit); }
+constexpr bool isWord(char c) { return is(c, Word); }
+
+} // namespace chars
+
+#endif // PARSER_CHARS_HPP
@@ -0,0 +1,617 @@
+#ifndef PARSER_GRAMMAR_HPP
+#define PARSER_GRAMMAR_HPP
+
+// Standard Library
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+// Project headers
+#include "parser/chars.hpp"
+#include "util/bits.hpp"
+
+/// @brief Declarative line grammars, turned into parsers by the compiler
+///
+/// A command's syntax is a type: a Row listing the parts of its line in
+/// order, such as
+///
+///     Row<CreateUserExecutor, Keyword<CREATE>, Space, Keyword<USER>, Space,
+///         Field<&CreateUserCommand::username, Identifier>>
+///
+/// Every part has a static match(line, position, command, errors) that
+/// advances the position on success, so a row compiles to straight-line code
+/// with no allocation. The line is a std::string_view, read a byte at a
+/// time, or a Line carrying the token masks of its scan. A Table of rows picks the rows to try by the leading
+/// verb through a perfect hash laid out at compile time, and calls each
+/// through a table of function pointers.
+///
+/// Parts report what they expected where they failed to errors: NoErrors
+/// drops the reports and compiles to nothing, Failure keeps the furthest
+/// ones for a diagnostic.
+namespace grammar {
+
+/// @brief Kinds of token a failed part expected, besides literal words
+enum Expect : std::uint16_t {
+    Whitespace = 1 << 0,
+    Name = 1 << 1,
+    Quoted = 1 << 2,
+    ClosingQuote = 1 << 3,
+    Digits = 1 << 4,
+    FewerNames = 1 << 5,
+    EndOfLine = 1 << 6,
+    SmallerRange = 1 << 7,
+    AscendingRange = 1 << 8,
+    SmallerNumber = 1 << 9,
+};
+
+/// @brief Error channel of the hot path: records nothing
+struct NoErrors {
+    void expect(size_t, Expect) {}
+    void expect(size_t, std::string_view) {}
+};
+
+/// @brief The furthest position any part failed at, and what the parts
+///        failing there expected
+///
+/// Reports at an earlier position are dropped and a later one replaces the
+/// set, so the alternatives of a line merge in fixed space.
+class Failure {
+public:
+    static constexpr size_t kMaxWords = 16;
+
+    void expect(size_t position, Expect kind) {
+        if (reach(position)) {
+            expectedKinds |= kind;
+        }
+    }
+
+    void expect(size_t position, std::string_view word) {
+        if (!reach(position) || wordCount == kMaxWords) {
+            return;
+        }
+        for (size_t i = 0; i < wordCount; ++i) {
+            if (expectedWords[i] == word) {
+                return;
+            }
+        }
+        expectedWords[wordCount++] = word;
+    }
+
+    bool empty() const { return expectedKinds == 0 && wordCount == 0; }
+    size_t position() const { return at; }
+    std::uint16_t kinds() const { return expectedKinds; }
+    /// @brief Literal words expected, in the order first reported
+    const std::string_view* wordsBegin() const { return expectedWords.data(); }
+    const std::string_view* wordsEnd() const { return expectedWords.data() + wordCount; }
+
+private:
+    size_t at = 0;
+    std::uint16_t expectedKinds = 0;
+    std::array<std::string_view, kMaxWords> expectedWords{};
+    size_t wordCount = 0;
+
+    bool reach(size_t position) {
+        if (position < at) {
+            return false;
+        }
+        if (position > at) {
+            at = position;
+            expectedKinds = 0;
+            wordCount = 0;
+        }
+        return true;
+    }
+};
+
+/// @brief A line with bit masks of its whitespace, word characters and
+///        quotes, made by the scan that found it
+///
+/// Bit offset + i of a mask (bit % 64 of word / 64) stands for byte i of
+/// the line (see TextTokens), so Space, Identifier and QuotedString find
+/// the end of their token a word at a time instead of testing each byte.
+class Line {
+public:
+    /// @pre the masks have a bit for every byte of text, from bit offset on
+    Line(std::string_view text, const std::uint64_t* spaces, const std::uint64_t* words, const std::uint64_t* quotes,
+         size_t offset)
+        : text(text), spaces(spaces), words(words), quotes(quotes), offset(offset) {}
+
+    std::string_view view() const { return text; }
+    size_t size() const { return text.size(); }
+    const char* data() const { return text.data(); }
+    char operator[](size_t i) const { return text[i]; }
+    std::string_view substr(size_t position, size_t count = std::string_view::npos) const {
+        return text.substr(position, count);
+    }
+
+    size_t endOfSpace(size_t i) const { return find(spaces, i, ~std::uint64_t(0)); }
+    size_t endOfWord(size_t i) const { return find(words, i, ~std::uint64_t(0)); }
+    size_t nextQuote(size_t i) const { return find(quotes, i, 0); }
+
+private:
+    std::string_view text;
+    const std::uint64_t* spaces;
+    const std::uint64_t* words;
+    const std::uint64_t* quotes;
+    size_t offset;
+
+    /// @brief First byte at or after i whose bit in mask, flipped, is set;
+    ///        size() if there is none in the line
+    size_t find(const std::uint64_t* mask, size_t i, std::uint64_t flip) const {
+        if (i >= text.size()) {
+            return text.size();
+        }
+        // Most tokens end within the word they start in
+        size_t bit = offset + i;
+        size_t w = bit / 64;
+        std::uint64_t candidates = (mask[w] ^ flip) >> (bit % 64);
+        if (candidates != 0) {
+            return std::min(i + bits::lowest(candidates), text.size());
+        }
+        for (size_t end = offset + text.size(); ++w * 64 < end;) {
+            candidates = mask[w] ^ flip;
+            if (candidates != 0) {
+                return std::min(w * 64 + bits::lowest(candidates) - offset, text.size());
+            }
+        }
+        return text.size();
+    }
+};
+
+// Token ends, on a plain line a byte at a time and on a Line from its masks
+
+/// @brief Where the whitespace starting at i ends
+inline size_t endOfSpace(std::string_view s, size_t i) {
+    while (i < s.size() && chars::isSpace(s[i])) {
+        ++i;
+    }
+    return i;
+}
+
+inline size_t endOfSpace(const Line& s, size_t i) { return s.endOfSpace(i); }
+
+/// @brief Where the word characters (chars::Word) starting at i end
+inline size_t endOfWord(std::string_view s, size_t i) {
+    while (i < s.size() && chars::isWord(s[i])) {
+        ++i;
+    }
+    return i;
+}
+
+inline size_t endOfWord(const Line& s, size_t i) { return s.endOfWord(i); }
+
+/// @brief The first `"` at or after i; size() if there is none
+inline size_t nextQuote(std::string_view s, size_t i) { return std::min(s.find('"', i), s.size()); }
+
+inline size_t nextQuote(const Line& s, size_t i) { return s.nextQuote(i); }
+
+// Argument kinds: read(line, position, value) parses one value at position
+
+/// @brief A letter followed by letters, digits and underscores
+struct Identifier {
+    using type = std::string_view;
+
+    template<typename Text, typename Errors>
+    static bool read(const Text& s, size_t& i, std::string_view& value, Errors& errors) {
+        if (i >= s.size() || !chars::isAlpha(s[i])) {
+            errors.expect(i, Name);
+            return false;
+        }
+        size_t start = i;
+        i = endOfWord(s, i + 1);
+        value = s.substr(start, i - start);
+        return true;
+    }
+};
+
+/// @brief Text between double quotes, without them; may be empty
+struct QuotedString {
+    using type = std::string_view;
+
+    template<typename Text, typename Errors>
+    static bool read(const Text& s, size_t& i, std::string_view& value, Errors& errors) {
+        if (i >= s.size() || s[i] != '"') {
+            errors.expect(i, Quoted);
+            return false;
+        }
+        size_t close = nextQuote(s, i + 1);
+        if (close == s.size()) {
+            errors.expect(s.size(), ClosingQuote);
+            return false;
+        }
+        value = s.substr(i + 1, close - i - 1);
+        i = close + 1;
+        return true;
+    }
+};
+
+/// @brief Decimal digits of a value that fits an int
+struct Number {
+    using type = std::int32_t;
+
+    template<typename Text, typename Errors>
+    static bool read(const Text& s, size_t& i, std::int32_t& value, Errors& errors) {
+        size_t start = i;
+        while (i < s.size() && chars::isDigit(s[i])) {
+            ++i;
+        }
+        if (i == start) {
+            errors.expect(i, Digits);
+            return false;
+        }
+        std::int32_t parsed = 0;
+        if (std::from_chars(s.data() + start, s.data() + i, parsed).ec != std::errc()) {
+            errors.expect(start, SmallerNumber);
+            return false;
+        }
+        value = parsed;
+        return true;
+    }
+};
+
+/// @brief Up to MaxCount identifiers separated by commas, as one view
+template<size_t MaxCount>
+struct IdentifierList {
+    using type = std::string_view;
+
+    template<typename Text, typename Errors>
+    static bool read(const Text& s, size_t& i, std::string_view& value, Errors& errors) {
+        size_t start = i;
+        std::string_view name;
+        for (size_t count = 1;; ++count) {
+            size_t nameStart = i;
+            if (!Identifier::read(s, i, name, errors)) {
+                return false;
+            }
+            if (count > MaxCount) {
+                errors.expect(nameStart, FewerNames);
+                return false;
+            }
+            if (i >= s.size() || s[i] != ',') {
+                errors.expect(i, ",");
+                value = s.substr(start, i - start);
+                return true;
+            }
+            ++i;
+        }
+    }
+};
+
+/// @brief Names of a bulk command: prefix[first..last], with first <= last
+///        and at most kMaxRangeNames names, or a list
+template<typename NameListType>
+struct Names {
+    using type = NameListType;
+
+    template<typename Text, typename Errors>
+    static bool read(const Text& s, size_t& i, NameListType& value, Errors& errors) {
+        size_t j = i;
+        std::string_view prefix;
+        std::int32_t first = 0;
+        std::int32_t last = 0;
+        if (Identifier::read(s, j, prefix, errors) && literal(s, j, "[", errors) && Number::read(s, j, first, errors) &&
+            literal(s, j, "..", errors)) {
+            size_t lastStart = j;
+            if (Number::read(s, j, last, errors) && literal(s, j, "]", errors)) {
+                value = NameListType{prefix, true, first, last};
+                if (first > last) {
+                    errors.expect(lastStart, AscendingRange);
+                    return false;
+                }
+                if (value.count() > NameListType::kMaxRangeNames) {
+                    errors.expect(lastStart, SmallerRange);
+                    return false;
+                }
+                i = j;
+                return true;
+            }
+        }
+        std::string_view list;
+        if (!IdentifierList<std::numeric_limits<size_t>::max()>::read(s, i, list, errors)) {
+            return false;
+        }
+        value = NameListType{list};
+        return true;
+    }
+
+private:
+    template<typename Text, typename Errors>
+    static bool literal(const Text& s, size_t& i, std::string_view text, Errors& errors) {
+        if (s.substr(i, text.size()) != text) {
+            errors.expect(i, text);
+            return false;
+        }
+        i += text.size();
+        return true;
+    }
+};
+
+// Parts of a row: match(line, position, command, errors)
+
+/// @brief The exact word Word, which must have static storage
+template<const char* Word>
+struct Keyword {
+    static constexpr std::string_view word{Word};
+
+    template<typename Text, typename T, typename Errors>
+    static bool match(const Text& s, size_t& i, T&, Errors& errors) {
+        if (s.substr(i, word.size()) != word) {
+            errors.expect(i, word);
+            return false;
+        }
+        i += word.size();
+        return true;
+    }
+};
+
+/// @brief One or more whitespace characters
+struct Space {
+    template<typename Text, typename T, typename Errors>
+    static bool match(const Text& s, size_t& i, T&, Errors& errors) {
+        size_t start = i;
+        i = endOfSpace(s, i);
+        if (i == start) {
+            errors.expect(i, Whitespace);
+            return false;
+        }
+        return true;
+    }
+};
+
+/// @brief An argument of kind Kind, stored in the command's Member
+template<auto Member, typename Kind>
+struct Field {
+    template<typename Text, typename T, typename Errors>
+    static bool match(const Text& s, size_t& i, T& command, Errors& errors) {
+        typename Kind::type value{};
+        if (!Kind::read(s, i, value, errors)) {
+            return false;
+        }
+        command.*Member = value;
+        return true;
+    }
+};
+
+/// @brief Sets the command's bool Member; always matches
+template<auto Member>
+struct Set {
+    template<typename Text, typename T, typename Errors>
+    static bool match(const Text&, size_t&, T& command, Errors&) {
+        command.*Member = true;
+        return true;
+    }
+};
+
+/// @brief Report what Next expects at i, leaving i and the command alone
+template<typename Next, typename... Rest, typename Text, typename T, typename Errors>
+void probeFirst(const Text& s, size_t i, const T& command, Errors& errors) {
+    T scratch = command;
+    Next::match(s, i, scratch, errors);
+}
+
+/// @brief Match Part and then Rest in order
+///
+/// Task lines are trimmed, so a line that stops short always fails on a
+/// Space at its end. The part after that Space is then probed there too, so
+/// the diagnosis names what was left out, not just the whitespace before it.
+template<typename Part, typename... Rest, typename Text, typename T, typename Errors>
+bool matchParts(const Text& s, size_t& i, T& command, Errors& errors) {
+    if (!Part::match(s, i, command, errors)) {
+        if constexpr (std::is_same_v<Part, Space> && sizeof...(Rest) > 0 && !std::is_same_v<Errors, NoErrors>) {
+            if (i == s.size()) {
+                probeFirst<Rest...>(s, i, command, errors);
+            }
+        }
+        return false;
+    }
+    if constexpr (sizeof...(Rest) > 0) {
+        return matchParts<Rest...>(s, i, command, errors);
+    } else {
+        return true;
+    }
+}
+
+/// @brief Parts that may be left out as a whole
+///
+/// If any of them does not match, the position and the command are left as
+/// they were before the first.
+template<typename... Parts>
+struct Optional {
+    template<typename Text, typename T, typename Errors>
+    static bool match(const Text& s, size_t& i, T& command, Errors& errors) {
+        size_t j = i;
+        T saved = command;
+        if (matchParts<Parts...>(s, j, command, errors)) {
+            i = j;
+        } else {
+            command = saved;
+        }
+        return true;
+    }
+};
+
+/// @brief The syntax of one command, run by Executor
+///
+/// The command type is Executor::CommandType; the first part must be a
+/// Keyword, the verb the table dispatches on.
+template<typename ExecutorType, typename FirstPart, typename... Parts>
+struct Row {
+    using Executor = ExecutorType;
+    using Command = typename Executor::CommandType;
+    static constexpr std::string_view verb = FirstPart::word;
+
+    /// @brief Match the row at the start of s, returning where it ended
+    template<typename Text, typename Errors>
+    static std::optional<size_t> match(const Text& s, Command& command, Errors& errors) {
+        size_t i = 0;
+        if (matchParts<FirstPart, Parts...>(s, i, command, errors)) {
+            return i;
+        }
+        return std::nullopt;
+    }
+};
+
+namespace detail {
+
+/// @brief Position of T in Ts; past the end unless it is there exactly once
+template<typename T, typename... Ts>
+constexpr size_t indexOf() {
+    constexpr bool matches[] = {std::is_same_v<T, Ts>...};
+    size_t found = sizeof...(Ts);
+    for (size_t i = 0; i < sizeof...(Ts); ++i) {
+        if (matches[i]) {
+            found = found == sizeof...(Ts) ? i : sizeof...(Ts) + 1;
+        }
+    }
+    return found;
+}
+
+constexpr std::uint64_t hash(std::string_view verb, std::uint64_t seed) {
+    // FNV-1a, seeded so makeLayout() can search for a collision-free layout
+    std::uint64_t h = 14695981039346656037ull ^ (seed * 0x9e3779b97f4a7c15ull);
+    for (char c : verb) {
+        h ^= static_cast<unsigned char>(c);
+        h *= 1099511628211ull;
+    }
+    return h ^ (h >> 29);
+}
+
+constexpr size_t kMaxSlots = 128;
+
+struct VerbSlot {
+    std::string_view verb;
+    std::uint32_t rows = 0;      // Bit i set: row i starts with verb
+};
+
+struct VerbLayout {
+    std::array<VerbSlot, kMaxSlots> slots{};
+    std::uint64_t seed = 0;
+    size_t mask = 0;
+    bool found = false;
+};
+
+/// @brief The smallest power-of-two table, and a seed, giving every verb its own slot
+template<typename Verbs>
+constexpr VerbLayout makeLayout(const Verbs& verbs) {
+    for (size_t size = 8; size <= kMaxSlots; size *= 2) {
+        for (std::uint64_t seed = 0; seed < 256; ++seed) {
+            VerbLayout layout;
+            layout.seed = seed;
+            layout.mask = size - 1;
+            layout.found = true;
+            for (size_t row = 0; row < verbs.size() && layout.found; ++row) {
+                VerbSlot& slot = layout.slots[hash(verbs[row], seed) & layout.mask];
+                if (slot.rows != 0 && slot.verb != verbs[row]) {
+                    layout.found = false;
+                }
+                slot.verb = verbs[row];
+                slot.rows |= std::uint32_t(1) << row;
+            }
+            if (layout.found) {
+                return layout;
+            }
+        }
+    }
+    return VerbLayout{};
+}
+
+} // namespace detail
+
+/// @brief Rows producing alternatives of Variant, tried in the order given
+///
+/// Rows sharing a verb are tried in order and the first that matches
+/// decides the line, which must then end where the row did.
+template<typename Variant, typename... Rows>
+class Table {
+public:
+    static constexpr size_t kRows = sizeof...(Rows);
+    static_assert(kRows <= 32, "Verb slots hold a 32-bit row mask");
+
+    /// @brief The row of command T, which must have exactly one
+    template<typename T>
+    using RowFor = std::tuple_element_t<detail::indexOf<T, typename Rows::Command...>(), std::tuple<Rows...>>;
+
+    /// @brief Whether every alternative of Variant has exactly one row
+    static constexpr bool complete() {
+        return completeFor(std::make_index_sequence<std::variant_size_v<Variant>>{});
+    }
+
+    /// @brief Parse a whole line; std::nullopt if no row matches all of it
+    template<typename Text>
+    static std::optional<Variant> parse(const Text& line) {
+        NoErrors none;
+        return parse(line, none);
+    }
+
+    /// @brief Parse a whole line, reporting what was expected where it failed
+    template<typename Text, typename Errors>
+    static std::optional<Variant> parse(const Text& line, Errors& errors) {
+        std::string_view verb = line.substr(0, endOfWord(line, 0));
+        const auto& slot = kLayout.slots[detail::hash(verb, kLayout.seed) & kLayout.mask];
+        if (verb.empty() || slot.verb != verb) {
+            (errors.expect(0, Rows::verb), ...);
+            return std::nullopt;
+        }
+        return tryRows(line, slot.rows, errors, std::index_sequence_for<Rows...>{});
+    }
+
+private:
+    static constexpr auto kLayout = detail::makeLayout(std::array<std::string_view, kRows>{Rows::verb...});
+    static_assert(kLayout.found, "No collision-free layout for the verbs");
+
+    template<size_t... I>
+    static constexpr bool completeFor(std::index_sequence<I...>) {
+        return sizeof...(I) == kRows &&
+               ((detail::indexOf<std::variant_alternative_t<I, Variant>, typename Rows::Command...>() < kRows) && ...);
+    }
+
+    /// @brief Whether row I matched the start of the line; it then set
+    ///        result if it matched all of it
+    template<size_t I, typename Text, typename Errors>
+    static bool tryRow(const Text& line, Errors& errors, std::optional<Variant>& result) {
+        using Row = std::tuple_element_t<I, std::tuple<Rows...>>;
+        typename Row::Command command{};
+        // A copy of its own, which the parts' positions cannot alias
+        const Text text = line;
+        auto end = Row::match(text, command, errors);
+        if (!end) {
+            return false;
+        }
+        // The first matching row decides, even if the line goes on
+        if (*end == line.size()) {
+            result.emplace(std::in_place_type<typename Row::Command>, command);
+        } else {
+            errors.expect(*end, EndOfLine);
+        }
+        return true;
+    }
+
+    template<typename Text, typename Errors, size_t... I>
+    static std::optional<Variant> tryRows(const Text& line, std::uint32_t rows, Errors& errors,
+                                          std::index_sequence<I...>) {
+        // Called through pointers so that each row is compiled on its own
+        // rather than all of them inlined into one function
+        using RowParser = bool (*)(const Text&, Errors&, std::optional<Variant>&);
+        static constexpr RowParser parsers[] = {&tryRow<I, Text, Errors>...};
+        std::optional<Variant> result;
+        for (; rows != 0; rows &= rows - 1) {
+            if (parsers[bits::lowest(rows)](line, errors, result)) {
+                break;
+            }
+        }
+        return result;
+    }
+};
+
+} // namespace grammar
+
+#endif // PARSER_GRAMMAR_HPP
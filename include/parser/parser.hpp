@@ -2,50 +2,45 @@
 #define PARSER_PARSER_HPP
 
 // Standard Library
-#include <algorithm>
-#include <cctype>
-#include <functional>
-#include <memory>
+#include <optional>
 #include <string>
 #include <string_view>
-#include <tuple>
-#include <type_traits>
-#include <utility>
-#include <variant>
-
-// Third-party
-#include <fmt/format.h>
-#include <parsec/parsec.hpp>
 
 // Project headers
 #include "commands/command.hpp"
 
-class CommandParser {
-private:
-    // Basic parsers
-    static parsec::Parser<char> character(char c);
-    static parsec::Parser<std::string> whitespace();
-    static parsec::Parser<std::string> identifier();
-    static parsec::Parser<std::string> quotedString();
-    static parsec::Parser<int> number();
-    static parsec::Parser<std::string> keyword(const std::string& word);
+namespace grammar {
+class Line;
+}
 
+/// @brief Parses task lines with the grammar of CommandTable
+///
+/// The parser is generated from the table at compile time: there is no
+/// state to build or share, and it can be called concurrently from any
+/// number of threads.
+class CommandParser {
 public:
-    static parsec::Parser<Command> commandParser();
+    /// @brief Parse one line, trimmed and without its comment
+    /// @return The command, or std::nullopt if the line is not one (a
+    ///         number too large for an int included)
+    static std::optional<Command> parse(std::string_view line);
+
+    /// @brief Parse one line with the token masks its scan found (see TaskSource)
+    static std::optional<Command> parse(const grammar::Line& line);
 
-private:
-    // Command-specific parsers
-    static parsec::Parser<Command> createUserParser();
-    static parsec::Parser<Command> deleteUserParser();
-    static parsec::Parser<Command> disableUserParser();
-    static parsec::Parser<Command> sendMessageParser();
-    static parsec::Parser<Command> pingParser();
-    static parsec::Parser<Command> addUserToGroupParser();
-    static parsec::Parser<Command> removeUserFromGroupParser();
-    static parsec::Parser<Command> getUsersParser();
-    static parsec::Parser<Command> getGroupsParser();
-    static parsec::Parser<Command> getMessageHistoryParser();
-    static parsec::Parser<Command> exitParser();
+    /// @brief Explain why a line does not parse
+    ///
+    /// The line is parsed again, this time noting the furthest position a
+    /// part of the grammar failed at and what it expected there; only lines
+    /// that already failed pay for it. The result is the line and a caret
+    /// under that position, e.g.
+    ///
+    ///        ADD USER alice TO GRUP admins
+    ///                          ^ column 19: expected GROUP
+    ///
+    /// each indented by three spaces and ending in a newline, or empty if
+    /// the line parses.
+    static std::string diagnose(std::string_view line);
 };
 
-#endif // PARSER_PARSER_HPP
\ No newline at end of file
+#endif // PARSER_PARSER_HPP
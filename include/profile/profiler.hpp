@@ -0,0 +1,205 @@
+#ifndef PROFILE_PROFILER_HPP
+#define PROFILE_PROFILER_HPP
+
+// Opt-in instrumentation of task processing
+//
+// Configure with -DENABLE_INSTRUMENTATION=ON to define WZH_INSTRUMENTATION.
+// Without it the WZH_PROFILE_* macros below expand to nothing and none of
+// the classes exist, so an ordinary build carries no trace of them.
+
+#if WZH_INSTRUMENTATION
+
+// Standard Library
+#include <array>         // For std::array
+#include <chrono>        // For std::chrono::steady_clock
+#include <cstddef>       // For size_t
+#include <cstdint>       // For uint64_t
+#include <string>        // For std::string
+#include <variant>       // For std::variant_size_v
+#include <vector>        // For std::vector
+
+// Project Headers
+#include "commands/command.hpp"   // For Command
+#include "util/bits.hpp"          // For bits::highest
+
+/// @brief Stages timed on every line
+enum class Phase : std::uint8_t {
+    Task,      // A whole task, including everything below
+    Read,      // Scanning the next line or decoding the next compiled entry
+    Parse,
+    Execute,
+    Render,
+    Write,     // Handing output to a file
+};
+
+constexpr size_t kPhaseCount = 6;
+constexpr size_t kProfiledCommands = std::variant_size_v<Command>;
+
+/// @brief Log-bucketed latency histogram in nanoseconds
+///
+/// Values below 8 have a bucket each; above, every power of two is split
+/// into 8 sub-buckets, so a reported percentile is within 12.5% of the
+/// true value at any magnitude (the HDR histogram layout with 3 bits of
+/// precision).
+class LatencyHistogram {
+public:
+    static constexpr unsigned kSubBucketBits = 3;
+    static constexpr size_t kSubBuckets = size_t(1) << kSubBucketBits;
+    static constexpr size_t kBuckets = (64 - kSubBucketBits + 1) * kSubBuckets;
+
+    void record(std::uint64_t nanos) {
+        ++counts[bucketOf(nanos)];
+        ++total;
+        sum += nanos;
+        if (nanos > maximum) {
+            maximum = nanos;
+        }
+    }
+
+    void merge(const LatencyHistogram& other);
+
+    std::uint64_t count() const { return total; }
+    std::uint64_t totalNanos() const { return sum; }
+    std::uint64_t max() const { return maximum; }
+
+    /// @brief Highest value of the bucket holding the given fraction (0..1)
+    ///        of the recorded values, never above max()
+    std::uint64_t percentile(double fraction) const;
+
+    static size_t bucketOf(std::uint64_t nanos) {
+        if (nanos < kSubBuckets) {
+            return static_cast<size_t>(nanos);
+        }
+        unsigned exponent = bits::highest(nanos);
+        unsigned shift = exponent - kSubBucketBits;
+        return kSubBuckets * (shift + 1) + static_cast<size_t>((nanos >> shift) - kSubBuckets);
+    }
+
+private:
+    std::array<std::uint64_t, kBuckets> counts{};
+    std::uint64_t total = 0;
+    std::uint64_t sum = 0;
+    std::uint64_t maximum = 0;
+};
+
+/// @brief Completed span for the Chrome trace-event dump
+struct TraceEvent {
+    const char* name;
+    const char* category;
+    std::uint64_t start;      // Nanoseconds since the profiler started
+    std::uint64_t duration;
+    std::string detail;       // Task file name, empty otherwise
+};
+
+/// @brief Everything one thread has recorded
+///
+/// Only its thread writes to it, so recording takes no lock.
+struct ThreadProfile {
+    /// @brief Trace events kept per thread; later ones are counted as dropped
+    static constexpr size_t kMaxTraceEvents = size_t(1) << 20;
+
+    std::uint32_t thread = 0;
+    std::array<LatencyHistogram, kPhaseCount> phases;
+    std::array<LatencyHistogram, kProfiledCommands> commands;
+    std::vector<TraceEvent> events;
+    std::uint64_t droppedEvents = 0;
+
+    void trace(const char* name, const char* category, std::uint64_t start, std::uint64_t duration,
+               const std::string* detail = nullptr);
+};
+
+/// @brief Process-wide collection of the per-thread profiles
+///
+/// Threads record into their own ThreadProfile; report() and writeTrace()
+/// merge them and must only be called while no thread is recording (after
+/// processTasks() has returned). A profile outlives its thread and is
+/// reused by the next thread to start, so short-lived pipeline threads do
+/// not pile up.
+class Profiler {
+public:
+    /// @brief Nanoseconds since the profiler started
+    static std::uint64_t now() {
+        return static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch())
+                .count());
+    }
+
+    /// @brief Profile of the calling thread
+    static ThreadProfile& local();
+
+    /// @brief Keep trace events from now on (off by default: only histograms are kept)
+    static void enableTrace();
+    static bool tracing();
+
+    /// @brief Per-phase and per-command table over every thread
+    static std::string report();
+
+    /// @brief Write the trace events as Chrome trace-event JSON (viewable in Perfetto)
+    /// @throws std::runtime_error if the file cannot be written
+    static void writeTrace(const std::string& filename);
+
+private:
+    static std::chrono::steady_clock::time_point epoch();
+};
+
+/// @brief Times a scope as one Phase of the calling thread
+class PhaseTimer {
+private:
+    ThreadProfile& profile;
+    Phase phase;
+    std::uint64_t start;
+
+public:
+    explicit PhaseTimer(Phase phase) : profile(Profiler::local()), phase(phase), start(Profiler::now()) {}
+    ~PhaseTimer();
+
+    PhaseTimer(const PhaseTimer&) = delete;
+    PhaseTimer& operator=(const PhaseTimer&) = delete;
+};
+
+/// @brief Times a scope as the execution of the Command alternative at index
+class CommandTimer {
+private:
+    ThreadProfile& profile;
+    size_t index;
+    std::uint64_t start;
+
+public:
+    explicit CommandTimer(size_t index) : profile(Profiler::local()), index(index), start(Profiler::now()) {}
+    ~CommandTimer();
+
+    CommandTimer(const CommandTimer&) = delete;
+    CommandTimer& operator=(const CommandTimer&) = delete;
+};
+
+/// @brief Times a scope as Phase::Task, labelled with the task file
+class TaskTimer {
+private:
+    ThreadProfile& profile;
+    const std::string& filename;
+    std::uint64_t start;
+
+public:
+    explicit TaskTimer(const std::string& filename)
+        : profile(Profiler::local()), filename(filename), start(Profiler::now()) {}
+    ~TaskTimer();
+
+    TaskTimer(const TaskTimer&) = delete;
+    TaskTimer& operator=(const TaskTimer&) = delete;
+};
+
+#define WZH_PROFILE_CONCAT_(a, b) a##b
+#define WZH_PROFILE_CONCAT(a, b) WZH_PROFILE_CONCAT_(a, b)
+#define WZH_PROFILE_PHASE(phase) PhaseTimer WZH_PROFILE_CONCAT(profilePhase, __LINE__)(phase)
+#define WZH_PROFILE_COMMAND(index) CommandTimer WZH_PROFILE_CONCAT(profileCommand, __LINE__)(index)
+#define WZH_PROFILE_TASK(filename) TaskTimer WZH_PROFILE_CONCAT(profileTask, __LINE__)(filename)
+
+#else
+
+#define WZH_PROFILE_PHASE(phase) ((void)0)
+#define WZH_PROFILE_COMMAND(index) ((void)0)
+#define WZH_PROFILE_TASK(filename) ((void)0)
+
+#endif // WZH_INSTRUMENTATION
+
+#endif // PROFILE_PROFILER_HPP
@@ -2,37 +2,101 @@
 #define REGISTRY_REGISTRY_HPP
 
 // Standard Library
-#include <memory>              // For std::unique_ptr
-#include <typeindex>          // For std::type_index
-#include <typeinfo>           // For typeid()
-#include <unordered_map>      // For std::unordered_map
-#include <utility>            // For std::move
+#include <array>              // For std::array
+#include <cstddef>            // For size_t
+#include <memory>             // For std::unique_ptr
+#include <type_traits>        // For std::is_same_v
+#include <utility>            // For std::move, std::index_sequence
+#include <variant>            // For std::variant_size_v
 
 // Project Headers
 #include "commands/command.hpp"       // For Command type
 #include "commands/executor.hpp"      // For CommandExecutor
+#include "commands/table.hpp"         // For ExecutorFor
+#include "profile/profiler.hpp"       // For WZH_PROFILE_COMMAND
+#include "user/concurrent.hpp"        // For ConcurrentUserManager
 #include "user/manager.hpp"           // For UserManager
 
+/// @brief Position of T among the alternatives of Command
+template<typename T, size_t I = 0>
+constexpr size_t commandIndex() {
+    static_assert(I < std::variant_size_v<Command>, "Type is not a Command alternative");
+    if constexpr (std::is_same_v<std::variant_alternative_t<I, Command>, T>) {
+        return I;
+    } else {
+        return commandIndex<T, I + 1>();
+    }
+}
+
 // Command registry for extensibility
+//
+// Every Command alternative is bound at compile time to ExecutorFor<T>::type,
+// the executor of its row in CommandTable, whose typed run() is called
+// through a table indexed by Command::index().
+// registerExecutor<T>() installs a runtime override that takes precedence.
 class CommandRegistry {
 private:
-    std::unordered_map<std::type_index, std::unique_ptr<CommandExecutor>> executors;
+    static constexpr size_t kCommandCount = std::variant_size_v<Command>;
+
+    template<typename Users>
+    using Handler = CommandResult (*)(const Command&, Users&);
+
+    std::array<std::unique_ptr<CommandExecutor>, kCommandCount> overrides;
+    bool hasOverrides = false;
+
+    template<typename Users, size_t I>
+    static CommandResult invoke(const Command& cmd, Users& users) {
+        using T = std::variant_alternative_t<I, Command>;
+        return ExecutorFor<T>::type::run(*std::get_if<I>(&cmd), users);
+    }
+
+    template<typename Users, size_t... I>
+    static constexpr std::array<Handler<Users>, kCommandCount> makeHandlers(std::index_sequence<I...>) {
+        return {&invoke<Users, I>...};
+    }
+
+    // Built inside a member function, where the class is complete; one
+    // table per kind of store
+    template<typename Users>
+    static const std::array<Handler<Users>, kCommandCount>& handlers() {
+        static constexpr std::array<Handler<Users>, kCommandCount> table =
+            makeHandlers<Users>(std::make_index_sequence<kCommandCount>{});
+        return table;
+    }
+
+    template<typename Users>
+    CommandResult dispatch(const Command& cmd, Users& users) const {
+        WZH_PROFILE_COMMAND(cmd.index());
+        CommandResult result;
+        if (hasOverrides && overrides[cmd.index()]) {
+            result = overrides[cmd.index()]->execute(cmd, users);
+        } else {
+            result = handlers<Users>()[cmd.index()](cmd, users);
+        }
+        result.command = &cmd;
+        return result;
+    }
 
 public:
     template<typename T>
     void registerExecutor(std::unique_ptr<CommandExecutor> executor) {
-        executors[std::type_index(typeid(T))] = std::move(executor);
-    }
-
-    CommandResult execute(const Command& cmd, UserManager& userManager) {
-        return std::visit([&](const auto& command) -> CommandResult {
-            using T = std::decay_t<decltype(command)>;
-            auto it = executors.find(std::type_index(typeid(T)));
-            if (it != executors.end()) {
-                return it->second->execute(command, userManager);
-            }
-            return {false, "❌ Unknown command"};
-        }, cmd);
+        overrides[commandIndex<T>()] = std::move(executor);
+        hasOverrides = true;
+    }
+
+    /// @brief Run the executor bound to the command's type
+    ///
+    /// The result refers back to cmd, which must outlive it.
+    ///
+    /// The registry is not modified here, so one registry can be shared by
+    /// threads that each drive their own UserManager, or all drive the same
+    /// ConcurrentUserManager.
+    CommandResult execute(const Command& cmd, UserManager& userManager) const {
+        return dispatch(cmd, userManager);
+    }
+
+    CommandResult execute(const Command& cmd, ConcurrentUserManager& users) const {
+        return dispatch(cmd, users);
     }
 };
 
@@ -0,0 +1,101 @@
+#ifndef SERVER_SERVER_HPP
+#define SERVER_SERVER_HPP
+
+// Standard Library
+#include <cstddef>        // For size_t
+#include <cstdint>        // For uint64_t
+#include <memory>         // For std::unique_ptr
+#include <string>         // For std::string
+#include <unordered_map>  // For std::unordered_map
+#include <vector>         // For std::vector
+
+// Project Headers
+#include "task/processor.hpp"   // For TaskProcessor
+#include "user/manager.hpp"     // For UserManager
+
+/// @brief Counters of a TaskServer run
+struct ServerStats {
+    std::uint64_t connections = 0;
+    std::uint64_t completedTasks = 0;    // Connections whose task ended, whether it passed or failed
+    std::uint64_t bytesIn = 0;
+    std::uint64_t bytesOut = 0;
+    std::uint64_t peakHeldBytes = 0;     // Most transcript a connection held at once, sent or not
+};
+
+/// @brief Serves tasks over a socket from one warm TaskProcessor
+///
+/// Every connection is a task: the commands it sends run as their lines
+/// arrive (see TaskSession), against user state of its own, or against
+/// the processor's shared state, where connections see each other's
+/// changes line by line. The transcript is sent back on the same
+/// connection. The task ends as a file
+/// task would, at EXIT, at the first failing line, or when the client
+/// shuts down its side; the server then sends the rest of the transcript,
+/// shuts down its own side and drops whatever else the client sends until
+/// it closes the connection.
+///
+/// One thread runs everything from an epoll loop. A connection's session
+/// is given room for kMaxPendingBytes of unsent transcript: once they are
+/// written it stops, partway through a command if need be, and goes on
+/// (one piece per event) only as the client reads, while the connection is
+/// not read from. Sent bytes are compacted away once they are half the
+/// buffer. So a client that does not read its transcript holds at most
+/// about twice kMaxPendingBytes, one read and its longest line, however
+/// much output its commands ask for, and cannot stall the other
+/// connections.
+class TaskServer {
+public:
+    static constexpr size_t kMaxPendingBytes = size_t(1) << 20;
+
+    /// @brief Listen on address: `unix:PATH` (or any path containing a
+    ///        `/`) for a Unix socket, `HOST:PORT` or `PORT` (on 127.0.0.1)
+    ///        for TCP
+    /// @throws std::runtime_error if the address is malformed, cannot be
+    ///         bound, or the platform has no epoll
+    TaskServer(const TaskProcessor& processor, const std::string& address);
+    ~TaskServer();
+
+    TaskServer(const TaskServer&) = delete;
+    TaskServer& operator=(const TaskServer&) = delete;
+
+    /// @brief Serve until stop() is called; open connections are then dropped
+    void run();
+
+    /// @brief Make run() return; safe from a signal handler or another thread
+    void stop();
+
+    /// @brief Where the server listens, with the port chosen if 0 was asked for
+    const std::string& address() const { return boundAddress; }
+
+    const ServerStats& stats() const { return counters; }
+
+private:
+    struct Connection;
+
+    const TaskProcessor& processor;
+    int listener = -1;
+    int epoll = -1;
+    int wakeup = -1;           // eventfd written by stop()
+    std::string boundAddress;
+    std::string unixPath;      // Removed again on destruction
+    std::unordered_map<int, std::unique_ptr<Connection>> connections;
+    std::vector<std::unique_ptr<UserManager>> idleUsers;   // Reset and reused by later connections
+    ServerStats counters;
+
+    void accept();
+
+    // Each returns false if it closed the connection
+    bool readFrom(Connection& connection);
+    bool writeTo(Connection& connection);
+
+    /// @brief Hand the connection's buffered transcript to it for sending
+    void flush(Connection& connection);
+
+    /// @brief Count the connection's task once it has ended
+    void noteEnd(Connection& connection);
+
+    void updateEvents(Connection& connection);
+    void close(Connection& connection);
+};
+
+#endif // SERVER_SERVER_HPP
@@ -0,0 +1,117 @@
+#ifndef TASK_CACHE_HPP
+#define TASK_CACHE_HPP
+
+// Standard Library
+#include <cstddef>       // For size_t
+#include <cstdint>       // For uint32_t, uint64_t
+#include <memory>        // For std::shared_ptr
+#include <string>        // For std::string
+#include <string_view>   // For std::string_view
+#include <unordered_map> // For std::unordered_map
+
+// Project Headers
+#include "task/mapped.hpp"   // For MappedFile
+
+/// @brief Everything a task's transcript depends on
+struct CacheKey {
+    std::uint64_t low = 0;       // Two digests of the task's bytes, under different seeds
+    std::uint64_t high = 0;
+    std::uint64_t size = 0;      // Bytes in the task
+    std::uint64_t context = 0;   // Digest of the binary, its options and the starting state
+
+    bool operator==(const CacheKey& other) const {
+        return low == other.low && high == other.high && size == other.size && context == other.context;
+    }
+};
+
+struct CacheKeyHash {
+    size_t operator()(const CacheKey& key) const { return static_cast<size_t>(key.low ^ key.context); }
+};
+
+/// @brief A task's transcript between its opening and closing lines, which
+///        name the file and are written afresh for every task answered
+struct CachedResult {
+    std::string body;
+    bool completed = false;
+};
+
+/// @brief Counters of one ResultCache
+struct CacheStats {
+    std::uint64_t hits = 0;        // Tasks answered without running
+    std::uint64_t diskHits = 0;    // ...of them read from the cache directory
+    std::uint64_t repeats = 0;     // ...of them repeating an earlier task of the same run
+    std::uint64_t misses = 0;      // Tasks looked up in vain, and so run
+    std::uint64_t stored = 0;      // Entries written to the cache directory
+};
+
+/// @brief Content-addressed store of task results, in memory and optionally
+///        on disk
+///
+/// A task is keyed by two 64-bit wyhash digests of its bytes and its size,
+/// plus a context digest of what else decides the transcript: the running
+/// executable, the transcript options and the starting snapshot. A task
+/// whose key is known is answered from its stored result without being
+/// parsed or executed.
+///
+/// Entries found or stored stay in memory for the cache's lifetime. With a
+/// directory, each is also a file named after its key, so later runs share
+/// them. Layout, integers little-endian:
+///   header   "WZHC", format version (u32), the key's low, high, size and
+///            context (u64 each), completed flag (one byte), checksum of
+///            the body (u64)
+///   body     the rest of the file
+///
+/// An entry file that is malformed or belongs to another key is a miss,
+/// and one that cannot be written is skipped: the cache never changes a
+/// transcript, only whether it is computed.
+///
+/// Not thread-safe.
+class ResultCache {
+public:
+    static constexpr std::uint32_t kVersion = 1;
+    static constexpr size_t kHeaderBytes = 49;
+
+    /// @brief 64-bit wyhash of bytes: a few cycles per 16 bytes
+    static std::uint64_t hash(std::string_view bytes, std::uint64_t seed);
+
+    /// @brief Digest of the running executable's image, or of this file's
+    ///        build time where the image cannot be read
+    static std::uint64_t binaryVersion();
+
+    /// @brief Key of the task mapped in file, for the given context
+    ///
+    /// Hash the bytes, not the file name. A task run for the cache is
+    /// hashed again as it runs, so a file rewritten after its lookup is
+    /// never stored under the old key.
+    static CacheKey keyOf(const MappedFile& file, std::uint64_t context);
+
+    /// @brief A cache in memory only, or also in directory (created if missing)
+    /// @throws std::runtime_error if the directory cannot be created
+    explicit ResultCache(std::string directory = {});
+
+    ResultCache(const ResultCache&) = delete;
+    ResultCache& operator=(const ResultCache&) = delete;
+
+    /// @brief The stored result of key, counted as a hit, or nullptr, counted as a miss
+    std::shared_ptr<const CachedResult> find(const CacheKey& key);
+
+    /// @brief Keep result as that of key
+    void store(const CacheKey& key, std::shared_ptr<const CachedResult> result);
+
+    /// @brief Count a task answered by an earlier one of the same run
+    void countRepeat();
+
+    const std::string& directory() const { return root; }
+    const CacheStats& stats() const { return counters; }
+
+private:
+    std::string root;
+    std::unordered_map<CacheKey, std::shared_ptr<const CachedResult>, CacheKeyHash> entries;
+    CacheStats counters;
+
+    std::string entryPath(const CacheKey& key) const;
+    std::shared_ptr<const CachedResult> load(const CacheKey& key) const;
+    bool save(const CacheKey& key, const CachedResult& result) const;
+};
+
+#endif // TASK_CACHE_HPP
@@ -0,0 +1,222 @@
+#ifndef TASK_CODEC_HPP
+#define TASK_CODEC_HPP
+
+// Standard Library
+#include <array>         // For std::array
+#include <cstddef>       // For size_t
+#include <cstdint>       // For uint32_t, uint64_t
+#include <optional>      // For std::optional
+#include <stdexcept>     // For std::runtime_error
+#include <string>        // For std::string
+#include <string_view>   // For std::string_view
+#include <tuple>         // For std::tie, std::apply
+#include <utility>       // For std::index_sequence
+#include <variant>       // For std::visit, std::variant_alternative_t
+
+// Project Headers
+#include "commands/command.hpp"   // For Command
+
+// Binary encoding shared by the compiled task, snapshot and journal formats:
+// little-endian integers, varints, a checksum, and the operands of every
+// command in the order they are encoded.
+
+// Operands of each command. Every Command alternative needs one; adding a
+// field to a command means adding it here and bumping the versions of the
+// formats that store commands (CompiledTask and Journal).
+inline auto fields(NameList& n) { return std::tie(n.text, n.isRange, n.first, n.last); }
+inline auto fields(CreateUserCommand& c) { return std::tie(c.username); }
+inline auto fields(CreateUsersCommand& c) { return std::tie(c.names); }
+inline auto fields(DeleteUserCommand& c) { return std::tie(c.username); }
+inline auto fields(DisableUserCommand& c) { return std::tie(c.username); }
+inline auto fields(SendMessageCommand& c) { return std::tie(c.username, c.message); }
+inline auto fields(PingCommand& c) { return std::tie(c.targets, c.times, c.summary); }
+inline auto fields(AddUserToGroupCommand& c) { return std::tie(c.username, c.group); }
+inline auto fields(AddUsersToGroupCommand& c) { return std::tie(c.names, c.group); }
+inline auto fields(RemoveUserFromGroupCommand& c) { return std::tie(c.username, c.group); }
+inline auto fields(GetUsersCommand& c) { return std::tie(c.prefix); }
+inline auto fields(GetGroupsCommand&) { return std::tie(); }
+inline auto fields(GetMessageHistoryCommand& c) { return std::tie(c.username, c.from, c.limit); }
+inline auto fields(ExitCommand&) { return std::tie(); }
+
+inline void putLe(std::string& out, std::uint64_t value, size_t bytes) {
+    for (size_t i = 0; i < bytes; ++i) {
+        out.push_back(static_cast<char>(value >> (8 * i)));
+    }
+}
+
+inline std::uint64_t getLe(const char* in, size_t bytes) {
+    std::uint64_t value = 0;
+    for (size_t i = 0; i < bytes; ++i) {
+        value |= std::uint64_t(static_cast<unsigned char>(in[i])) << (8 * i);
+    }
+    return value;
+}
+
+inline void putVarint(std::string& out, std::uint32_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+/// @brief FNV-1a over little-endian words: cheap enough to check on every load
+std::uint64_t checksum(std::string_view bytes);
+
+/// @brief Bounds-checked reads from an encoded buffer
+///
+/// Reading past the end, or an integer longer than five bytes, throws
+/// std::runtime_error naming the format: "Corrupt <format>: <what>".
+class ByteReader {
+private:
+    std::string_view data;
+    size_t& position;
+    const char* format;
+
+public:
+    ByteReader(std::string_view data, size_t& position, const char* format)
+        : data(data), position(position), format(format) {}
+
+    [[noreturn]] void fail(const char* what) const;
+
+    size_t remaining() const { return data.size() - position; }
+
+    std::uint8_t byte() {
+        if (position >= data.size()) {
+            fail("truncated entry");
+        }
+        return static_cast<std::uint8_t>(data[position++]);
+    }
+
+    std::uint32_t varint() {
+        std::uint32_t value = 0;
+        for (unsigned shift = 0; shift < 35; shift += 7) {
+            std::uint8_t b = byte();
+            value |= std::uint32_t(b & 0x7F) << shift;
+            if ((b & 0x80) == 0) {
+                return value;
+            }
+        }
+        fail("overlong integer");
+    }
+
+    /// @brief The next length bytes, viewing the buffer
+    std::string_view bytes(size_t length) {
+        if (length > remaining()) {
+            fail("string out of range");
+        }
+        std::string_view text = data.substr(position, length);
+        position += length;
+        return text;
+    }
+};
+
+/// @brief Writes command operands to out; Derived adds put(std::string_view)
+///
+/// Integers are varints, flags and optional markers one byte, and a
+/// NameList its own fields. How strings are stored is up to the format.
+template<typename Derived>
+class OperandWriter {
+protected:
+    std::string& out;
+
+public:
+    explicit OperandWriter(std::string& out) : out(out) {}
+
+    void put(std::int32_t value) { putVarint(out, static_cast<std::uint32_t>(value)); }
+    void put(bool value) { out.push_back(value ? 1 : 0); }
+
+    template<typename T>
+    void put(const std::optional<T>& value) {
+        out.push_back(value ? 1 : 0);
+        if (value) {
+            self().put(*value);
+        }
+    }
+
+    void put(const NameList& names) {
+        NameList copy = names;
+        putAll(fields(copy));
+    }
+
+    template<typename Tuple>
+    void putAll(const Tuple& operands) {
+        std::apply([this](const auto&... operand) { (self().put(operand), ...); }, operands);
+    }
+
+    /// @brief The command's operands, without its opcode
+    void putCommand(const Command& command) {
+        std::visit([this](const auto& cmd) {
+            auto copy = cmd;
+            putAll(fields(copy));
+        }, command);
+    }
+
+private:
+    Derived& self() { return static_cast<Derived&>(*this); }
+};
+
+/// @brief Reads what OperandWriter wrote; Derived adds get(std::string_view&)
+template<typename Derived>
+class OperandReader : public ByteReader {
+public:
+    using ByteReader::ByteReader;
+
+    void get(std::int32_t& value) { value = static_cast<std::int32_t>(varint()); }
+    void get(bool& value) { value = byte() != 0; }
+
+    template<typename T>
+    void get(std::optional<T>& value) {
+        value.reset();
+        if (byte() != 0) {
+            T operand{};
+            self().get(operand);
+            value = operand;
+        }
+    }
+
+    void get(NameList& names) {
+        getAll(fields(names));
+        if (names.isRange && names.first > names.last) {
+            fail("name range reversed");
+        }
+        if (names.isRange && names.count() > NameList::kMaxRangeNames) {
+            fail("name range too large");
+        }
+    }
+
+    template<typename Tuple>
+    void getAll(Tuple operands) {
+        std::apply([this](auto&... operand) { (self().get(operand), ...); }, operands);
+    }
+
+    /// @brief The command with the given opcode (its index in Command)
+    Command getCommand(std::uint8_t opcode);
+
+private:
+    Derived& self() { return static_cast<Derived&>(*this); }
+
+    template<size_t I>
+    static Command decodeAs(OperandReader& reader) {
+        std::variant_alternative_t<I, Command> cmd{};
+        reader.getAll(fields(cmd));
+        return Command(std::in_place_index<I>, cmd);
+    }
+
+    // Decoders indexed by opcode, built like CommandRegistry's handler table
+    template<size_t... I>
+    static constexpr auto makeDecoders(std::index_sequence<I...>) {
+        return std::array<Command (*)(OperandReader&), sizeof...(I)>{&decodeAs<I>...};
+    }
+};
+
+template<typename Derived>
+Command OperandReader<Derived>::getCommand(std::uint8_t opcode) {
+    static constexpr auto kDecoders = makeDecoders(std::make_index_sequence<std::variant_size_v<Command>>{});
+    if (opcode >= kDecoders.size()) {
+        fail("unknown opcode");
+    }
+    return kDecoders[opcode](*this);
+}
+
+#endif // TASK_CODEC_HPP
@@ -0,0 +1,85 @@
+#ifndef TASK_COMPILED_HPP
+#define TASK_COMPILED_HPP
+
+// Standard Library
+#include <cstddef>       // For size_t
+#include <cstdint>       // For uint32_t
+#include <optional>      // For std::optional
+#include <string>        // For std::string
+#include <string_view>   // For std::string_view
+#include <vector>        // For std::vector
+
+// Project Headers
+#include "commands/command.hpp"   // For Command
+#include "task/mapped.hpp"        // For MappedFile
+
+/// @brief One entry of a compiled task
+struct CompiledLine {
+    std::optional<Command> command;   // Empty for a line that did not parse
+    std::string_view text;            // The source line, kept only when it did not parse
+};
+
+/// @brief Counters of one compileTask() run
+struct CompileStats {
+    size_t commands = 0;        // Entries written, invalid lines included
+    size_t invalidLines = 0;    // Lines kept as text because they did not parse
+    size_t strings = 0;         // Distinct string operands
+    size_t sourceBytes = 0;
+    size_t compiledBytes = 0;
+};
+
+/// @brief Compile the text task file at source into the binary format at target
+///
+/// Every line is parsed once here. Lines that do not parse are kept as
+/// text, so a replay reports them exactly as the text run would.
+/// @throws std::runtime_error if a file cannot be read or written, or the task
+///         exceeds the format's limits (2^32 commands, 4 GiB strings)
+CompileStats compileTask(const std::string& source, const std::string& target);
+
+/// @brief Binary task file, mapped and decoded without parsing
+///
+/// Layout, integers little-endian:
+///   header   "WZHT", format version (u32), checksum of everything after
+///            the header (u64), string count (u32), entry count (u32),
+///            size of the string section (u64)
+///   strings  every distinct string operand once: varint length, bytes
+///   entries  opcode, the index of the command's Command alternative (or
+///            kInvalidLine, whose operand is the line), then its operands
+///            in declaration order:
+///            strings as varint indices into the string section, integers
+///            as varints, flags and optional markers as one byte
+///
+/// Decoded commands view the mapped strings, so they remain valid until the
+/// task is destroyed.
+class CompiledTask {
+public:
+    static constexpr std::uint32_t kVersion = 1;
+    static constexpr std::uint8_t kInvalidLine = 0xFF;
+    static constexpr size_t kHeaderBytes = 32;
+
+    /// @brief Whether contents start like a compiled task (of any version)
+    static bool matches(std::string_view contents);
+
+    /// @throws std::runtime_error if the header, version or checksum is wrong
+    explicit CompiledTask(MappedFile file);
+
+    CompiledTask(const CompiledTask&) = delete;
+    CompiledTask& operator=(const CompiledTask&) = delete;
+
+    /// @brief Decode the next entry into line; false after the last one
+    /// @throws std::runtime_error on a malformed entry, or with the parser's
+    ///         message for a line it threw on
+    bool next(CompiledLine& line);
+
+    /// @brief Number of entries
+    size_t size() const { return entryCount; }
+
+private:
+    MappedFile file;
+    std::vector<std::string_view> strings;
+    size_t entryCount = 0;
+    size_t decoded = 0;
+    size_t position = 0;     // Offset of the next entry
+};
+
+#endif // TASK_COMPILED_HPP
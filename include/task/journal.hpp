@@ -0,0 +1,106 @@
+#ifndef TASK_JOURNAL_HPP
+#define TASK_JOURNAL_HPP
+
+// Standard Library
+#include <cstddef>       // For size_t
+#include <cstdint>       // For uint32_t, uint64_t
+#include <functional>    // For std::function
+#include <memory>        // For std::unique_ptr
+#include <string>        // For std::string
+
+// Project Headers
+#include "commands/command.hpp"   // For Command
+#include "output/sink.hpp"        // For FileSink
+
+/// @brief Counters of one Journal
+struct JournalStats {
+    std::uint64_t replayed = 0;      // Commands read back by replay()
+    std::uint64_t recorded = 0;      // Commands appended
+    std::uint64_t commits = 0;       // Batches written and synced
+    std::uint64_t bytes = 0;         // Bytes those batches took
+};
+
+/// @brief Append-only log of the commands that changed user state
+///
+/// Layout, integers little-endian:
+///   header   "WZHJ", format version (u32), generation (u64)
+///   batches  payload size (u32), record count (u32), checksum of the
+///            payload (u64), then the records: opcode, the index of the
+///            command's Command alternative, and its operands encoded as
+///            in a CompiledTask entry except that strings are inline
+///            (varint length, bytes)
+///
+/// Records collect in memory and are committed a batch at a time, with one
+/// write and one sync, once kBatchBytes have collected and on commit() (at
+/// the end of every task), so a crash loses at most the uncommitted batch.
+/// A batch cut short by a crash fails its size or checksum check; opening
+/// the journal again drops it and everything after it.
+///
+/// The generation is that of the Snapshot the journal continues: replaying
+/// the journal on top of that snapshot gives the latest state. Saving a new
+/// snapshot moves to the next generation with restart().
+///
+/// Not thread-safe.
+class Journal {
+public:
+    static constexpr std::uint32_t kVersion = 1;
+    static constexpr size_t kHeaderBytes = 16;
+    static constexpr size_t kBatchBytes = size_t(64) << 10;
+
+    /// @brief Whether running command successfully changes user state, and
+    ///        so belongs in a journal
+    static bool records(const Command& command);
+
+    /// @brief Open the journal at filename, or create an empty one of
+    ///        generation 0 if there is none
+    /// @throws std::runtime_error if the file is not a journal of this
+    ///         version or cannot be written
+    explicit Journal(const std::string& filename);
+
+    /// @brief Commits what is left; errors are lost, so call commit() first
+    ~Journal();
+
+    Journal(const Journal&) = delete;
+    Journal& operator=(const Journal&) = delete;
+
+    std::uint64_t generation() const { return journalGeneration; }
+
+    /// @brief Call apply with every committed command, oldest first
+    ///
+    /// The command views the mapped journal and is only valid during its call.
+    /// @throws std::runtime_error if a committed record is malformed
+    void replay(const std::function<void(const Command&)>& apply);
+
+    /// @brief Record a command; it is committed with its batch
+    /// @throws std::runtime_error if a string exceeds 4 GiB or a full batch
+    ///         cannot be committed
+    void append(const Command& command);
+
+    /// @brief Write and sync the records appended since the last commit
+    ///
+    /// If that fails, the file is cut back to its committed batches and the
+    /// records stay to be committed again. Should even that fail, every
+    /// later commit throws until restart().
+    /// @throws std::runtime_error if the file cannot be written
+    void commit();
+
+    /// @brief Drop every record and continue the snapshot of the given generation
+    /// @throws std::runtime_error if the file cannot be written
+    void restart(std::uint64_t generation);
+
+    const JournalStats& stats() const { return counters; }
+
+private:
+    std::string filename;
+    std::unique_ptr<FileSink> file;
+    std::uint64_t journalGeneration = 0;
+    size_t committedBytes = 0;       // Valid length of the file
+    std::string batch;               // Records not committed yet
+    std::uint32_t batchRecords = 0;
+    bool unusable = false;           // A failed commit left bytes past committedBytes
+    JournalStats counters;
+
+    void create(std::uint64_t generation);
+};
+
+#endif // TASK_JOURNAL_HPP
@@ -0,0 +1,45 @@
+#ifndef TASK_MAPPED_HPP
+#define TASK_MAPPED_HPP
+
+// Standard Library
+#include <cstddef>       // For size_t
+#include <string>        // For std::string
+#include <string_view>   // For std::string_view
+#include <vector>        // For std::vector
+
+/// @brief Read-only contents of a whole file, memory-mapped where possible
+///
+/// Files that cannot be mapped (pipes, character devices) are read into
+/// memory once instead, always on the heap. Views of the contents remain
+/// valid until the file is destroyed; moving it keeps them valid as well,
+/// since the mapping or the heap buffer moves along unchanged.
+class MappedFile {
+private:
+    const char* bytes = nullptr;
+    size_t length = 0;
+    bool mapped = false;
+    std::vector<char> fallback;   // Contents when the file could not be mapped; its move keeps the buffer
+
+public:
+    /// @throws std::runtime_error if the file cannot be opened
+    explicit MappedFile(const std::string& filename);
+    ~MappedFile();
+
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile& operator=(MappedFile&&) = delete;
+
+    const char* data() const { return bytes; }
+    size_t size() const { return length; }
+    std::string_view view() const { return {bytes, length}; }
+
+    /// @brief Hand the whole pages of [from, upTo) back to the kernel
+    ///
+    /// They are simply read back from the file if touched again.
+    /// @return where the next release should start: upTo rounded down to a
+    ///         page, or from if nothing was released
+    size_t release(size_t from, size_t upTo);
+};
+
+#endif // TASK_MAPPED_HPP
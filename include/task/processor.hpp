@@ -1,28 +1,193 @@
 #ifndef TASK_PROCESSOR_HPP
 #define TASK_PROCESSOR_HPP
 
+#include <cstddef>
+#include <cstdint>
+#include <exception>
 #include <memory>
 #include <optional>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "commands/command.hpp"
+#include "output/buffered.hpp"
+#include "output/sink.hpp"
 #include "user/manager.hpp"
 #include "registry/registry.hpp"
+#include "task/scheduler.hpp"
+
+class CompiledTask;
+class ConcurrentUserManager;
+class Journal;
+class MappedFile;
+class ResultCache;
+struct CachedResult;
+struct CacheKey;
+class Snapshot;
+class TaskSession;
+class TaskSource;
+
+namespace grammar {
+class Line;
+}
+
+/// @brief Opt-in execution modes of a TaskProcessor
+struct ProcessorOptions {
+    /// Parse each sequentially processed task on a separate thread that runs
+    /// ahead of execution through a bounded ring
+    bool pipeline = false;
+
+    /// Split each large task of a sequential run at line boundaries into
+    /// chunks parsed by a pool of this many threads, while the calling
+    /// thread executes them in file order. 0 or 1 parses on the calling
+    /// thread; takes precedence over pipeline for large tasks
+    size_t parseWorkers = 0;
+
+    /// Report only whether each task passed or failed; command results are
+    /// never rendered
+    bool quiet = false;
+
+    /// Start every task from this saved state instead of empty user state
+    const Snapshot* snapshot = nullptr;
+
+    /// Replay this journal on top of the starting state, and record every
+    /// successful state-changing command in it. Only for one task at a
+    /// time, run sequentially
+    Journal* journal = nullptr;
+
+    /// Answer every task whose bytes were seen before, in this run or (with
+    /// a cache directory) an earlier one, from its stored transcript; tasks
+    /// repeated within the list run once. Not with a journal
+    ResultCache* cache = nullptr;
+
+    /// Run every task, and every connection of a TaskServer, against this
+    /// one store instead of user state of its own: tasks running at the
+    /// same time see each other's changes, and each task starts from what
+    /// those before it left. Not with a snapshot, journal or cache
+    ConcurrentUserManager* sharedState = nullptr;
+};
 
 class TaskProcessor {
 private:
+    ProcessorOptions options;
+    OutputSink& output;
     UserManager userManager;
     CommandRegistry registry;
+    std::vector<WorkerStats> schedulerStats;
+    AllocationStats arenaStats;
+    std::uint64_t cacheContext = 0;
+    std::unique_ptr<WorkStealingScheduler> parsePool;   // With options.parseWorkers > 1
+
+    enum class LineOutcome { Continue, Exit, Stop };
+
+    /// @brief Give users the state a task starts from: empty, or the
+    ///        snapshot's with the journal replayed on top; with shared
+    ///        state, nothing changes
+    void startState(UserManager& users) const;
+
+    /// @brief Run one task against the given user state, writing its transcript to out
+    ///
+    /// With a scheduler, large tasks parse ahead in chunks that idle workers
+    /// can pick up, while commands still execute in file order.
+    void runTask(const std::string& filename, UserManager& users, BufferedOutput& out,
+                 WorkStealingScheduler* scheduler = nullptr) const;
+
+    /// @brief Run the lines of the task in file, whose state has been
+    ///        started, between its opening and closing lines
+    /// @return Whether the task completed
+    bool runTaskBody(MappedFile file, UserManager& users, BufferedOutput& out,
+                     WorkStealingScheduler* scheduler) const;
+
+    /// @brief Run the task in filename, looked up under key, for the cache,
+    ///        returning its result
+    ///
+    /// The file is mapped afresh and must still hash to key. A task that
+    /// changed since, or that throws, has no result: its whole transcript
+    /// goes to out instead, and nullptr is returned.
+    std::shared_ptr<const CachedResult> runCacheableTask(const std::string& filename, const CacheKey& key,
+                                                         UserManager& users, BufferedOutput& out,
+                                                         WorkStealingScheduler* scheduler) const;
 
-    void registerCommands();
-    std::vector<std::string> readTaskFile(const std::string& filename);
-    std::optional<Command> parseCommand(const std::string& line);
+    /// @brief Write the transcript of a task with a known result
+    void replayTask(const std::string& name, const CachedResult& result, BufferedOutput& out) const;
+
+    /// @brief processTasks() with options.cache
+    void processCachedTasks(const std::vector<std::string>& filenames, size_t jobs);
+
+    /// @brief Execute one parsed line and, unless quiet, write its transcript
+    LineOutcome executeLine(std::string_view line, const std::optional<Command>& cmdOpt, UserManager& users,
+                            BufferedOutput& out) const;
+
+    // executeLine() in two steps, leaving the transcript to the caller
+    CommandResult executeCommand(const Command& cmd, UserManager& users) const;
+
+    /// @brief How the task goes on after cmd gave result; records cmd in
+    ///        the journal if it is to be
+    LineOutcome lineOutcome(const Command& cmd, const CommandResult& result) const;
+
+    // Opening and closing lines of a task's transcript; abortTask() closes a
+    // task that threw
+    void beginTask(const std::string& name, BufferedOutput& out) const;
+    void endTask(const std::string& name, bool completed, BufferedOutput& out) const;
+    void abortTask(const std::string& name, const std::exception& error, BufferedOutput& out) const;
+
+    // Each returns true if the task completed (reached its end or EXIT)
+    bool runLines(TaskSource& source, UserManager& users, BufferedOutput& out) const;
+    bool runChunkedLines(TaskSource& source, UserManager& users, BufferedOutput& out,
+                         WorkStealingScheduler& scheduler) const;
+    bool runPipelinedLines(TaskSource& source, UserManager& users, BufferedOutput& out) const;
+    bool runSplitLines(MappedFile& file, UserManager& users, BufferedOutput& out, WorkStealingScheduler& pool) const;
+    bool runCompiled(CompiledTask& task, UserManager& users, BufferedOutput& out) const;
+
+    friend class TaskSession;
 
 public:
-    TaskProcessor();
+    /// @brief Tasks at least this large are parsed ahead in chunks, with a
+    ///        scheduler or parse workers
+    static constexpr size_t kLargeTaskBytes = size_t(1) << 20;
+
+    /// @brief Bytes per chunk of split parsing, extended to the next line end
+    static constexpr size_t kSplitBytes = size_t(256) << 10;
+
+    /// @brief Write transcripts to output, the standard output by default
+    /// @throws std::runtime_error if the journal follows a later snapshot than the one given,
+    ///         or comes with a cache, or if shared state comes with a snapshot, journal or cache
+    explicit TaskProcessor(ProcessorOptions options = {}, OutputSink& output = FileSink::standardOutput());
+
+    static std::optional<Command> parseCommand(std::string_view line);
+    static std::optional<Command> parseCommand(const grammar::Line& line);
+
+    /// @brief Process one task file, text or compiled (see compileTask)
+    ///
+    /// With a journal, the task's changes are all committed when it returns.
     void processTask(const std::string& filename);
-    void processTasks(const std::vector<std::string>& filenames);
+
+    /// @brief Process every task, in order
+    ///
+    /// With jobs > 1 the tasks run on a work-stealing pool of that many
+    /// workers, each with its own UserManager. Transcripts are buffered per
+    /// task and written to the output in the original order, so the output
+    /// is identical to the sequential run; with shared state, what each task
+    /// sees depends on how it interleaves with the others.
+    /// @throws std::runtime_error with a journal and more than one task
+    void processTasks(const std::vector<std::string>& filenames, size_t jobs = 1);
+
+    /// @brief Save the user state the last sequential task ended with
+    ///
+    /// With a journal, the snapshot saved is of the journal's next
+    /// generation, and the journal restarts empty at that generation.
+    /// @throws std::runtime_error if the snapshot cannot be written, or with
+    ///         a cache, which leaves answered tasks' state unknown, or with
+    ///         shared state
+    void saveSnapshot(const std::string& filename);
+
+    /// @brief Per-worker counters of the last parallel processTasks run, or
+    ///        of the parse pool after a sequential one
+    const std::vector<WorkerStats>& lastSchedulerStats() const { return schedulerStats; }
+
+    /// @brief Allocation counters of the user state arenas, over every processTasks run
+    const AllocationStats& lastAllocationStats() const { return arenaStats; }
 };
 
 #endif // TASK_PROCESSOR_HPP
\ No newline at end of file
@@ -0,0 +1,67 @@
+#ifndef TASK_RING_HPP
+#define TASK_RING_HPP
+
+// Standard Library
+#include <atomic>     // For std::atomic
+#include <cstddef>    // For size_t
+#include <utility>    // For std::move
+#include <vector>     // For std::vector
+
+/// @brief Bounded lock-free single-producer/single-consumer queue
+///
+/// Exactly one thread may push and exactly one (other) thread may pop.
+/// Both operations are wait-free and never block; callers decide how to
+/// wait when the ring is full or empty.
+template<typename T>
+class SpscRing {
+private:
+    // Keep the two indices on separate cache lines to avoid false sharing
+    static constexpr size_t kCacheLine = 64;
+
+    std::vector<T> slots;
+    size_t mask;
+    alignas(kCacheLine) std::atomic<size_t> head{0};  // Next slot to pop, owned by the consumer
+    alignas(kCacheLine) std::atomic<size_t> tail{0};  // Next slot to push, owned by the producer
+
+    static size_t roundUp(size_t capacity) {
+        size_t size = 2;
+        while (size < capacity) {
+            size *= 2;
+        }
+        return size;
+    }
+
+public:
+    /// @brief Create a ring holding at least capacity items
+    explicit SpscRing(size_t capacity)
+        : slots(roundUp(capacity)), mask(slots.size() - 1) {}
+
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    /// @brief Move item into the ring; false (item untouched) if it is full
+    bool tryPush(T& item) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if (t - head.load(std::memory_order_acquire) == slots.size()) {
+            return false;
+        }
+        slots[t & mask] = std::move(item);
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    /// @brief Move the oldest item out of the ring; false if it is empty
+    bool tryPop(T& item) {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire)) {
+            return false;
+        }
+        item = std::move(slots[h & mask]);
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    size_t capacity() const { return slots.size(); }
+};
+
+#endif // TASK_RING_HPP
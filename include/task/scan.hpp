@@ -0,0 +1,98 @@
+#ifndef TASK_SCAN_HPP
+#define TASK_SCAN_HPP
+
+// Standard Library
+#include <cstddef>       // For size_t
+#include <cstdint>       // For uint8_t, SIZE_MAX
+#include <string_view>   // For std::string_view
+#include <vector>        // For std::vector
+
+/// @brief Instruction set a LineScanner compares bytes with
+enum class ScanKernel : std::uint8_t {
+    Scalar,
+    Sse2,
+    Avx2,
+    Neon,
+};
+
+/// @brief One line of task text, [start, end) up to its newline or its
+///        first `#`, whichever comes first; not trimmed
+struct LineSpan {
+    size_t start;
+    size_t end;
+};
+
+/// @brief Where tokens begin and end in scanned text, one bit per byte
+///
+/// Bit i % 64 of word i / 64 of a mask stands for byte base + i of the
+/// text. grammar::Line reads them to skip whitespace and find the end of a
+/// name or the closing quote a word at a time.
+struct TextTokens {
+    size_t base = 0;                     // First byte covered
+    std::vector<std::uint64_t> spaces;   // Whitespace (chars::Space)
+    std::vector<std::uint64_t> words;    // Letters, digits and '_' (chars::Word)
+    std::vector<std::uint64_t> quotes;   // '"'
+
+    /// @brief Cover nothing, to be filled from byte at on
+    void restart(size_t at) {
+        base = at;
+        spaces.clear();
+        words.clear();
+        quotes.clear();
+    }
+};
+
+/// @brief Splits task text into lines, comments cut off, 64 bytes at a time
+///
+/// Each 64-byte block is compared against `\n` and `#` with vector
+/// instructions, giving one bit mask for each; lines are then read off the
+/// set bits, so the cost per byte is a fraction of a comparison and a
+/// block without a line end costs two masks. The kernel is picked at run
+/// time: AVX2 where the CPU has it, otherwise SSE2 on x86-64 and NEON on
+/// AArch64, with a scalar loop everywhere else.
+///
+/// The same blocks can be classified for the parser as they go by, giving
+/// the TextTokens of the text: whitespace, word characters and quotes.
+///
+/// Text may be handed over in any number of pieces; a line spanning two
+/// of them is reported once its newline arrives.
+class LineScanner {
+public:
+    /// @brief The fastest kernel this CPU runs
+    static ScanKernel bestKernel();
+    static bool supported(ScanKernel kernel);
+    static const char* name(ScanKernel kernel);
+
+    /// @pre supported(kernel)
+    explicit LineScanner(ScanKernel kernel = bestKernel()) : kernel(kernel) {}
+
+    ScanKernel kernelUsed() const { return kernel; }
+
+    /// @brief Scan text[from, to), continuing where the last call stopped,
+    ///        and append every line that ends in it to lines, and with
+    ///        tokens, the token masks of its bytes to tokens
+    /// @pre from is where the previous scan ended (0 for the first), and
+    ///      tokens cover text[tokens->base, from) (restart(from) covers none)
+    void scan(std::string_view text, size_t from, size_t to, std::vector<LineSpan>& lines,
+              TextTokens* tokens = nullptr);
+
+    /// @brief Add the token masks of text[from, to) to tokens a byte at a
+    ///        time, without looking for lines
+    /// @pre tokens cover text[tokens.base, from)
+    static void classify(std::string_view text, size_t from, size_t to, TextTokens& tokens);
+
+    /// @brief End of text at size: append the last line if it has no newline
+    void finish(size_t size, std::vector<LineSpan>& lines);
+
+    /// @brief Line in progress, carried from one scan() to the next
+    struct State {
+        size_t lineStart = 0;
+        size_t comment = SIZE_MAX;   // First `#` of the line so far
+    };
+
+private:
+    ScanKernel kernel;
+    State state;
+};
+
+#endif // TASK_SCAN_HPP
@@ -0,0 +1,91 @@
+#ifndef TASK_SCHEDULER_HPP
+#define TASK_SCHEDULER_HPP
+
+// Standard Library
+#include <atomic>              // For std::atomic
+#include <condition_variable>  // For std::condition_variable
+#include <cstddef>             // For size_t
+#include <cstdint>             // For uint64_t
+#include <deque>               // For std::deque
+#include <functional>          // For std::function
+#include <memory>              // For std::unique_ptr
+#include <mutex>               // For std::mutex
+#include <thread>              // For std::thread
+#include <vector>              // For std::vector
+
+/// @brief Per-worker counters of a WorkStealingScheduler
+struct WorkerStats {
+    uint64_t tasksRun = 0;     // Task jobs executed by the worker
+    uint64_t chunksRun = 0;    // Chunk jobs executed by the worker
+    uint64_t steals = 0;       // Jobs taken from another worker's deque
+};
+
+/// @brief Work-stealing thread pool for task files and parse chunks
+///
+/// Every worker owns two deques: one of task jobs (whole task files) and one
+/// of chunk jobs (parsing a slice of a large task). A worker pops its own
+/// deques from the back and, once they are empty, steals from the front of
+/// the other workers' deques, preferring chunks so that a large task waiting
+/// on its parse-ahead is unblocked first.
+///
+/// A task job may wait for its chunks with helpWithChunks(): the waiting
+/// worker keeps running chunk jobs (never task jobs, which would reuse its
+/// per-worker state) until the condition holds.
+class WorkStealingScheduler {
+public:
+    using Job = std::function<void()>;
+
+    /// @brief Start the given number of worker threads (at least one)
+    explicit WorkStealingScheduler(size_t workers);
+
+    /// @brief Run every queued job, then stop and join the workers
+    ~WorkStealingScheduler();
+
+    WorkStealingScheduler(const WorkStealingScheduler&) = delete;
+    WorkStealingScheduler& operator=(const WorkStealingScheduler&) = delete;
+
+    /// @brief Queue a task job on the given worker's deque
+    void submitTask(size_t worker, Job job);
+
+    /// @brief Queue a chunk job on the calling worker's deque
+    /// @pre called from a job running on this scheduler
+    void submitChunk(Job job);
+
+    /// @brief Run chunk jobs on the calling worker until done() returns true
+    void helpWithChunks(const std::function<bool()>& done);
+
+    /// @brief Index of the worker running the calling job
+    /// @pre called from a job running on this scheduler
+    size_t currentWorker() const;
+
+    size_t workerCount() const { return workers.size(); }
+
+    /// @brief Snapshot of the per-worker counters
+    std::vector<WorkerStats> stats() const;
+
+private:
+    struct Worker {
+        std::mutex mutex;
+        std::deque<Job> tasks;
+        std::deque<Job> chunks;
+        std::atomic<uint64_t> tasksRun{0};
+        std::atomic<uint64_t> chunksRun{0};
+        std::atomic<uint64_t> steals{0};
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<std::thread> threads;
+
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+    std::atomic<size_t> queued{0};
+    bool stopping = false;
+
+    void workerLoop(size_t self);
+    void push(Worker& worker, std::deque<Job> Worker::*queue, Job job);
+    bool runOne(size_t self, bool chunksOnly);
+    bool popOwn(size_t self, std::deque<Job> Worker::*queue, Job& job);
+    bool steal(size_t self, std::deque<Job> Worker::*queue, Job& job);
+};
+
+#endif // TASK_SCHEDULER_HPP
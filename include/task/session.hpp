@@ -0,0 +1,109 @@
+#ifndef TASK_SESSION_HPP
+#define TASK_SESSION_HPP
+
+// Standard Library
+#include <cstddef>       // For size_t
+#include <cstdint>       // For uint64_t
+#include <optional>      // For std::optional
+#include <string>        // For std::string
+#include <string_view>   // For std::string_view
+
+// Project Headers
+#include "commands/render.hpp"   // For RenderCursor
+#include "output/buffered.hpp"   // For BufferedOutput
+#include "task/processor.hpp"    // For TaskProcessor
+#include "user/manager.hpp"      // For UserManager
+
+/// @brief A task fed incrementally, as its bytes arrive
+///
+/// Lines run as soon as their newline arrives, with the transcript and
+/// stop-on-failure rules of a task file: the task ends at EXIT, at the
+/// first line that fails, or at finish(). Input after the end is ignored.
+///
+/// Each call may be given room: about how many bytes of transcript it may
+/// write. Once they are written the session is blocked. Lines not yet run
+/// wait in it, as does the rest of a transcript stopped partway (a long
+/// PING or listing), until resume() is given more room.
+class TaskSession {
+private:
+    const TaskProcessor& processor;
+    std::string name;
+    UserManager& users;
+    BufferedOutput& out;
+    std::string input;       // Bytes not run yet: the start of a line whose newline has not arrived, after
+                             // whole lines while blocked
+    size_t tail = 0;         // Bytes of input after its last newline
+    bool overlong = false;   // The line in tail passed kMaxLineBytes; the task fails on reaching it
+    bool closing = false;    // finish() was called
+    bool ended = false;
+
+    // A command whose transcript stopped partway, re-parsed from its own
+    // copy of the line since the result views the command
+    std::string line;
+    std::optional<Command> command;
+    CommandResult result;
+    RenderCursor cursor;
+    TaskProcessor::LineOutcome outcome = TaskProcessor::LineOutcome::Continue;
+    bool rendering = false;
+
+    std::uint64_t stopAt(size_t room) const;
+
+    /// @brief Run the whole lines at the start of text until blocked or ended
+    /// @return Bytes of text used up
+    size_t runLines(std::string_view text, std::uint64_t limit);
+
+    /// @brief Run one line
+    /// @return false if its transcript stopped partway
+    bool runLine(std::string_view text, std::uint64_t limit);
+
+    /// @brief Go on with a transcript stopped partway
+    /// @return Whether it is complete now
+    bool continueRender(std::uint64_t limit);
+
+    /// @brief Keep bytes in input, for when the lines before them have run
+    void hold(std::string_view bytes);
+
+    /// @brief Run what input holds, and end the task once finished and done
+    void advance(std::uint64_t limit);
+
+    void settle(TaskProcessor::LineOutcome lineOutcome);
+    void end(bool completed);
+
+public:
+    /// @brief Longest line accepted; a longer one fails the task
+    static constexpr size_t kMaxLineBytes = size_t(1) << 20;
+
+    /// @brief Room enough for anything
+    static constexpr size_t kUnlimited = SIZE_MAX;
+
+    /// @brief Give users the processor's starting state (empty, or its
+    ///        snapshot's) and write the task's opening line to out; with
+    ///        shared state, commands run against that and users is unused
+    TaskSession(const TaskProcessor& processor, std::string name, UserManager& users, BufferedOutput& out);
+
+    TaskSession(const TaskSession&) = delete;
+    TaskSession& operator=(const TaskSession&) = delete;
+
+    /// @brief Run every line the bytes complete, as far as room allows
+    ///
+    /// Bytes given while blocked are kept too, so a caller with bounded
+    /// memory stops feeding until blocked() is false.
+    /// @return false once the task has ended
+    bool feed(std::string_view bytes, size_t room = kUnlimited);
+
+    /// @brief Go on with what is waiting, as far as room allows
+    /// @return false once the task has ended
+    bool resume(size_t room = kUnlimited);
+
+    /// @brief End of input: once the lines before it have run, run an
+    ///        unterminated last line, then close the task
+    void finish(size_t room = kUnlimited);
+
+    /// @brief Whether work is waiting for room: whole lines not run, or a
+    ///        transcript stopped partway
+    bool blocked() const { return !ended && (rendering || input.size() > tail); }
+
+    bool finished() const { return ended; }
+};
+
+#endif // TASK_SESSION_HPP
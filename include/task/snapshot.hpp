@@ -0,0 +1,73 @@
+#ifndef TASK_SNAPSHOT_HPP
+#define TASK_SNAPSHOT_HPP
+
+// Standard Library
+#include <cstddef>       // For size_t
+#include <cstdint>       // For uint32_t, uint64_t
+#include <string>        // For std::string
+
+// Project Headers
+#include "task/mapped.hpp"    // For MappedFile
+#include "user/manager.hpp"   // For UserManager
+
+/// @brief Binary image of a UserManager's state, mapped and loaded in one pass
+///
+/// Layout, integers little-endian:
+///   header   "WZHS", format version (u32), checksum of everything after
+///            the header (u64), user count (u32), group count (u32),
+///            generation (u64), total bytes of the user names (u64)
+///   groups   the name of every group with members: varint length, bytes
+///   users    per user: name (varint length, bytes), enabled flag (one
+///            byte), group count and the indices of its groups in the
+///            group section, ascending (varints), message count and every
+///            message, oldest first (varint length, bytes)
+///
+/// Opening checks every entry once. Loading then does no lookups beyond
+/// inserting the users, so it takes time in proportion to the size of the
+/// file, however many commands built the state. The generation orders a snapshot against a Journal: the journal
+/// of the same generation holds the commands that came after it.
+class Snapshot {
+public:
+    static constexpr std::uint32_t kVersion = 1;
+    static constexpr size_t kHeaderBytes = 40;
+
+    /// @brief Write the state of users to filename, replacing the file only
+    ///        once the new one is complete and synced
+    /// @throws std::runtime_error if the file cannot be written, or a string or
+    ///         list exceeds the format's 32-bit sizes
+    static void save(const UserManager& users, const std::string& filename, std::uint64_t generation = 0);
+
+    /// @brief Open filename and check all of it, so that restore() cannot
+    ///        fail later
+    /// @throws std::runtime_error if the file cannot be read, or the header,
+    ///         version, checksum or any entry is wrong
+    explicit Snapshot(const std::string& filename);
+
+    Snapshot(const Snapshot&) = delete;
+    Snapshot& operator=(const Snapshot&) = delete;
+
+    /// @brief Replace the state of users with the saved one
+    void restore(UserManager& users) const;
+
+    size_t userCount() const { return users; }
+    size_t groupCount() const { return groups; }
+    std::uint64_t generation() const { return snapshotGeneration; }
+    size_t bytes() const { return file.size(); }
+
+    /// @brief The header's checksum of the saved state, which tells two snapshots apart
+    std::uint64_t contentChecksum() const { return bodyChecksum; }
+
+private:
+    MappedFile file;
+    size_t users = 0;
+    size_t groups = 0;
+    std::uint64_t snapshotGeneration = 0;
+    std::uint64_t bodyChecksum = 0;
+    size_t nameBytes = 0;
+
+    /// @brief Walk the body as restore() reads it, throwing at the first
+    ///        malformed entry
+    void validate() const;
+};
+
+#endif // TASK_SNAPSHOT_HPP
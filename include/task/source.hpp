@@ -0,0 +1,78 @@
+#ifndef TASK_SOURCE_HPP
+#define TASK_SOURCE_HPP
+
+// Standard Library
+#include <cstddef>       // For size_t
+#include <optional>      // For std::optional
+#include <string>        // For std::string
+#include <string_view>   // For std::string_view
+#include <vector>        // For std::vector
+
+// Project Headers
+#include "parser/grammar.hpp"   // For grammar::Line
+#include "task/mapped.hpp"      // For MappedFile
+#include "task/scan.hpp"        // For LineScanner, LineSpan, TextTokens
+
+/// @brief The command on a raw task file line: the line with its `#` comment
+///        stripped and surrounding whitespace trimmed, empty if nothing is left
+std::string_view taskLineCommand(std::string_view line);
+
+/// @brief Lazily yields the commands lines of a task file
+///
+/// The file is memory-mapped and scanned on demand: each call to next()
+/// returns the following line that is not blank after taskLineCommand().
+/// Line ends and comments are found kScanBytes at a time by a LineScanner,
+/// so next() mostly reads the index it built. Once nextTokenized() is
+/// called, the scanner also classifies the bytes for the parser as they go
+/// by. Pages already consumed are handed back
+/// to the kernel as the scan advances, so resident memory stays around
+/// one release window instead of growing with the file. Returned views
+/// remain valid until the source is destroyed (released pages are simply
+/// read back from the file if touched again).
+///
+/// Files that cannot be mapped (pipes, character devices) are read into
+/// memory once instead.
+class TaskSource {
+private:
+    MappedFile file;
+    LineScanner scanner;
+    std::vector<LineSpan> lines;     // Lines of the last scanned piece
+    TextTokens tokens;               // Token masks of the last scanned piece, once tokenize is set
+    TextTokens lineTokens;           // Token masks of a line tokens do not cover
+    bool tokenize = false;
+    size_t nextLine = 0;             // Index into lines
+    size_t scanned = 0;              // End of the text scanned so far
+    size_t released = 0;             // Start of the mapped range not yet released
+
+    void releaseConsumed(size_t upTo);
+    bool scanMore();
+
+public:
+    /// @brief Bytes consumed between two releases of the mapping
+    static constexpr size_t kReleaseWindow = size_t(32) << 20;
+    /// @brief Bytes handed to the scanner at a time
+    static constexpr size_t kScanBytes = size_t(64) << 10;
+
+    /// @throws std::runtime_error if the file cannot be opened
+    explicit TaskSource(const std::string& filename);
+
+    /// @brief Scan a file that is already open
+    explicit TaskSource(MappedFile file);
+
+    TaskSource(const TaskSource&) = delete;
+    TaskSource& operator=(const TaskSource&) = delete;
+
+    /// @brief Get the next non-empty line, or std::nullopt at end of file
+    std::optional<std::string_view> next();
+
+    /// @brief Get the next non-empty line with its token masks, valid
+    ///        until the next call
+    std::optional<grammar::Line> nextTokenized();
+
+    /// @brief Total size of the task file in bytes
+    size_t bytes() const { return file.size(); }
+
+    ScanKernel kernel() const { return scanner.kernelUsed(); }
+};
+
+#endif // TASK_SOURCE_HPP
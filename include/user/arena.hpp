@@ -0,0 +1,99 @@
+#ifndef USER_ARENA_HPP
+#define USER_ARENA_HPP
+
+// Standard Library
+#include <cstddef>            // For size_t, std::byte
+#include <cstdint>            // For uint64_t
+#include <memory>             // For std::unique_ptr
+#include <memory_resource>    // For std::pmr::memory_resource
+#include <optional>           // For std::optional
+
+/// @brief Forwards to another resource, counting what it is asked for
+class CountingResource : public std::pmr::memory_resource {
+private:
+    std::pmr::memory_resource* upstream;
+    std::uint64_t allocationCount = 0;
+    std::uint64_t byteCount = 0;
+
+public:
+    explicit CountingResource(std::pmr::memory_resource* upstream) : upstream(upstream) {}
+
+    std::uint64_t allocations() const { return allocationCount; }
+    std::uint64_t bytes() const { return byteCount; }
+
+private:
+    void* do_allocate(size_t bytes, size_t alignment) override {
+        ++allocationCount;
+        byteCount += bytes;
+        return upstream->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override {
+        upstream->deallocate(p, bytes, alignment);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+};
+
+/// @brief Allocation counters of a TaskArena
+struct AllocationStats {
+    std::uint64_t requests = 0;          // Allocations served to containers
+    std::uint64_t systemAllocations = 0; // Buffers and overflow blocks taken from operator new
+    std::uint64_t systemBytes = 0;
+    std::uint64_t resets = 0;
+    size_t bufferBytes = 0;              // Current size of the reusable buffer
+
+    AllocationStats& operator+=(const AllocationStats& other) {
+        requests += other.requests;
+        systemAllocations += other.systemAllocations;
+        systemBytes += other.systemBytes;
+        resets += other.resets;
+        bufferBytes += other.bufferBytes;
+        return *this;
+    }
+};
+
+/// @brief Memory for the state of one task at a time
+///
+/// Containers allocate from a pool (which recycles freed blocks within the
+/// task) carved out of a monotonic buffer. reset() drops everything at
+/// once without visiting individual allocations. The buffer is kept across
+/// resets; when a task outgrew it, it is replaced by one as large as that
+/// task's high-water mark, so a run of similar tasks stops reaching the
+/// system allocator after the first.
+///
+/// Not thread-safe: each arena serves a single thread at a time.
+class TaskArena {
+private:
+    CountingResource system{std::pmr::new_delete_resource()};
+    std::unique_ptr<std::byte[]> buffer;
+    size_t bufferSize = 0;
+    std::uint64_t systemBytesAtReset = 0;
+    std::optional<std::pmr::monotonic_buffer_resource> monotonic;
+    std::optional<std::pmr::unsynchronized_pool_resource> pool;
+    std::optional<CountingResource> front;
+    std::uint64_t requestsBeforeReset = 0;
+    std::uint64_t resetCount = 0;
+    std::uint64_t bufferAllocations = 0;
+    std::uint64_t bufferBytes = 0;
+
+    void rebuild();
+
+public:
+    TaskArena();
+
+    TaskArena(const TaskArena&) = delete;
+    TaskArena& operator=(const TaskArena&) = delete;
+
+    std::pmr::memory_resource* resource() { return &*front; }
+
+    /// @brief Release every allocation at once
+    /// @pre nothing allocated from resource() is used afterwards
+    void reset();
+
+    AllocationStats stats() const;
+};
+
+#endif // USER_ARENA_HPP
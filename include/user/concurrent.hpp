@@ -0,0 +1,104 @@
+#ifndef USER_CONCURRENT_HPP
+#define USER_CONCURRENT_HPP
+
+// Standard Library
+#include <cstddef>        // For size_t
+#include <cstdint>        // For uint64_t, SIZE_MAX
+#include <memory>         // For std::unique_ptr
+#include <optional>       // For std::optional
+#include <string>         // For std::string
+#include <string_view>    // For std::string_view
+#include <vector>         // For std::vector
+
+/// @brief User database shared by many threads
+///
+/// Task processing gives every task a UserManager of its own; with
+/// ProcessorOptions::sharedState every task runs against one of these
+/// instead, so tasks running at the same time see each other's changes.
+/// It offers everything a command needs.
+///
+/// Users are spread over shards by a hash of their name. Each shard is a
+/// UserManager holding its users together with their group memberships and
+/// messages, behind its own reader-writer lock, so operations on different
+/// users rarely meet and lookups of the same shard run side by side. A
+/// group exists while a member in any shard has it.
+///
+/// Atomicity:
+///   - Every operation on one user (create, delete, disable, send a
+///     message, join or leave a group, read its history) runs under that
+///     user's shard lock and is atomic.
+///   - createUsers and addUsersToGroup lock every shard they touch, in
+///     shard order, for the whole operation: they change all the users or
+///     none, and no other thread sees a part of the change.
+///   - usersExist takes the shards of its names together, and getUsers and
+///     getGroups every shard, in shared mode, so each answer is a
+///     consistent snapshot.
+///   - Nothing spans two calls: a command sees the state as of its own
+///     call only.
+///
+/// Unlike UserManager, listings and histories are copied out, since
+/// another thread may change the state as soon as the call returns.
+class ConcurrentUserManager {
+public:
+    static constexpr size_t kMaxShards = 64;
+
+    /// @param shards rounded up to a power of two, at most kMaxShards
+    explicit ConcurrentUserManager(size_t shards = kMaxShards);
+    ~ConcurrentUserManager();
+
+    ConcurrentUserManager(const ConcurrentUserManager&) = delete;
+    ConcurrentUserManager& operator=(const ConcurrentUserManager&) = delete;
+
+    size_t shardCount() const { return shardMask + 1; }
+
+    /// @brief Shard holding the user of that name
+    size_t shardOf(std::string_view username) const;
+
+    /// @brief Forget every user and group
+    void reset();
+
+    bool createUser(std::string_view username);
+
+    /// @brief Create all the users, or none if a name is taken or repeated
+    bool createUsers(const std::string_view* usernames, size_t count);
+    bool deleteUser(std::string_view username);
+    bool disableUser(std::string_view username);
+    bool userExists(std::string_view username) const;
+
+    /// @brief Bit i set when names[i] is an existing user
+    /// @pre count <= 64
+    std::uint64_t usersExist(const std::string_view* names, size_t count) const;
+    bool isUserEnabled(std::string_view username) const;
+    bool sendMessage(std::string_view username, std::string_view message);
+    bool addUserToGroup(std::string_view username, std::string_view group);
+
+    /// @brief Add all the users to group, or none if one of them does not exist
+    bool addUsersToGroup(const std::string_view* usernames, size_t count, std::string_view group);
+    bool removeUserFromGroup(std::string_view username, std::string_view group);
+
+    /// @brief Users in name order, those starting with prefix only if it is given
+    std::vector<std::string> getUsers(std::string_view prefix = {}) const;
+
+    /// @brief Groups with a member in any shard, in name order
+    std::vector<std::string> getGroups() const;
+
+    /// @brief Up to limit messages of the user, starting with the from-th
+    ///        (0-based); std::nullopt if there is no such user
+    std::optional<std::vector<std::string>> getMessageHistory(std::string_view username, size_t from = 0,
+                                                              size_t limit = SIZE_MAX) const;
+
+private:
+    struct Shard;
+
+    std::unique_ptr<Shard[]> shards;
+    size_t shardMask;
+
+    /// @brief Bit s set for every shard s holding one of the names
+    std::uint64_t shardsOf(const std::string_view* names, size_t count) const;
+    std::uint64_t allShards() const;
+
+    /// @brief The names that fall in each shard, indexed by shard
+    std::vector<std::vector<std::string_view>> byShard(const std::string_view* names, size_t count) const;
+};
+
+#endif // USER_CONCURRENT_HPP
@@ -0,0 +1,54 @@
+#ifndef USER_INTERNER_HPP
+#define USER_INTERNER_HPP
+
+// Standard Library
+#include <cstddef>        // For size_t
+#include <cstdint>        // For uint32_t
+#include <memory_resource>  // For std::pmr::memory_resource
+#include <optional>       // For std::optional
+#include <string_view>    // For std::string_view
+#include <vector>         // For std::pmr::vector
+
+// Project Headers
+#include "user/text.hpp"  // For TextArena
+
+/// @brief Maps distinct strings to dense integer IDs
+///
+/// Every string is stored once, in a TextArena, and gets the next ID
+/// (0, 1, 2, ...) the first time it is interned. The lookup index is an
+/// open-addressing table of IDs, so it costs four bytes per slot on top
+/// of the text itself. IDs and the views returned by name() stay valid
+/// until clear(). All memory comes from the given resource.
+class StringInterner {
+public:
+    using Id = std::uint32_t;
+
+    explicit StringInterner(std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+    StringInterner(const StringInterner&) = delete;
+    StringInterner& operator=(const StringInterner&) = delete;
+
+    /// @brief ID of text, adding it if it is new
+    Id intern(std::string_view text);
+
+    /// @brief ID of text if it has been interned
+    std::optional<Id> find(std::string_view text) const;
+
+    std::string_view name(Id id) const { return names[id]; }
+    size_t size() const { return names.size(); }
+
+    void clear();
+
+private:
+    static constexpr Id kEmpty = ~Id(0);
+
+    std::pmr::memory_resource* resource;
+    TextArena strings;
+    std::pmr::vector<std::string_view> names;  // Indexed by ID, viewing strings
+    std::pmr::vector<Id> slots;                // Power-of-two sized, linear probing
+
+    size_t probe(std::string_view text) const; // Slot holding text, or the empty slot it belongs in
+    void grow();
+};
+
+#endif // USER_INTERNER_HPP
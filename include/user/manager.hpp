@@ -1,34 +1,121 @@
 #ifndef USER_MANAGER_HPP
 #define USER_MANAGER_HPP
 
-#include <memory>
+#include <cstdint>
+#include <memory_resource>
+#include <optional>
 #include <string>
-#include <unordered_map>
-#include <unordered_set>
+#include <string_view>
 #include <vector>
 
+#include "user/arena.hpp"
+#include "user/interner.hpp"
+#include "user/messages.hpp"
+#include "user/range.hpp"
+#include "user/store.hpp"
 #include "user/user.hpp"
 
 class UserManager {
 private:
-    std::unordered_map<std::string, std::unique_ptr<User>> users;
-    std::unordered_set<std::string> groups;
+    // Users live in a structure-of-arrays store; group names are interned
+    // once and groups are then plain vectors indexed by their dense IDs
+    struct State {
+        UserStore users;
+        MessageLog messages;
+        StringInterner groupNames;
+        std::pmr::vector<std::uint32_t> groupMembers;   // Member count, indexed by GroupId; a group exists while it is non-zero
+        std::pmr::vector<std::string_view> sortedGroups; // Names of the existing groups, kept sorted
+
+        // Sorted user listing, brought up to date by the listing getters.
+        // Creates since the last sort are merged in rather than re-sorting
+        // everything; the names are re-read after any create or delete
+        // because the store's name arena may have moved.
+        std::pmr::vector<UserId> sortedUsers;
+        std::pmr::vector<UserId> newUsers;               // Created since sortedUsers was built, unsorted
+        std::pmr::vector<std::string_view> sortedUserNames;
+        bool sortedUsersBuilt = false;
+        bool usersDeleted = false;                       // Since sortedUsers was built
+        bool userNamesStale = true;
+
+        explicit State(std::pmr::memory_resource* resource)
+            : users(resource), messages(resource), groupNames(resource), groupMembers(resource),
+              sortedGroups(resource), sortedUsers(resource), newUsers(resource), sortedUserNames(resource) {}
+    };
+
+    // Everything in the state allocates from the arena, so reset() and the
+    // destructor release the arena wholesale and never run ~State: there is
+    // nothing left for it to free
+    TaskArena arena;
+    alignas(State) unsigned char storage[sizeof(State)];
+    State* state;
+
+    void userCreated(UserId id);
+    void refreshUserListing() const;
+    GroupId groupIdFor(std::string_view group);
+    void groupAppeared(GroupId group);
+    void groupVanished(GroupId group);
+
+    // Saves and restores the state wholesale
+    friend class Snapshot;
 
 public:
+    UserManager();
+    ~UserManager() = default;
+
+    UserManager(const UserManager&) = delete;
+    UserManager& operator=(const UserManager&) = delete;
+
+    /// @brief Forget every user and group, in O(1)
     void reset();
+
+    /// @brief Allocation counters of the state, across resets
+    AllocationStats allocationStats() const { return arena.stats(); }
     
-    bool createUser(const std::string& username);
-    bool deleteUser(const std::string& username);
-    bool disableUser(const std::string& username);
-    bool userExists(const std::string& username) const;
-    bool isUserEnabled(const std::string& username) const;
-    bool sendMessage(const std::string& username, const std::string& message);
-    bool addUserToGroup(const std::string& username, const std::string& group);
-    bool removeUserFromGroup(const std::string& username, const std::string& group);
+    /// @brief Resolve a username once, for commands that touch the user several times
+    std::optional<UserId> findUser(std::string_view username) const { return state->users.find(username); }
+    std::string_view username(UserId id) const { return state->users.name(id); }
+
+    bool createUser(std::string_view username);
+
+    /// @brief Create all the users, or none if a name is taken or repeated
+    bool createUsers(const std::string_view* usernames, size_t count);
+    bool deleteUser(std::string_view username);
+    bool disableUser(std::string_view username);
+    bool userExists(std::string_view username) const;
+
+    /// @brief Bit i set when names[i] is an existing user
+    /// @pre count <= 64
+    std::uint64_t usersExist(const std::string_view* names, size_t count) const;
+    bool isUserEnabled(std::string_view username) const;
+    bool sendMessage(std::string_view username, std::string_view message);
+    bool addUserToGroup(std::string_view username, std::string_view group);
+
+    /// @brief Add all the users to group, or none if one of them does not exist
+    bool addUsersToGroup(const std::string_view* usernames, size_t count, std::string_view group);
+    bool removeUserFromGroup(std::string_view username, std::string_view group);
+
+    // By ID; the user must exist
+    bool isUserEnabled(UserId id) const { return state->users.enabled(id); }
+    bool sendMessage(UserId id, std::string_view message);
+    void addUserToGroup(UserId id, std::string_view group);
+    void removeUserFromGroup(UserId id, std::string_view group);
     
-    std::vector<std::string> getUsers() const;
-    std::vector<std::string> getGroups() const;
-    std::vector<std::string> getMessageHistory(const std::string& username) const;
+    /// @brief Users in name order, those starting with prefix only if it is given
+    ///
+    /// Repeated calls without a change in between reuse the sorted listing;
+    /// after changes, new users are merged into it. Qualifies as const for
+    /// callers, but updates the listing cache, so calls must not overlap.
+    ViewRange getUsers(std::string_view prefix = {}) const;
+
+    /// @brief Groups in name order; maintained as groups appear and vanish
+    ViewRange getGroups() const;
+
+    /// @brief Up to limit messages of the user, starting with the from-th (0-based)
+    ///
+    /// A view into the message log: nothing is copied, and the range is empty
+    /// past the end of the history.
+    MessageRange getMessageHistory(std::string_view username, size_t from = 0, size_t limit = SIZE_MAX) const;
+    MessageRange getMessageHistory(UserId id, size_t from = 0, size_t limit = SIZE_MAX) const;
 };
 
-#endif // USER_MANAGER_HPP
\ No newline at end of file
+#endif // USER_MANAGER_HPP
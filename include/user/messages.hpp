@@ -0,0 +1,46 @@
+#ifndef USER_MESSAGES_HPP
+#define USER_MESSAGES_HPP
+
+// Standard Library
+#include <cstddef>           // For size_t
+#include <memory_resource>   // For std::pmr::memory_resource
+#include <string_view>       // For std::string_view
+
+// Project Headers
+#include "user/range.hpp"    // For ViewRange
+#include "user/text.hpp"     // For TextArena
+
+/// @brief Append-only log of every message sent during a task
+///
+/// Message bytes go back to back into a shared TextArena; users keep the
+/// views of their own messages. Nothing is removed before clear(), so a
+/// deleted user's messages stay in the log (unreachable) until the task
+/// ends.
+class MessageLog {
+public:
+    explicit MessageLog(std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : text(resource) {}
+
+    /// @brief Store a message; the view stays valid until clear()
+    std::string_view append(std::string_view message) {
+        ++count;
+        return text.store(message);
+    }
+
+    size_t size() const { return count; }
+
+    void clear() {
+        text.clear();
+        count = 0;
+    }
+
+private:
+    TextArena text;
+    size_t count = 0;
+};
+
+/// @brief Messages of one user, oldest first; valid until the next message
+/// is sent to that user or the log is cleared
+using MessageRange = ViewRange;
+
+#endif // USER_MESSAGES_HPP
@@ -0,0 +1,54 @@
+#ifndef USER_RANGE_HPP
+#define USER_RANGE_HPP
+
+// Standard Library
+#include <cstddef>        // For size_t
+#include <string>         // For std::string
+#include <string_view>    // For std::string_view
+#include <utility>        // For std::move
+#include <vector>         // For std::vector
+
+/// @brief Non-owning run of string views kept by UserManager
+///
+/// Listings and message histories are handed out as ranges into storage
+/// the manager maintains anyway, so returning one copies nothing. A range
+/// is valid until the next change to the data it lists.
+class ViewRange {
+private:
+    const std::string_view* first = nullptr;
+    const std::string_view* last = nullptr;
+
+public:
+    ViewRange() = default;
+    ViewRange(const std::string_view* first, const std::string_view* last) : first(first), last(last) {}
+
+    const std::string_view* begin() const { return first; }
+    const std::string_view* end() const { return last; }
+    size_t size() const { return static_cast<size_t>(last - first); }
+    bool empty() const { return first == last; }
+};
+
+/// @brief Strings copied out of storage that may change meanwhile, with a
+///        ViewRange over them
+///
+/// ConcurrentUserManager hands out copies, since another thread may change
+/// its state as soon as a call returns; this gives them the same shape as
+/// the views of a UserManager.
+class OwnedRange {
+private:
+    std::vector<std::string> strings;
+    std::vector<std::string_view> views;
+
+public:
+    explicit OwnedRange(std::vector<std::string> copied) : strings(std::move(copied)) {
+        views.assign(strings.begin(), strings.end());
+    }
+
+    // The views point into strings
+    OwnedRange(const OwnedRange&) = delete;
+    OwnedRange& operator=(const OwnedRange&) = delete;
+
+    ViewRange range() const { return {views.data(), views.data() + views.size()}; }
+};
+
+#endif // USER_RANGE_HPP
@@ -0,0 +1,122 @@
+#ifndef USER_STORE_HPP
+#define USER_STORE_HPP
+
+// Standard Library
+#include <cstddef>        // For size_t
+#include <cstdint>        // For uint8_t, uint32_t
+#include <memory_resource>  // For std::pmr::memory_resource
+#include <optional>       // For std::optional
+#include <string_view>    // For std::string_view
+#include <utility>        // For std::pair
+#include <vector>         // For std::pmr::vector
+
+// Project Headers
+#include "user/user.hpp"  // For UserId, GroupId
+
+/// @brief Structure-of-arrays storage of users
+///
+/// Each attribute is a column indexed by UserId, so a scan over one of
+/// them (flags for a listing, say) reads memory sequentially. Names are
+/// packed into one character arena and found through a Robin Hood
+/// open-addressing index of eight-byte buckets. Slots of deleted users
+/// go on a free list and are handed out again by insert(). Every column,
+/// message and group list allocates from the given resource.
+class UserStore {
+public:
+    using MessageList = std::pmr::vector<std::string_view>;   // Views into the MessageLog, in sending order
+    using GroupList = std::pmr::vector<GroupId>;
+
+    explicit UserStore(std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+    /// @brief Slot of name if such a user exists
+    std::optional<UserId> find(std::string_view name) const;
+
+    /// @brief find() for count names at once, results in ids[0..count)
+    ///
+    /// All names are hashed and their home buckets fetched before the first
+    /// probe, so the cache misses of the lookups overlap.
+    void findMany(const std::string_view* names, size_t count, std::optional<UserId>* ids) const;
+
+    /// @brief Add a user (enabled, no messages or groups)
+    /// @return its slot, and false if the name was taken already
+    std::pair<UserId, bool> insert(std::string_view name);
+
+    /// @brief insert() for count names at once, their slots in ids
+    ///
+    /// Stops at the first name that is taken, returning its position
+    /// (count if all were inserted). Hashes and bucket fetches are batched
+    /// as in findMany().
+    size_t insertMany(const std::string_view* names, size_t count, UserId* ids);
+
+    /// @brief Make room for count more users with nameBytes of names in total
+    void reserve(size_t count, size_t nameBytes);
+
+    /// @brief Remove a live user and free its slot
+    void erase(UserId id);
+
+    void clear();
+
+    /// @brief Number of live users
+    size_t size() const { return liveCount; }
+
+    /// @brief One past the highest slot in use; slots below it may be free
+    UserId slotCount() const { return static_cast<UserId>(flags.size()); }
+
+    bool live(UserId id) const { return flags[id] & kLive; }
+    bool enabled(UserId id) const { return flags[id] & kEnabled; }
+    void disable(UserId id) { flags[id] &= static_cast<std::uint8_t>(~kEnabled); }
+
+    /// @brief Name of a live user; valid until the next insert or erase
+    std::string_view name(UserId id) const {
+        return {arena.data() + handles[id].offset, handles[id].length};
+    }
+
+    MessageList& messages(UserId id) { return messageLists[id]; }
+    const MessageList& messages(UserId id) const { return messageLists[id]; }
+
+    /// @brief Groups of the user, sorted
+    GroupList& groups(UserId id) { return groupLists[id]; }
+    const GroupList& groups(UserId id) const { return groupLists[id]; }
+
+private:
+    static constexpr std::uint8_t kLive = 1;
+    static constexpr std::uint8_t kEnabled = 2;
+
+    struct NameHandle {
+        std::uint32_t offset;
+        std::uint32_t length;
+    };
+
+    // Index bucket; id == kEmpty marks a free bucket. The hash is kept so
+    // probing compares names only on a full hash match and growing never
+    // rehashes a name.
+    struct Bucket {
+        UserId id;
+        std::uint32_t hash;
+    };
+    static constexpr UserId kEmpty = ~UserId(0);
+
+    // Columns, indexed by UserId
+    std::pmr::vector<std::uint8_t> flags;
+    std::pmr::vector<NameHandle> handles;
+    std::pmr::vector<MessageList> messageLists;
+    std::pmr::vector<GroupList> groupLists;
+
+    std::pmr::vector<char> arena;     // Names of live (and not yet compacted dead) users
+    size_t deadBytes = 0;             // Arena bytes of erased names
+    std::pmr::vector<UserId> freeSlots;
+    size_t liveCount = 0;
+
+    std::pmr::vector<Bucket> buckets; // Power-of-two sized
+
+    static std::uint32_t hashName(std::string_view name);
+    size_t distance(size_t bucket) const;     // From the bucket's home position
+    size_t locate(std::string_view text, std::uint32_t hash) const;  // Bucket index, or buckets.size()
+    void place(Bucket entry);
+    void grow();
+    std::pair<UserId, bool> insert(std::string_view name, std::uint32_t hash);
+    void rehash(size_t bucketCount);
+    void compactArena();
+};
+
+#endif // USER_STORE_HPP
@@ -0,0 +1,41 @@
+#ifndef USER_TEXT_HPP
+#define USER_TEXT_HPP
+
+// Standard Library
+#include <cstddef>           // For size_t
+#include <memory_resource>   // For std::pmr::memory_resource
+#include <string_view>       // For std::string_view
+#include <utility>           // For std::pair
+#include <vector>            // For std::pmr::vector
+
+/// @brief Append-only storage of string bytes in large blocks
+///
+/// Stored text never moves, so the returned views stay valid until clear()
+/// or destruction. Strings longer than a quarter block get a block of
+/// their own so the current one keeps its space.
+class TextArena {
+private:
+    static constexpr size_t kBlockBytes = size_t(64) << 10;
+
+    std::pmr::memory_resource* resource;
+    std::pmr::vector<std::pair<char*, size_t>> blocks;
+    char* cursor = nullptr;    // Free space of the current block
+    size_t blockFree = 0;
+
+    char* allocateBlock(size_t bytes);
+
+public:
+    explicit TextArena(std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : resource(resource), blocks(resource) {}
+    ~TextArena() { clear(); }
+
+    TextArena(const TextArena&) = delete;
+    TextArena& operator=(const TextArena&) = delete;
+
+    /// @brief Copy text into the arena
+    std::string_view store(std::string_view text);
+
+    void clear();
+};
+
+#endif // USER_TEXT_HPP
@@ -2,16 +2,12 @@
 #define USER_USER_HPP
 
 // Standard Library
-#include <string>            // For std::string
-#include <unordered_set>     // For std::unordered_set
-#include <vector>           // For std::vector
+#include <cstdint>           // For uint32_t
 
-// User data structures
-struct User {
-    std::string username;
-    bool enabled = true;
-    std::vector<std::string> messages;
-    std::unordered_set<std::string> groups;
-};
+/// @brief Slot of a user in the UserStore; reused after the user is deleted
+using UserId = std::uint32_t;
+
+/// @brief Dense ID of an interned group name
+using GroupId = std::uint32_t;
 
 #endif // USER_USER_HPP
@@ -0,0 +1,42 @@
+#ifndef UTIL_BITS_HPP
+#define UTIL_BITS_HPP
+
+// Standard Library
+#include <cstdint>
+
+/// @brief Bit scans over 64-bit masks
+///
+/// A single instruction with GCC and Clang; other compilers get a portable
+/// loop. The mask must not be zero.
+namespace bits {
+
+/// @brief Index of the lowest set bit
+inline unsigned lowest(std::uint64_t mask) {
+#if defined(__GNUC__) || defined(__clang__)
+    return static_cast<unsigned>(__builtin_ctzll(mask));
+#else
+    unsigned bit = 0;
+    while ((mask & 1) == 0) {
+        mask >>= 1;
+        ++bit;
+    }
+    return bit;
+#endif
+}
+
+/// @brief Index of the highest set bit
+inline unsigned highest(std::uint64_t mask) {
+#if defined(__GNUC__) || defined(__clang__)
+    return 63u - static_cast<unsigned>(__builtin_clzll(mask));
+#else
+    unsigned bit = 0;
+    while (mask >>= 1) {
+        ++bit;
+    }
+    return bit;
+#endif
+}
+
+} // namespace bits
+
+#endif // UTIL_BITS_HPP
@@ -1,114 +1,197 @@
 #include "commands/executor.hpp"
+#include "user/concurrent.hpp"
+#include <memory>
+#include <utility>
 
-CommandResult CreateUserExecutor::execute(const Command& cmd, UserManager& userManager) {
-    const auto& createCmd = std::get<CreateUserCommand>(cmd);
-    if (userManager.createUser(createCmd.username)) {
-        return {true, fmt::format("✅ CREATE USER {}", createCmd.username)};
+// Executors only record what happened; renderResult turns it into text
+
+namespace {
+
+// Views of every name of a bulk command; range names are formatted into storage
+std::vector<std::string_view> collectNames(const NameList& list, std::string& storage) {
+    std::vector<std::string_view> names;
+    names.reserve(list.count());
+    if (list.isRange) {
+        // Reserved for the longest possible names, so the views stay put
+        storage.reserve(list.count() * (list.text.size() + 11));
     }
-    return {false, fmt::format("❌ CREATE USER {} (Failed: User already exists)", createCmd.username)};
+    list.forEach([&](std::string_view name) {
+        if (list.isRange) {
+            storage.append(name);
+            name = std::string_view(storage).substr(storage.size() - name.size());
+        }
+        names.push_back(name);
+    });
+    return names;
+}
+
+/// @brief Copies out of a shared store, kept alive by the result that views them
+std::shared_ptr<const OwnedRange> own(std::vector<std::string> copied) {
+    return std::make_shared<const OwnedRange>(std::move(copied));
 }
 
-CommandResult DeleteUserExecutor::execute(const Command& cmd, UserManager& userManager) {
-    const auto& deleteCmd = std::get<DeleteUserCommand>(cmd);
-    if (userManager.deleteUser(deleteCmd.username)) {
-        return {true, fmt::format("✅ DELETE USER {}", deleteCmd.username)};
+} // namespace
+
+template<typename Users>
+CommandResult CreateUserExecutor::run(const CreateUserCommand& createCmd, Users& users) {
+    if (users.createUser(createCmd.username)) {
+        return {ResultStatus::Ok};
     }
-    return {false, fmt::format("❌ DELETE USER {} (Failed: User does not exist)", deleteCmd.username)};
+    return {ResultStatus::UserExists};
 }
 
-CommandResult DisableUserExecutor::execute(const Command& cmd, UserManager& userManager) {
-    const auto& disableCmd = std::get<DisableUserCommand>(cmd);
-    if (userManager.disableUser(disableCmd.username)) {
-        return {true, fmt::format("✅ DISABLE USER {}", disableCmd.username)};
+template<typename Users>
+CommandResult CreateUsersExecutor::run(const CreateUsersCommand& createCmd, Users& users) {
+    std::string storage;
+    auto names = collectNames(createCmd.names, storage);
+    if (users.createUsers(names.data(), names.size())) {
+        return {ResultStatus::Ok};
     }
-    return {false, fmt::format("❌ DISABLE USER {} (Failed: User does not exist)", disableCmd.username)};
+    return {ResultStatus::UserExists};
 }
 
-CommandResult SendMessageExecutor::execute(const Command& cmd, UserManager& userManager) {
-    const auto& sendCmd = std::get<SendMessageCommand>(cmd);
-    if (userManager.sendMessage(sendCmd.username, sendCmd.message)) {
-        return {true, fmt::format("✅ SEND MESSAGE {} \"{}\"", sendCmd.username, sendCmd.message)};
+template<typename Users>
+CommandResult DeleteUserExecutor::run(const DeleteUserCommand& deleteCmd, Users& users) {
+    if (users.deleteUser(deleteCmd.username)) {
+        return {ResultStatus::Ok};
     }
-    return {false, fmt::format("❌ SEND MESSAGE {} \"{}\" (Failed: User does not exist)", sendCmd.username, sendCmd.message)};
+    return {ResultStatus::UserNotFound};
 }
 
-CommandResult PingExecutor::execute(const Command& cmd, UserManager& userManager) {
-    const auto& pingCmd = std::get<PingCommand>(cmd);
-    std::string result = fmt::format("✅ Send ping to {} ({}):\n", pingCmd.username, pingCmd.times);
-    
-    for (int i = 0; i < pingCmd.times; ++i) {
-        result += fmt::format("Sent ping to {}\n", pingCmd.username);
-        if (userManager.userExists(pingCmd.username)) {
-            result += fmt::format("{} received a ping\n", pingCmd.username);
-        }
+template<typename Users>
+CommandResult DisableUserExecutor::run(const DisableUserCommand& disableCmd, Users& users) {
+    if (users.disableUser(disableCmd.username)) {
+        return {ResultStatus::Ok};
     }
-    
-    return {true, result};
+    return {ResultStatus::UserNotFound};
 }
 
-CommandResult AddUserToGroupExecutor::execute(const Command& cmd, UserManager& userManager) {
-    const auto& addCmd = std::get<AddUserToGroupCommand>(cmd);
-    if (userManager.addUserToGroup(addCmd.username, addCmd.group)) {
-        return {true, fmt::format("✅ ADD USER {} TO GROUP {}", addCmd.username, addCmd.group)};
+template<typename Users>
+CommandResult SendMessageExecutor::run(const SendMessageCommand& sendCmd, Users& users) {
+    if (users.sendMessage(sendCmd.username, sendCmd.message)) {
+        return {ResultStatus::Ok};
     }
-    return {false, fmt::format("❌ ADD USER {} TO GROUP {} (Failed: User does not exist)", addCmd.username, addCmd.group)};
+    return {ResultStatus::UserNotFound};
 }
 
-CommandResult RemoveUserFromGroupExecutor::execute(const Command& cmd, UserManager& userManager) {
-    const auto& removeCmd = std::get<RemoveUserFromGroupCommand>(cmd);
-    if (userManager.removeUserFromGroup(removeCmd.username, removeCmd.group)) {
-        return {true, fmt::format("✅ REMOVE USER {} FROM GROUP {}", removeCmd.username, removeCmd.group)};
+template<typename Users>
+CommandResult PingExecutor::run(const PingCommand& pingCmd, Users& users) {
+    // Pings always succeed; who answers is the same for every repetition,
+    // so all targets are looked up once, together
+    std::string_view names[PingCommand::kMaxTargets];
+    size_t count = pingCmd.splitTargets(names);
+    CommandResult result{ResultStatus::Ok};
+    result.answered = users.usersExist(names, count);
+    std::uint64_t everyone = count == PingCommand::kMaxTargets ? ~std::uint64_t(0) : (std::uint64_t(1) << count) - 1;
+    if (pingCmd.times > 0 && result.answered != everyone) {
+        result.status = ResultStatus::Unanswered;
     }
-    return {false, fmt::format("❌ REMOVE USER {} FROM GROUP {} (Failed: User does not exist)", removeCmd.username, removeCmd.group)};
-}
-
-CommandResult GetUsersExecutor::execute([[maybe_unused]] const Command& cmd, UserManager& userManager) {
-    auto users = userManager.getUsers();
-    std::string result = "✅ GET USERS\nUsers: ";
-    if (users.empty()) {
-        result += "(none)";
-    } else {
-        for (size_t i = 0; i < users.size(); ++i) {
-            if (i > 0) result += ", ";
-            result += users[i];
-        }
+    return result;
+}
+
+template<typename Users>
+CommandResult AddUserToGroupExecutor::run(const AddUserToGroupCommand& addCmd, Users& users) {
+    if (users.addUserToGroup(addCmd.username, addCmd.group)) {
+        return {ResultStatus::Ok};
     }
-    return {true, result};
-}
-
-CommandResult GetGroupsExecutor::execute([[maybe_unused]] const Command& cmd, UserManager& userManager) {
-    auto groups = userManager.getGroups();
-    std::string result = "✅ GET GROUPS\nGroups: ";
-    if (groups.empty()) {
-        result += "(none)";
-    } else {
-        for (size_t i = 0; i < groups.size(); ++i) {
-            if (i > 0) result += ", ";
-            result += groups[i];
-        }
+    return {ResultStatus::UserNotFound};
+}
+
+template<typename Users>
+CommandResult AddUsersToGroupExecutor::run(const AddUsersToGroupCommand& addCmd, Users& users) {
+    std::string storage;
+    auto names = collectNames(addCmd.names, storage);
+    if (users.addUsersToGroup(names.data(), names.size(), addCmd.group)) {
+        return {ResultStatus::Ok};
     }
-    return {true, result};
+    return {ResultStatus::UserNotFound};
 }
 
-CommandResult GetMessageHistoryExecutor::execute(const Command& cmd, UserManager& userManager) {
-    const auto& historyCmd = std::get<GetMessageHistoryCommand>(cmd);
-    if (!userManager.userExists(historyCmd.username)) {
-        return {false, fmt::format("❌ GET MESSAGE HISTORY {} (Failed: User does not exist)", historyCmd.username)};
+template<typename Users>
+CommandResult RemoveUserFromGroupExecutor::run(const RemoveUserFromGroupCommand& removeCmd, Users& users) {
+    if (users.removeUserFromGroup(removeCmd.username, removeCmd.group)) {
+        return {ResultStatus::Ok};
     }
-    
-    auto messages = userManager.getMessageHistory(historyCmd.username);
-    std::string result = fmt::format("✅ GET MESSAGE HISTORY {}\nMessages: ", historyCmd.username);
-    if (messages.empty()) {
-        result += "(none)";
-    } else {
-        for (size_t i = 0; i < messages.size(); ++i) {
-            if (i > 0) result += ", ";
-            result += "\"" + messages[i] + "\"";
-        }
+    return {ResultStatus::UserNotFound};
+}
+
+CommandResult GetUsersExecutor::run(const GetUsersCommand& cmd, UserManager& userManager) {
+    CommandResult result{ResultStatus::Ok};
+    result.items = userManager.getUsers(cmd.prefix.value_or(std::string_view()));
+    return result;
+}
+
+CommandResult GetUsersExecutor::run(const GetUsersCommand& cmd, ConcurrentUserManager& users) {
+    CommandResult result{ResultStatus::Ok};
+    result.owned = own(users.getUsers(cmd.prefix.value_or(std::string_view())));
+    result.items = result.owned->range();
+    return result;
+}
+
+CommandResult GetGroupsExecutor::run([[maybe_unused]] const GetGroupsCommand& cmd, UserManager& userManager) {
+    CommandResult result{ResultStatus::Ok};
+    result.items = userManager.getGroups();
+    return result;
+}
+
+CommandResult GetGroupsExecutor::run([[maybe_unused]] const GetGroupsCommand& cmd, ConcurrentUserManager& users) {
+    CommandResult result{ResultStatus::Ok};
+    result.owned = own(users.getGroups());
+    result.items = result.owned->range();
+    return result;
+}
+
+CommandResult GetMessageHistoryExecutor::run(const GetMessageHistoryCommand& historyCmd, UserManager& userManager) {
+    auto id = userManager.findUser(historyCmd.username);
+    if (!id) {
+        return {ResultStatus::UserNotFound};
     }
-    return {true, result};
+    // The grammar accepts only digits, so neither bound is negative
+    size_t from = historyCmd.from.value_or(0);
+    size_t limit = historyCmd.limit ? static_cast<size_t>(*historyCmd.limit) : SIZE_MAX;
+    CommandResult result{ResultStatus::Ok};
+    result.history = userManager.getMessageHistory(*id, from, limit);
+    return result;
+}
+
+CommandResult GetMessageHistoryExecutor::run(const GetMessageHistoryCommand& historyCmd, ConcurrentUserManager& users) {
+    size_t from = historyCmd.from.value_or(0);
+    size_t limit = historyCmd.limit ? static_cast<size_t>(*historyCmd.limit) : SIZE_MAX;
+    auto history = users.getMessageHistory(historyCmd.username, from, limit);
+    if (!history) {
+        return {ResultStatus::UserNotFound};
+    }
+    CommandResult result{ResultStatus::Ok};
+    result.owned = own(std::move(*history));
+    result.history = result.owned->range();
+    return result;
+}
+
+template<typename Users>
+CommandResult ExitExecutor::run([[maybe_unused]] const ExitCommand& cmd, [[maybe_unused]] Users& users) {
+    CommandResult result{ResultStatus::Ok};
+    result.shouldExit = true;
+    return result;
 }
 
-CommandResult ExitExecutor::execute([[maybe_unused]] const Command& cmd, [[maybe_unused]] UserManager& userManager) {
-    return {true, "✅ EXIT", true};
-}
\ No newline at end of file
+// Every store a command can run against
+template CommandResult CreateUserExecutor::run(const CreateUserCommand&, UserManager&);
+template CommandResult CreateUsersExecutor::run(const CreateUsersCommand&, UserManager&);
+template CommandResult DeleteUserExecutor::run(const DeleteUserCommand&, UserManager&);
+template CommandResult DisableUserExecutor::run(const DisableUserCommand&, UserManager&);
+template CommandResult SendMessageExecutor::run(const SendMessageCommand&, UserManager&);
+template CommandResult PingExecutor::run(const PingCommand&, UserManager&);
+template CommandResult AddUserToGroupExecutor::run(const AddUserToGroupCommand&, UserManager&);
+template CommandResult AddUsersToGroupExecutor::run(const AddUsersToGroupCommand&, UserManager&);
+template CommandResult RemoveUserFromGroupExecutor::run(const RemoveUserFromGroupCommand&, UserManager&);
+template CommandResult ExitExecutor::run(const ExitCommand&, UserManager&);
+template CommandResult CreateUserExecutor::run(const CreateUserCommand&, ConcurrentUserManager&);
+template CommandResult CreateUsersExecutor::run(const CreateUsersCommand&, ConcurrentUserManager&);
+template CommandResult DeleteUserExecutor::run(const DeleteUserCommand&, ConcurrentUserManager&);
+template CommandResult DisableUserExecutor::run(const DisableUserCommand&, ConcurrentUserManager&);
+template CommandResult SendMessageExecutor::run(const SendMessageCommand&, ConcurrentUserManager&);
+template CommandResult PingExecutor::run(const PingCommand&, ConcurrentUserManager&);
+template CommandResult AddUserToGroupExecutor::run(const AddUserToGroupCommand&, ConcurrentUserManager&);
+template CommandResult AddUsersToGroupExecutor::run(const AddUsersToGroupCommand&, ConcurrentUserManager&);
+template CommandResult RemoveUserFromGroupExecutor::run(const RemoveUserFromGroupCommand&, ConcurrentUserManager&);
+template CommandResult ExitExecutor::run(const ExitCommand&, ConcurrentUserManager&);
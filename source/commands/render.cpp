@@ -0,0 +1,203 @@
+#include "commands/render.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <type_traits>
+
+namespace {
+
+using Out = std::back_insert_iterator<fmt::memory_buffer>;
+
+// Echo of each command as it appears in the transcript
+void describe(Out out, const CreateUserCommand& cmd) { fmt::format_to(out, "CREATE USER {}", cmd.username); }
+void describe(Out out, const NameList& names) {
+    if (names.isRange) {
+        fmt::format_to(out, "{}[{}..{}]", names.text, names.first, names.last);
+    } else {
+        fmt::format_to(out, "{}", names.text);
+    }
+}
+void describe(Out out, const CreateUsersCommand& cmd) {
+    fmt::format_to(out, "CREATE USERS ");
+    describe(out, cmd.names);
+}
+void describe(Out out, const DeleteUserCommand& cmd) { fmt::format_to(out, "DELETE USER {}", cmd.username); }
+void describe(Out out, const DisableUserCommand& cmd) { fmt::format_to(out, "DISABLE USER {}", cmd.username); }
+void describe(Out out, const SendMessageCommand& cmd) {
+    fmt::format_to(out, "SEND MESSAGE {} \"{}\"", cmd.username, cmd.message);
+}
+void describe(Out out, const AddUserToGroupCommand& cmd) {
+    fmt::format_to(out, "ADD USER {} TO GROUP {}", cmd.username, cmd.group);
+}
+void describe(Out out, const AddUsersToGroupCommand& cmd) {
+    fmt::format_to(out, "ADD USERS ");
+    describe(out, cmd.names);
+    fmt::format_to(out, " TO GROUP {}", cmd.group);
+}
+void describe(Out out, const RemoveUserFromGroupCommand& cmd) {
+    fmt::format_to(out, "REMOVE USER {} FROM GROUP {}", cmd.username, cmd.group);
+}
+void describe(Out out, const GetUsersCommand& cmd) {
+    fmt::format_to(out, "GET USERS");
+    if (cmd.prefix) {
+        fmt::format_to(out, " WITH PREFIX {}", *cmd.prefix);
+    }
+}
+void describe(Out out, const GetGroupsCommand&) { fmt::format_to(out, "GET GROUPS"); }
+void describe(Out out, const GetMessageHistoryCommand& cmd) {
+    fmt::format_to(out, "GET MESSAGE HISTORY {}", cmd.username);
+    if (cmd.from) {
+        fmt::format_to(out, " FROM {}", *cmd.from);
+    }
+    if (cmd.limit) {
+        fmt::format_to(out, " LIMIT {}", *cmd.limit);
+    }
+}
+void describe(Out out, const ExitCommand&) { fmt::format_to(out, "EXIT"); }
+
+const char* failureReason(ResultStatus status) {
+    switch (status) {
+        case ResultStatus::UserExists: return " (Failed: User already exists)";
+        case ResultStatus::UserNotFound: return " (Failed: User does not exist)";
+        default: return "";
+    }
+}
+
+/// @brief Where a piece of transcript must stop
+struct Budget {
+    const BufferedOutput& out;
+    std::uint64_t stopAt;
+
+    bool spent() const { return out.written() >= stopAt; }
+};
+
+// Items are checked against the budget one by one, so a listing stops
+// after the item that spends it
+bool listItems(BufferedOutput& output, const char* label, ViewRange items, bool quoted, RenderCursor& cursor,
+               const Budget& budget) {
+    Out out(output.buffer());
+    if (!cursor.opened) {
+        fmt::format_to(out, "\n{}: ", label);
+        if (items.empty()) {
+            fmt::format_to(out, "(none)");
+        }
+        cursor.opened = true;
+    }
+    for (; cursor.item < items.size(); ++cursor.item) {
+        if (budget.spent()) {
+            return false;
+        }
+        std::string_view item = items.begin()[cursor.item];
+        if (cursor.item > 0) fmt::format_to(out, ", ");
+        if (quoted) {
+            fmt::format_to(out, "\"{}\"", item);
+        } else {
+            fmt::format_to(out, "{}", item);
+        }
+    }
+    return true;
+}
+
+// Append text until it has been written count times, in pieces of up to
+// a quarter block; false if the budget ran out first
+bool repeat(BufferedOutput& out, std::string_view text, std::uint64_t count, std::uint64_t& done,
+            const Budget& budget) {
+    if (done == count) {
+        return true;
+    }
+    fmt::memory_buffer piece;
+    size_t perPiece = std::max<size_t>(1, (BufferedOutput::kBlockBytes / 4) / text.size());
+    for (size_t i = 0; i < perPiece && i < count - done; ++i) {
+        piece.append(text.data(), text.data() + text.size());
+    }
+    std::string_view chunk(piece.data(), piece.size());
+    for (; count - done >= perPiece; done += perPiece) {
+        if (budget.spent()) {
+            return false;
+        }
+        out.append(chunk);
+    }
+    if (done < count) {
+        if (budget.spent()) {
+            return false;
+        }
+        out.append(chunk.substr(0, (count - done) * text.size()));
+        done = count;
+    }
+    return true;
+}
+
+// One block per target, as if each had been pinged by its own command
+bool renderPing(BufferedOutput& out, const PingCommand& cmd, const CommandResult& result, RenderCursor& cursor,
+                const Budget& budget) {
+    std::string_view names[PingCommand::kMaxTargets];
+    size_t count = cmd.splitTargets(names);
+    std::uint64_t times = cmd.times > 0 ? static_cast<std::uint64_t>(cmd.times) : 0;
+    fmt::memory_buffer line;
+    for (; cursor.item < count; ++cursor.item, cursor.repeats = 0, cursor.opened = false) {
+        size_t i = cursor.item;
+        bool answers = (result.answered >> i) & 1;
+        if (!cursor.opened) {
+            out.print("✅ Send ping to {} ({}):\n", names[i], cmd.times);
+            cursor.opened = true;
+        }
+        if (cmd.summary) {
+            out.print("{} pings sent, {} received\n", times, answers ? times : 0);
+            continue;
+        }
+        line.clear();
+        fmt::format_to(std::back_inserter(line), "Sent ping to {}\n", names[i]);
+        if (answers) {
+            fmt::format_to(std::back_inserter(line), "{} received a ping\n", names[i]);
+        }
+        if (!repeat(out, std::string_view(line.data(), line.size()), times, cursor.repeats, budget)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool render(const CommandResult& result, BufferedOutput& output, RenderCursor& cursor, const Budget& budget) {
+    bool complete = std::visit([&](const auto& cmd) {
+        using T = std::decay_t<decltype(cmd)>;
+        if constexpr (std::is_same_v<T, PingCommand>) {
+            return renderPing(output, cmd, result, cursor, budget);
+        } else {
+            if (!cursor.opened) {
+                Out out(output.buffer());
+                fmt::format_to(out, "{} ", result.success() ? "✅" : "❌");
+                describe(out, cmd);
+                fmt::format_to(out, "{}", failureReason(result.status));
+            }
+            if (result.success()) {
+                if constexpr (std::is_same_v<T, GetUsersCommand>) {
+                    return listItems(output, "Users", result.items, false, cursor, budget);
+                } else if constexpr (std::is_same_v<T, GetGroupsCommand>) {
+                    return listItems(output, "Groups", result.items, false, cursor, budget);
+                } else if constexpr (std::is_same_v<T, GetMessageHistoryCommand>) {
+                    return listItems(output, "Messages", result.history, true, cursor, budget);
+                }
+            }
+            return true;
+        }
+    }, *result.command);
+    if (complete) {
+        output.buffer().push_back('\n');
+    }
+    output.commit();
+    return complete;
+}
+
+} // namespace
+
+void renderResult(const CommandResult& result, BufferedOutput& output) {
+    RenderCursor cursor;
+    render(result, output, cursor, Budget{output, UINT64_MAX});
+}
+
+bool renderSome(const CommandResult& result, BufferedOutput& output, RenderCursor& cursor, size_t room) {
+    std::uint64_t written = output.written();
+    std::uint64_t stopAt = room < UINT64_MAX - written ? written + room : UINT64_MAX;
+    return render(result, output, cursor, Budget{output, stopAt});
+}
@@ -1,20 +1,284 @@
+#include "output/sink.hpp"     // For FileSink
+#include "profile/profiler.hpp" // For Profiler
+#include "server/server.hpp"    // For TaskServer
+#include "task/cache.hpp"      // For ResultCache
+#include "task/compiled.hpp"   // For compileTask
+#include "task/journal.hpp"    // For Journal
 #include "task/processor.hpp"  // For TaskProcessor
-#include <vector>              // For std::vector
+#include "task/scan.hpp"       // For LineScanner
+#include "task/snapshot.hpp"   // For Snapshot
+#include "user/concurrent.hpp"  // For ConcurrentUserManager
+#include <csignal>             // For std::signal, SIGINT, SIGTERM
+#include <cstdlib>             // For std::strtoul, EXIT_FAILURE
+#include <exception>           // For std::exception
+#include <filesystem>          // For std::filesystem::path
+#include <iostream>            // For std::cerr, std::cout
+#include <memory>              // For std::unique_ptr
+#include <optional>            // For std::optional
 #include <string>              // For std::string
+#include <string_view>         // For std::string_view
+#include <thread>              // For std::thread::hardware_concurrency
+#include <vector>              // For std::vector
 
-int main() {
-    TaskProcessor processor;
-    
-    // Process all task files
-    const std::vector<std::string> taskFiles = {
-        "tasks/task1.txt", 
-        "tasks/task2.txt", 
-        "tasks/task3.txt", 
-        "tasks/task4.txt", 
-        "tasks/task5.txt"
-    };
-    
-    processor.processTasks(taskFiles);
+namespace {
+
+void printUsage(const char* program) {
+    std::cerr << "Usage: " << program << " [--jobs N] [--parse-jobs N] [--pipeline] [--quiet] [--output FILE] [--stats] [--compile] [--profile] [--trace FILE]\n"
+              << "       [--serve ADDRESS] [--snapshot FILE] [--journal FILE] [--save-snapshot FILE] [--cache DIR]\n"
+              << "       [--shared-state]\n"
+              << "       [task files...]\n"
+              << "  --jobs N       run up to N tasks in parallel (0 = one per core)\n"
+              << "  --parse-jobs N parse each large task in chunks on N threads (0 = one per core)\n"
+              << "                 while it executes in order; for tasks run one at a time\n"
+              << "  --pipeline     parse each task on a second thread ahead of execution\n"
+              << "  --quiet        print only whether each task passed or failed\n"
+              << "  --output FILE  write the transcript to FILE instead of stdout\n"
+              << "  --stats        print scheduler and allocation counters to stderr\n"
+              << "  --compile      compile each task file to a binary .wzt next to it instead of running it\n"
+              << "  --serve ADDRESS  serve tasks over a socket, one per connection, until interrupted;\n"
+              << "                 ADDRESS is unix:PATH, HOST:PORT or PORT (on 127.0.0.1)\n"
+              << "  --snapshot FILE  start every task from the user state saved in FILE\n"
+              << "  --journal FILE  replay FILE on top of the starting state and append the task's changes to it\n"
+              << "  --save-snapshot FILE  save the state the task ended with to FILE (restarting the journal)\n"
+              << "                 (--journal and --save-snapshot take a single task)\n"
+              << "  --cache DIR    answer tasks seen before, in this run or one sharing DIR, from their stored\n"
+              << "                 transcripts (not with --journal, --save-snapshot or --serve)\n"
+              << "  --shared-state run every task, or every --serve connection, against one user store they all\n"
+              << "                 share, so they see each other's changes and each starts from what earlier\n"
+              << "                 ones left (not with --snapshot, --journal, --save-snapshot or --cache)\n"
+              << "  --profile      print phase timings and command latencies to stderr\n"
+              << "  --trace FILE   write a Chrome trace-event JSON of the run to FILE\n"
+              << "                 (--profile and --trace need a build with -DENABLE_INSTRUMENTATION=ON)\n";
+}
+
+void printStats(const TaskProcessor& processor, const Journal* journal, const ResultCache* cache) {
+    const auto& workers = processor.lastSchedulerStats();
+    std::cerr << "workers: " << workers.size() << "\n";
+    for (size_t i = 0; i < workers.size(); ++i) {
+        std::cerr << "  worker " << i << ": tasks " << workers[i].tasksRun
+                  << ", chunks " << workers[i].chunksRun
+                  << ", steals " << workers[i].steals << "\n";
+    }
+    const auto& arena = processor.lastAllocationStats();
+    std::cerr << "arena: " << arena.requests << " allocations over " << arena.resets << " resets, "
+              << arena.systemAllocations << " from the system (" << arena.systemBytes << " bytes), buffers "
+              << arena.bufferBytes << " bytes\n";
+    std::cerr << "line scanner: " << LineScanner::name(LineScanner::bestKernel()) << "\n";
+    if (journal != nullptr) {
+        const auto& counters = journal->stats();
+        std::cerr << "journal: generation " << journal->generation() << ", " << counters.replayed
+                  << " commands replayed, " << counters.recorded << " recorded in " << counters.commits
+                  << " commits (" << counters.bytes << " bytes)\n";
+    }
+    if (cache != nullptr) {
+        const auto& counters = cache->stats();
+        std::cerr << "cache: " << counters.hits << " hits (" << counters.repeats << " repeats, " << counters.diskHits
+                  << " from " << cache->directory() << "), " << counters.misses << " misses, " << counters.stored
+                  << " stored\n";
+    }
+}
+
+TaskServer* runningServer = nullptr;
+
+void stopServer(int) {
+    if (runningServer != nullptr) {
+        runningServer->stop();
+    }
+}
+
+void serve(const TaskProcessor& processor, const std::string& address, bool stats) {
+    TaskServer server(processor, address);
+    runningServer = &server;
+    std::signal(SIGINT, stopServer);
+    std::signal(SIGTERM, stopServer);
+    std::cerr << "Serving tasks on " << server.address() << "\n";
+    server.run();
+    runningServer = nullptr;
+    if (stats) {
+        const auto& counters = server.stats();
+        std::cerr << "server: " << counters.connections << " connections, " << counters.completedTasks
+                  << " tasks finished, " << counters.bytesIn << " bytes in, " << counters.bytesOut << " bytes out, at most "
+                  << counters.peakHeldBytes << " held for a connection\n";
+    }
+}
+
+int compileAll(const std::vector<std::string>& taskFiles) {
+    for (const auto& source : taskFiles) {
+        std::string target = std::filesystem::path(source).replace_extension(".wzt").string();
+        if (target == source) {
+            std::cerr << "Refusing to overwrite " << source << " with its compiled form\n";
+            return EXIT_FAILURE;
+        }
+        auto stats = compileTask(source, target);
+        std::cout << "Compiled " << source << " -> " << target << ": " << stats.commands << " commands ("
+                  << stats.invalidLines << " invalid), " << stats.strings << " strings, " << stats.sourceBytes
+                  << " -> " << stats.compiledBytes << " bytes\n";
+    }
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    size_t jobs = 1;
+    bool stats = false;
+    bool compile = false;
+    bool profile = false;
+    bool sharedState = false;
+    std::optional<std::string> traceFile;
+    std::optional<std::string> serveAddress;
+    std::optional<std::string> snapshotFile;
+    std::optional<std::string> journalFile;
+    std::optional<std::string> saveSnapshotFile;
+    std::optional<std::string> cacheDirectory;
+    ProcessorOptions options;
+    std::optional<std::string> outputFile;
+    std::vector<std::string> taskFiles;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string_view arg = argv[i];
+        if (arg == "--jobs" && i + 1 < argc) {
+            char* end = nullptr;
+            jobs = std::strtoul(argv[++i], &end, 10);
+            if (*end != '\0') {
+                printUsage(argv[0]);
+                return EXIT_FAILURE;
+            }
+            if (jobs == 0) {
+                jobs = std::max(1u, std::thread::hardware_concurrency());
+            }
+        } else if (arg == "--parse-jobs" && i + 1 < argc) {
+            char* end = nullptr;
+            options.parseWorkers = std::strtoul(argv[++i], &end, 10);
+            if (*end != '\0') {
+                printUsage(argv[0]);
+                return EXIT_FAILURE;
+            }
+            if (options.parseWorkers == 0) {
+                options.parseWorkers = std::max(1u, std::thread::hardware_concurrency());
+            }
+        } else if (arg == "--pipeline") {
+            options.pipeline = true;
+        } else if (arg == "--quiet") {
+            options.quiet = true;
+        } else if (arg == "--output" && i + 1 < argc) {
+            outputFile = argv[++i];
+        } else if (arg == "--stats") {
+            stats = true;
+        } else if (arg == "--compile") {
+            compile = true;
+        } else if (arg == "--serve" && i + 1 < argc) {
+            serveAddress = argv[++i];
+        } else if (arg == "--snapshot" && i + 1 < argc) {
+            snapshotFile = argv[++i];
+        } else if (arg == "--journal" && i + 1 < argc) {
+            journalFile = argv[++i];
+        } else if (arg == "--save-snapshot" && i + 1 < argc) {
+            saveSnapshotFile = argv[++i];
+        } else if (arg == "--cache" && i + 1 < argc) {
+            cacheDirectory = argv[++i];
+        } else if (arg == "--shared-state") {
+            sharedState = true;
+        } else if (arg == "--profile") {
+            profile = true;
+        } else if (arg == "--trace" && i + 1 < argc) {
+            traceFile = argv[++i];
+        } else if (arg.substr(0, 1) == "-") {
+            printUsage(argv[0]);
+            return EXIT_FAILURE;
+        } else {
+            taskFiles.emplace_back(arg);
+        }
+    }
+
+#if !WZH_INSTRUMENTATION
+    if (profile || traceFile) {
+        std::cerr << "--profile and --trace need a build configured with -DENABLE_INSTRUMENTATION=ON\n";
+        return EXIT_FAILURE;
+    }
+#endif
+
+    if ((journalFile || saveSnapshotFile) && (serveAddress || taskFiles.size() != 1)) {
+        std::cerr << "--journal and --save-snapshot take a single task file\n";
+        return EXIT_FAILURE;
+    }
+    if (cacheDirectory && (journalFile || saveSnapshotFile || serveAddress)) {
+        std::cerr << "--cache cannot be combined with --journal, --save-snapshot or --serve\n";
+        return EXIT_FAILURE;
+    }
+    if (sharedState && (snapshotFile || journalFile || saveSnapshotFile || cacheDirectory)) {
+        std::cerr << "--shared-state cannot be combined with --snapshot, --journal, --save-snapshot or --cache\n";
+        return EXIT_FAILURE;
+    }
+
+    // Process the bundled task files unless others were given
+    if (taskFiles.empty()) {
+        taskFiles = {
+            "tasks/task1.txt", 
+            "tasks/task2.txt", 
+            "tasks/task3.txt", 
+            "tasks/task4.txt", 
+            "tasks/task5.txt"
+        };
+    }
+
+    std::unique_ptr<FileSink> fileSink;
+    std::unique_ptr<Snapshot> snapshot;
+    std::unique_ptr<Journal> journal;
+    std::unique_ptr<ResultCache> cache;
+    std::unique_ptr<ConcurrentUserManager> sharedUsers;
+    try {
+        if (compile) {
+            return compileAll(taskFiles);
+        }
+        if (outputFile) {
+            fileSink = std::make_unique<FileSink>(*outputFile);
+        }
+#if WZH_INSTRUMENTATION
+        if (traceFile) {
+            Profiler::enableTrace();
+        }
+#endif
+        if (snapshotFile) {
+            snapshot = std::make_unique<Snapshot>(*snapshotFile);
+            options.snapshot = snapshot.get();
+        }
+        if (journalFile) {
+            journal = std::make_unique<Journal>(*journalFile);
+            options.journal = journal.get();
+        }
+        if (cacheDirectory) {
+            cache = std::make_unique<ResultCache>(*cacheDirectory);
+            options.cache = cache.get();
+        }
+        if (sharedState) {
+            sharedUsers = std::make_unique<ConcurrentUserManager>();
+            options.sharedState = sharedUsers.get();
+        }
+        TaskProcessor processor(options, fileSink ? *fileSink : FileSink::standardOutput());
+        if (serveAddress) {
+            serve(processor, *serveAddress, stats);
+        } else {
+            processor.processTasks(taskFiles, jobs);
+            if (saveSnapshotFile) {
+                processor.saveSnapshot(*saveSnapshotFile);
+            }
+            if (stats) {
+                printStats(processor, journal.get(), cache.get());
+            }
+        }
+#if WZH_INSTRUMENTATION
+        if (profile) {
+            std::cerr << Profiler::report();
+        }
+        if (traceFile) {
+            Profiler::writeTrace(*traceFile);
+        }
+#endif
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
     
     return 0;
-}
\ No newline at end of file
+}
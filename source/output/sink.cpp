@@ -0,0 +1,158 @@
+#include "output/sink.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <fmt/format.h>
+
+#include "profile/profiler.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <limits.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#else
+#include <cstdio>
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+namespace {
+
+[[noreturn]] void throwWriteError() {
+    throw std::runtime_error(fmt::format("Cannot write output: {}", std::strerror(errno)));
+}
+
+#ifndef IOV_MAX
+constexpr int kMaxBlocks = 16;
+#else
+constexpr int kMaxBlocks = IOV_MAX;
+#endif
+
+} // namespace
+
+#if defined(__unix__) || defined(__APPLE__)
+
+FileSink::FileSink(const std::string& path, Mode mode)
+    : fd(::open(path.c_str(), O_WRONLY | O_CREAT | (mode == Mode::Append ? O_APPEND : O_TRUNC), 0644)),
+      owned(true) {
+    if (fd < 0) {
+        throw std::runtime_error(fmt::format("Cannot open file: {}", path));
+    }
+}
+
+FileSink::~FileSink() {
+    if (owned) {
+        ::close(fd);
+    }
+}
+
+void FileSink::write(std::string_view block) {
+    WZH_PROFILE_PHASE(Phase::Write);
+    while (!block.empty()) {
+        ssize_t count = ::write(fd, block.data(), block.size());
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throwWriteError();
+        }
+        block.remove_prefix(static_cast<size_t>(count));
+    }
+}
+
+void FileSink::write(const std::vector<std::string_view>& blocks) {
+    WZH_PROFILE_PHASE(Phase::Write);
+    std::vector<iovec> pending;
+    pending.reserve(blocks.size());
+    for (auto block : blocks) {
+        if (!block.empty()) {
+            pending.push_back({const_cast<char*>(block.data()), block.size()});
+        }
+    }
+
+    // writev may stop anywhere, including inside a block
+    size_t first = 0;
+    while (first < pending.size()) {
+        int count = static_cast<int>(std::min<size_t>(pending.size() - first, kMaxBlocks));
+        ssize_t written = ::writev(fd, pending.data() + first, count);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throwWriteError();
+        }
+        auto remaining = static_cast<size_t>(written);
+        while (first < pending.size() && remaining >= pending[first].iov_len) {
+            remaining -= pending[first].iov_len;
+            ++first;
+        }
+        if (remaining > 0) {
+            pending[first].iov_base = static_cast<char*>(pending[first].iov_base) + remaining;
+            pending[first].iov_len -= remaining;
+        }
+    }
+}
+
+void FileSink::sync() {
+#if defined(__linux__)
+    int result = ::fdatasync(fd);
+#else
+    int result = ::fsync(fd);
+#endif
+    if (result != 0) {
+        throwWriteError();
+    }
+}
+
+FileSink& FileSink::standardOutput() {
+    static FileSink sink(STDOUT_FILENO, false);
+    return sink;
+}
+
+#else
+
+FileSink::FileSink(const std::string& path, Mode mode)
+    : fd(::_open(path.c_str(), _O_WRONLY | _O_CREAT | (mode == Mode::Append ? _O_APPEND : _O_TRUNC) | _O_BINARY,
+                 0644)),
+      owned(true) {
+    if (fd < 0) {
+        throw std::runtime_error(fmt::format("Cannot open file: {}", path));
+    }
+}
+
+FileSink::~FileSink() {
+    if (owned) {
+        ::_close(fd);
+    }
+}
+
+void FileSink::write(std::string_view block) {
+    WZH_PROFILE_PHASE(Phase::Write);
+    while (!block.empty()) {
+        int count = ::_write(fd, block.data(), static_cast<unsigned>(std::min<size_t>(block.size(), 1u << 30)));
+        if (count < 0) {
+            throwWriteError();
+        }
+        block.remove_prefix(static_cast<size_t>(count));
+    }
+}
+
+void FileSink::write(const std::vector<std::string_view>& blocks) {
+    OutputSink::write(blocks);
+}
+
+void FileSink::sync() {
+    if (::_commit(fd) != 0) {
+        throwWriteError();
+    }
+}
+
+FileSink& FileSink::standardOutput() {
+    static FileSink sink(::_fileno(stdout), false);
+    return sink;
+}
+
+#endif
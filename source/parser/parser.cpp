@@ -1,203 +1,85 @@
 #include "parser/parser.hpp"
 
-// Basic parsers implementation
-parsec::Parser<char> CommandParser::character(char c) {
-    return [c](std::string_view s, size_t i) {
-        if (i >= s.size()) {
-            return parsec::makeError<char>(fmt::format("Expected '{}' but reached end of input", c), i);
+#include <cstdint>
+#include <limits>
+#include <vector>
+#include <fmt/format.h>
+#include "commands/table.hpp"
+
+namespace {
+
+std::string describe(std::uint16_t kind) {
+    switch (kind) {
+    case grammar::Whitespace:
+        return "whitespace";
+    case grammar::Name:
+        return "a name";
+    case grammar::Quoted:
+        return "a quoted string";
+    case grammar::ClosingQuote:
+        return "a closing quote";
+    case grammar::Digits:
+        return "a number";
+    case grammar::FewerNames:
+        return fmt::format("at most {} names", PingCommand::kMaxTargets);
+    case grammar::EndOfLine:
+        return "end of line";
+    case grammar::SmallerRange:
+        return fmt::format("a range of at most {} names", NameList::kMaxRangeNames);
+    case grammar::AscendingRange:
+        return "first <= last";
+    case grammar::SmallerNumber:
+        return fmt::format("a number of at most {}", std::numeric_limits<std::int32_t>::max());
+    }
+    return "?";
+}
+
+std::string describe(std::string_view word) {
+    // Punctuation is quoted so that it stands out from the list itself
+    if (!word.empty() && chars::isAlpha(word.front())) {
+        return std::string(word);
+    }
+    return fmt::format("'{}'", word);
+}
+
+} // namespace
+
+// The row parsers are instantiated here only, not in every caller
+std::optional<Command> CommandParser::parse(std::string_view line) {
+    return CommandTable::parse(line);
+}
+
+std::string CommandParser::diagnose(std::string_view line) {
+    grammar::Failure failure;
+    if (CommandTable::parse(line, failure) || failure.empty()) {
+        return {};
+    }
+
+    std::vector<std::string> expected;
+    for (auto word = failure.wordsBegin(); word != failure.wordsEnd(); ++word) {
+        expected.push_back(describe(*word));
+    }
+    for (std::uint16_t kind = 1; kind != 0; kind <<= 1) {
+        if (failure.kinds() & kind) {
+            expected.push_back(describe(kind));
         }
-        if (s[i] == c) {
-            return parsec::makeSuccess<char>(char(s[i]), i + 1);
+    }
+    std::string list = expected.front();
+    for (size_t i = 1; i < expected.size(); ++i) {
+        list += i + 1 == expected.size() ? " or " : ", ";
+        list += expected[i];
+    }
+
+    // Pad with the line's own tabs so the caret lines up; count a UTF-8
+    // sequence as one column
+    std::string pad;
+    size_t column = 1;
+    for (size_t i = 0; i < failure.position() && i < line.size(); ++i) {
+        if ((static_cast<unsigned char>(line[i]) & 0xC0) == 0x80) {
+            continue;
         }
-        return parsec::makeError<char>(fmt::format("Expected '{}' but found '{}'", c, s[i]), i);
-    };
+        pad.push_back(line[i] == '\t' ? '\t' : ' ');
+        ++column;
+    }
+    return fmt::format("   {}\n   {}^ column {}: expected {}\n", line, pad, column, list);
 }
-
-parsec::Parser<std::string> CommandParser::whitespace() {
-    return [](std::string_view s, size_t i) {
-        size_t start = i;
-        while (i < s.size() && std::isspace(s[i])) {
-            ++i;
-        }
-        if (i == start) {
-            return parsec::makeError<std::string>("Expected whitespace", i);
-        }
-        return parsec::makeSuccess<std::string>(std::string(s.substr(start, i - start)), i);
-    };
-}
-
-parsec::Parser<std::string> CommandParser::identifier() {
-    return [](std::string_view s, size_t i) {
-        size_t start = i;
-        if (i >= s.size() || !std::isalpha(s[i])) {
-            return parsec::makeError<std::string>("Expected identifier", i);
-        }
-        while (i < s.size() && (std::isalnum(s[i]) || s[i] == '_')) {
-            ++i;
-        }
-        return parsec::makeSuccess<std::string>(std::string(s.substr(start, i - start)), i);
-    };
-}
-
-parsec::Parser<std::string> CommandParser::quotedString() {
-    return [](std::string_view s, size_t i) {
-        if (i >= s.size() || s[i] != '"') {
-            return parsec::makeError<std::string>("Expected quoted string", i);
-        }
-        ++i; // Skip opening quote
-        size_t start = i;
-        while (i < s.size() && s[i] != '"') {
-            ++i;
-        }
-        if (i >= s.size()) {
-            return parsec::makeError<std::string>("Unterminated quoted string", i);
-        }
-        std::string result(s.substr(start, i - start));
-        ++i; // Skip closing quote
-        return parsec::makeSuccess<std::string>(std::move(result), i);
-    };
-}
-
-parsec::Parser<int> CommandParser::number() {
-    return [](std::string_view s, size_t i) {
-        size_t start = i;
-        if (i >= s.size() || !std::isdigit(s[i])) {
-            return parsec::makeError<int>("Expected number", i);
-        }
-        while (i < s.size() && std::isdigit(s[i])) {
-            ++i;
-        }
-        std::string numStr(s.substr(start, i - start));
-        return parsec::makeSuccess<int>(std::stoi(numStr), i);
-    };
-}
-
-parsec::Parser<std::string> CommandParser::keyword(const std::string& word) {
-    return [word](std::string_view s, size_t i) {
-        if (i + word.length() > s.size()) {
-            return parsec::makeError<std::string>(fmt::format("Expected '{}'", word), i);
-        }
-        if (s.substr(i, word.length()) == word) {
-            return parsec::makeSuccess<std::string>(std::string(word), i + word.length());
-        }
-        return parsec::makeError<std::string>(fmt::format("Expected '{}'", word), i);
-    };
-}
-
-// Command parser implementation
-parsec::Parser<Command> CommandParser::commandParser() {
-    return createUserParser() | 
-           deleteUserParser() | 
-           disableUserParser() | 
-           sendMessageParser() | 
-           pingParser() | 
-           addUserToGroupParser() | 
-           removeUserFromGroupParser() | 
-           getUsersParser() | 
-           getGroupsParser() | 
-           getMessageHistoryParser() | 
-           exitParser();
-}
-
-// Command-specific parsers implementation
-parsec::Parser<Command> CommandParser::createUserParser() {
-    return parsec::fmap<Command, std::string>(
-        [](const std::string& username) -> Command {
-            return CreateUserCommand{username};
-        },
-        keyword("CREATE") >> whitespace() >> keyword("USER") >> whitespace() >> identifier()
-    );
-}
-
-parsec::Parser<Command> CommandParser::deleteUserParser() {
-    return parsec::fmap<Command, std::string>(
-        [](const std::string& username) -> Command {
-            return DeleteUserCommand{username};
-        },
-        keyword("DELETE") >> whitespace() >> keyword("USER") >> whitespace() >> identifier()
-    );
-}
-
-parsec::Parser<Command> CommandParser::disableUserParser() {
-    return parsec::fmap<Command, std::string>(
-        [](const std::string& username) -> Command {
-            return DisableUserCommand{username};
-        },
-        keyword("DISABLE") >> whitespace() >> keyword("USER") >> whitespace() >> identifier()
-    );
-}
-
-parsec::Parser<Command> CommandParser::sendMessageParser() {
-    return parsec::fmap<Command, std::tuple<std::string, std::string>>(
-        [](const std::tuple<std::string, std::string>& params) -> Command {
-            return SendMessageCommand{std::get<0>(params), std::get<1>(params)};
-        },
-        (keyword("SEND") >> whitespace() >> keyword("MESSAGE") >> whitespace() >> identifier()) & 
-        (whitespace() >> quotedString())
-    );
-}
-
-parsec::Parser<Command> CommandParser::pingParser() {
-    return parsec::fmap<Command, std::tuple<std::string, int>>(
-        [](const std::tuple<std::string, int>& params) -> Command {
-            return PingCommand{std::get<0>(params), std::get<1>(params)};
-        },
-        (keyword("PING") >> whitespace() >> identifier()) & (whitespace() >> number())
-    );
-}
-
-parsec::Parser<Command> CommandParser::addUserToGroupParser() {
-    return parsec::fmap<Command, std::tuple<std::string, std::string>>(
-        [](const std::tuple<std::string, std::string>& params) -> Command {
-            return AddUserToGroupCommand{std::get<0>(params), std::get<1>(params)};
-        },
-        (keyword("ADD") >> whitespace() >> keyword("USER") >> whitespace() >> identifier()) & 
-        (whitespace() >> keyword("TO") >> whitespace() >> keyword("GROUP") >> whitespace() >> identifier())
-    );
-}
-
-parsec::Parser<Command> CommandParser::removeUserFromGroupParser() {
-    return parsec::fmap<Command, std::tuple<std::string, std::string>>(
-        [](const std::tuple<std::string, std::string>& params) -> Command {
-            return RemoveUserFromGroupCommand{std::get<0>(params), std::get<1>(params)};
-        },
-        (keyword("REMOVE") >> whitespace() >> keyword("USER") >> whitespace() >> identifier()) & 
-        (whitespace() >> keyword("FROM") >> whitespace() >> keyword("GROUP") >> whitespace() >> identifier())
-    );
-}
-
-parsec::Parser<Command> CommandParser::getUsersParser() {
-    return parsec::fmap<Command, std::string>(
-        [](const std::string&) -> Command {
-            return GetUsersCommand{};
-        },
-        keyword("GET") >> whitespace() >> keyword("USERS")
-    );
-}
-
-parsec::Parser<Command> CommandParser::getGroupsParser() {
-    return parsec::fmap<Command, std::string>(
-        [](const std::string&) -> Command {
-            return GetGroupsCommand{};
-        },
-        keyword("GET") >> whitespace() >> keyword("GROUPS")
-    );
-}
-
-parsec::Parser<Command> CommandParser::getMessageHistoryParser() {
-    return parsec::fmap<Command, std::string>(
-        [](const std::string& username) -> Command {
-            return GetMessageHistoryCommand{username};
-        },
-        keyword("GET") >> whitespace() >> keyword("MESSAGE") >> whitespace() >> keyword("HISTORY") >> whitespace() >> identifier()
-    );
-}
-
-parsec::Parser<Command> CommandParser::exitParser() {
-    return parsec::fmap<Command, std::string>(
-        [](const std::string&) -> Command {
-            return ExitCommand{};
-        },
-        keyword("EXIT")
-    );
-}
\ No newline at end of file
@@ -0,0 +1,9 @@
+#include "parser/parser.hpp"
+
+#include "commands/table.hpp"
+
+// The row parsers for lines with token masks, kept apart from the plain
+// ones in parser.cpp so that each unit inlines its own rows in full
+std::optional<Command> CommandParser::parse(const grammar::Line& line) {
+    return CommandTable::parse(line);
+}
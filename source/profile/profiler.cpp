@@ -0,0 +1,272 @@
+#include "profile/profiler.hpp"
+
+#if WZH_INSTRUMENTATION
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string_view>
+#include <fmt/format.h>
+
+namespace {
+
+constexpr std::array<const char*, kPhaseCount> kPhaseNames = {
+    "task", "read", "parse", "execute", "render", "write",
+};
+
+// In the order of the Command alternatives
+constexpr std::array<const char*, kProfiledCommands> kCommandNames = {
+    "CREATE USER",
+    "CREATE USERS",
+    "DELETE USER",
+    "DISABLE USER",
+    "SEND MESSAGE",
+    "PING",
+    "ADD USER TO GROUP",
+    "ADD USERS TO GROUP",
+    "REMOVE USER FROM GROUP",
+    "GET USERS",
+    "GET GROUPS",
+    "GET MESSAGE HISTORY",
+    "EXIT",
+};
+
+std::uint64_t bucketHigh(size_t bucket) {
+    constexpr size_t kSub = LatencyHistogram::kSubBuckets;
+    if (bucket < kSub) {
+        return bucket;
+    }
+    size_t shift = bucket / kSub - 1;
+    std::uint64_t low = static_cast<std::uint64_t>(kSub + bucket % kSub) << shift;
+    return low + ((std::uint64_t(1) << shift) - 1);
+}
+
+struct Registry {
+    std::mutex mutex;
+    std::vector<std::unique_ptr<ThreadProfile>> profiles;
+    std::vector<ThreadProfile*> idle;    // Left behind by threads that have exited
+    std::atomic<bool> tracing{false};
+
+    static Registry& get() {
+        static Registry registry;
+        return registry;
+    }
+
+    ThreadProfile* acquire() {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!idle.empty()) {
+            auto* profile = idle.back();
+            idle.pop_back();
+            return profile;
+        }
+        profiles.push_back(std::make_unique<ThreadProfile>());
+        profiles.back()->thread = static_cast<std::uint32_t>(profiles.size());
+        return profiles.back().get();
+    }
+
+    void release(ThreadProfile* profile) {
+        std::lock_guard<std::mutex> lock(mutex);
+        idle.push_back(profile);
+    }
+};
+
+/// @brief Hands the thread's profile back to the registry when the thread exits
+struct ThreadSlot {
+    Registry& registry = Registry::get();   // Constructed first, so destroyed after every slot
+    ThreadProfile* profile = registry.acquire();
+
+    ~ThreadSlot() { registry.release(profile); }
+};
+
+void appendRow(fmt::memory_buffer& out, const char* name, const LatencyHistogram& histogram) {
+    auto count = histogram.count();
+    fmt::format_to(std::back_inserter(out), "  {:<24}{:>12}{:>14.3f}{:>12}{:>12}{:>12}{:>12}\n", name, count,
+                   static_cast<double>(histogram.totalNanos()) / 1e6, count ? histogram.totalNanos() / count : 0,
+                   histogram.percentile(0.50), histogram.percentile(0.99), histogram.max());
+}
+
+void appendHeader(fmt::memory_buffer& out, const char* title) {
+    fmt::format_to(std::back_inserter(out), "  {:<24}{:>12}{:>14}{:>12}{:>12}{:>12}{:>12}\n", title, "count",
+                   "total ms", "mean ns", "p50 ns", "p99 ns", "max ns");
+}
+
+void appendText(fmt::memory_buffer& out, std::string_view text) {
+    out.append(text.data(), text.data() + text.size());
+}
+
+void appendJsonString(fmt::memory_buffer& out, std::string_view text) {
+    out.push_back('"');
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            out.push_back('\\');
+            out.push_back(c);
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            fmt::format_to(std::back_inserter(out), "\\u{:04x}", static_cast<unsigned>(c));
+        } else {
+            out.push_back(c);
+        }
+    }
+    out.push_back('"');
+}
+
+} // namespace
+
+void LatencyHistogram::merge(const LatencyHistogram& other) {
+    for (size_t i = 0; i < kBuckets; ++i) {
+        counts[i] += other.counts[i];
+    }
+    total += other.total;
+    sum += other.sum;
+    maximum = std::max(maximum, other.maximum);
+}
+
+std::uint64_t LatencyHistogram::percentile(double fraction) const {
+    if (total == 0) {
+        return 0;
+    }
+    // Rank of the value sought, 1-based
+    auto rank = static_cast<std::uint64_t>(fraction * static_cast<double>(total) + 0.5);
+    rank = std::clamp<std::uint64_t>(rank, 1, total);
+    std::uint64_t seen = 0;
+    for (size_t i = 0; i < kBuckets; ++i) {
+        seen += counts[i];
+        if (seen >= rank) {
+            return std::min(bucketHigh(i), maximum);
+        }
+    }
+    return maximum;
+}
+
+void ThreadProfile::trace(const char* name, const char* category, std::uint64_t start, std::uint64_t duration,
+                          const std::string* detail) {
+    if (events.size() >= kMaxTraceEvents) {
+        ++droppedEvents;
+        return;
+    }
+    events.push_back({name, category, start, duration, detail ? *detail : std::string()});
+}
+
+std::chrono::steady_clock::time_point Profiler::epoch() {
+    static const auto start = std::chrono::steady_clock::now();
+    return start;
+}
+
+ThreadProfile& Profiler::local() {
+    thread_local ThreadSlot slot;
+    return *slot.profile;
+}
+
+void Profiler::enableTrace() {
+    epoch();
+    Registry::get().tracing.store(true, std::memory_order_relaxed);
+}
+
+bool Profiler::tracing() {
+    return Registry::get().tracing.load(std::memory_order_relaxed);
+}
+
+std::string Profiler::report() {
+    auto& registry = Registry::get();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+
+    ThreadProfile merged;
+    std::uint64_t dropped = 0;
+    for (const auto& profile : registry.profiles) {
+        for (size_t i = 0; i < kPhaseCount; ++i) {
+            merged.phases[i].merge(profile->phases[i]);
+        }
+        for (size_t i = 0; i < kProfiledCommands; ++i) {
+            merged.commands[i].merge(profile->commands[i]);
+        }
+        dropped += profile->droppedEvents;
+    }
+
+    fmt::memory_buffer out;
+    fmt::format_to(std::back_inserter(out), "profile: {} threads, times summed over threads\n",
+                   registry.profiles.size());
+    appendHeader(out, "phase");
+    for (size_t i = 0; i < kPhaseCount; ++i) {
+        appendRow(out, kPhaseNames[i], merged.phases[i]);
+    }
+    appendHeader(out, "command");
+    for (size_t i = 0; i < kProfiledCommands; ++i) {
+        if (merged.commands[i].count() > 0) {
+            appendRow(out, kCommandNames[i], merged.commands[i]);
+        }
+    }
+    if (dropped > 0) {
+        fmt::format_to(std::back_inserter(out), "  {} trace events dropped past {} per thread\n", dropped,
+                       ThreadProfile::kMaxTraceEvents);
+    }
+    return fmt::to_string(out);
+}
+
+void Profiler::writeTrace(const std::string& filename) {
+    auto& registry = Registry::get();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+
+    // Plain stdio: a FileSink would time its own writes into this registry
+    std::unique_ptr<std::FILE, int (*)(std::FILE*)> file(std::fopen(filename.c_str(), "wb"), &std::fclose);
+    if (!file) {
+        throw std::runtime_error(fmt::format("Cannot open file: {}", filename));
+    }
+    fmt::memory_buffer out;
+    auto drain = [&] {
+        if (std::fwrite(out.data(), 1, out.size(), file.get()) != out.size()) {
+            throw std::runtime_error(fmt::format("Cannot write trace: {}", std::strerror(errno)));
+        }
+        out.clear();
+    };
+
+    appendText(out, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+    bool first = true;
+    for (const auto& profile : registry.profiles) {
+        for (const auto& event : profile->events) {
+            appendText(out, first ? "{\"name\":" : ",\n{\"name\":");
+            first = false;
+            appendJsonString(out, event.detail.empty() ? std::string_view(event.name) : std::string_view(event.detail));
+            fmt::format_to(std::back_inserter(out),
+                           ",\"cat\":\"{}\",\"ph\":\"X\",\"ts\":{:.3f},\"dur\":{:.3f},\"pid\":1,\"tid\":{}}}",
+                           event.category, static_cast<double>(event.start) / 1e3,
+                           static_cast<double>(event.duration) / 1e3, profile->thread);
+            if (out.size() >= (size_t(1) << 20)) {
+                drain();
+            }
+        }
+    }
+    appendText(out, "\n]}\n");
+    drain();
+}
+
+PhaseTimer::~PhaseTimer() {
+    auto end = Profiler::now();
+    auto index = static_cast<size_t>(phase);
+    profile.phases[index].record(end - start);
+    if (Profiler::tracing()) {
+        profile.trace(kPhaseNames[index], "phase", start, end - start);
+    }
+}
+
+CommandTimer::~CommandTimer() {
+    auto end = Profiler::now();
+    profile.commands[index].record(end - start);
+    if (Profiler::tracing()) {
+        profile.trace(kCommandNames[index], "command", start, end - start);
+    }
+}
+
+TaskTimer::~TaskTimer() {
+    auto end = Profiler::now();
+    profile.phases[static_cast<size_t>(Phase::Task)].record(end - start);
+    if (Profiler::tracing()) {
+        profile.trace(kPhaseNames[static_cast<size_t>(Phase::Task)], "task", start, end - start, &filename);
+    }
+}
+
+#endif // WZH_INSTRUMENTATION
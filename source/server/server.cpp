@@ -0,0 +1,418 @@
+#include "server/server.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+#include <fmt/format.h>
+#include "output/buffered.hpp"
+#include "output/sink.hpp"
+#include "task/session.hpp"
+
+#if defined(__linux__)
+
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+// Transcripts are flushed after every read, so connections need far less
+// than a file transcript's block
+constexpr size_t kConnectionBlockBytes = size_t(16) << 10;
+constexpr size_t kReadBytes = size_t(64) << 10;
+constexpr size_t kMaxIdleUsers = 64;
+constexpr int kMaxEvents = 64;
+
+[[noreturn]] void throwSystemError(const std::string& what) {
+    throw std::runtime_error(fmt::format("{}: {}", what, std::strerror(errno)));
+}
+
+/// @brief Closes a descriptor unless released, for the constructor's error paths
+struct FdGuard {
+    int fd;
+
+    ~FdGuard() {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+    }
+
+    int release() { return std::exchange(fd, -1); }
+};
+
+int listenUnix(const std::string& path, const std::string& address) {
+    sockaddr_un local{};
+    if (path.empty() || path.size() >= sizeof(local.sun_path)) {
+        throw std::runtime_error(fmt::format("Cannot listen on {}: path empty or too long", address));
+    }
+    local.sun_family = AF_UNIX;
+    std::memcpy(local.sun_path, path.c_str(), path.size() + 1);
+
+    FdGuard fd{::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0)};
+    if (fd.fd < 0) {
+        throwSystemError(fmt::format("Cannot listen on {}", address));
+    }
+    // A socket left behind by an earlier run is replaced; any other file is kept
+    struct stat existing{};
+    if (::lstat(path.c_str(), &existing) == 0 && S_ISSOCK(existing.st_mode)) {
+        ::unlink(path.c_str());
+    }
+    if (::bind(fd.fd, reinterpret_cast<sockaddr*>(&local), sizeof(local)) < 0 || ::listen(fd.fd, SOMAXCONN) < 0) {
+        throwSystemError(fmt::format("Cannot listen on {}", address));
+    }
+    return fd.release();
+}
+
+int listenTcp(const std::string& host, const std::string& port, const std::string& address) {
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_PASSIVE | AI_NUMERICSERV;
+    addrinfo* found = nullptr;
+    if (int error = ::getaddrinfo(host.c_str(), port.c_str(), &hints, &found); error != 0) {
+        throw std::runtime_error(fmt::format("Cannot listen on {}: {}", address, ::gai_strerror(error)));
+    }
+    std::unique_ptr<addrinfo, void (*)(addrinfo*)> addresses(found, &::freeaddrinfo);
+
+    int lastError = 0;
+    for (addrinfo* a = addresses.get(); a != nullptr; a = a->ai_next) {
+        FdGuard fd{::socket(a->ai_family, a->ai_socktype | SOCK_NONBLOCK | SOCK_CLOEXEC, a->ai_protocol)};
+        if (fd.fd < 0) {
+            lastError = errno;
+            continue;
+        }
+        int on = 1;
+        ::setsockopt(fd.fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+        if (::bind(fd.fd, a->ai_addr, a->ai_addrlen) == 0 && ::listen(fd.fd, SOMAXCONN) == 0) {
+            return fd.release();
+        }
+        lastError = errno;
+    }
+    errno = lastError;
+    throwSystemError(fmt::format("Cannot listen on {}", address));
+}
+
+std::string describeTcp(int fd) {
+    sockaddr_storage local{};
+    socklen_t length = sizeof(local);
+    ::getsockname(fd, reinterpret_cast<sockaddr*>(&local), &length);
+    char host[INET6_ADDRSTRLEN] = "?";
+    if (local.ss_family == AF_INET6) {
+        auto* v6 = reinterpret_cast<sockaddr_in6*>(&local);
+        ::inet_ntop(AF_INET6, &v6->sin6_addr, host, sizeof(host));
+        return fmt::format("[{}]:{}", host, ntohs(v6->sin6_port));
+    }
+    auto* v4 = reinterpret_cast<sockaddr_in*>(&local);
+    ::inet_ntop(AF_INET, &v4->sin_addr, host, sizeof(host));
+    return fmt::format("{}:{}", host, ntohs(v4->sin_port));
+}
+
+} // namespace
+
+struct TaskServer::Connection {
+    int fd;
+    std::unique_ptr<UserManager> users;
+    MemorySink transcript;     // What is still to be sent; sent bytes are discarded from it
+    BufferedOutput out;
+    TaskSession session;
+    bool reading = true;       // Until the task ends or the client shuts down its side
+    bool draining = false;     // Transcript sent; input is discarded until the client closes
+    std::uint32_t events = 0;  // As registered with epoll
+
+    Connection(int fd, const TaskProcessor& processor, std::string name, std::unique_ptr<UserManager> users)
+        : fd(fd), users(std::move(users)), out(transcript, kConnectionBlockBytes),
+          session(processor, std::move(name), *this->users, out) {}
+
+    size_t pending() const { return transcript.contents().size(); }
+};
+
+TaskServer::TaskServer(const TaskProcessor& processor, const std::string& address) : processor(processor) {
+    std::string_view spec = address;
+    bool isUnix = spec.substr(0, 5) == "unix:";
+    if (isUnix || spec.find('/') != std::string_view::npos) {
+        unixPath = std::string(isUnix ? spec.substr(5) : spec);
+        listener = listenUnix(unixPath, address);
+        boundAddress = "unix:" + unixPath;
+    } else {
+        size_t colon = spec.rfind(':');
+        std::string host = colon == std::string_view::npos ? "127.0.0.1" : std::string(spec.substr(0, colon));
+        std::string port(colon == std::string_view::npos ? spec : spec.substr(colon + 1));
+        if (port.empty() || port.find_first_not_of("0123456789") != std::string::npos) {
+            throw std::runtime_error(
+                fmt::format("Cannot listen on {}: expected unix:PATH, HOST:PORT or PORT", address));
+        }
+        // Brackets around an IPv6 host are for the reader, not getaddrinfo
+        if (host.size() >= 2 && host.front() == '[' && host.back() == ']') {
+            host = host.substr(1, host.size() - 2);
+        }
+        listener = listenTcp(host, port, address);
+        boundAddress = describeTcp(listener);
+    }
+    FdGuard listenerGuard{listener};
+
+    FdGuard epollGuard{::epoll_create1(EPOLL_CLOEXEC)};
+    FdGuard wakeupGuard{::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)};
+    if (epollGuard.fd < 0 || wakeupGuard.fd < 0) {
+        throwSystemError("Cannot start the event loop");
+    }
+    for (int fd : {listener, wakeupGuard.fd}) {
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.fd = fd;
+        if (::epoll_ctl(epollGuard.fd, EPOLL_CTL_ADD, fd, &event) < 0) {
+            throwSystemError("Cannot start the event loop");
+        }
+    }
+    epoll = epollGuard.release();
+    wakeup = wakeupGuard.release();
+    listenerGuard.release();
+}
+
+TaskServer::~TaskServer() {
+    for (auto& entry : connections) {
+        ::close(entry.first);
+    }
+    ::close(listener);
+    ::close(epoll);
+    ::close(wakeup);
+    if (!unixPath.empty()) {
+        ::unlink(unixPath.c_str());
+    }
+}
+
+void TaskServer::stop() {
+    std::uint64_t one = 1;
+    // Fails only when the counter is saturated, and then a wakeup is pending anyway
+    [[maybe_unused]] auto written = ::write(wakeup, &one, sizeof(one));
+}
+
+void TaskServer::run() {
+    epoll_event events[kMaxEvents];
+    for (;;) {
+        int count = ::epoll_wait(epoll, events, kMaxEvents, -1);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throwSystemError("Event loop failed");
+        }
+        for (int i = 0; i < count; ++i) {
+            int fd = events[i].data.fd;
+            if (fd == wakeup) {
+                std::uint64_t value;
+                [[maybe_unused]] auto drained = ::read(wakeup, &value, sizeof(value));
+                while (!connections.empty()) {
+                    close(*connections.begin()->second);
+                }
+                return;
+            }
+            if (fd == listener) {
+                accept();
+                continue;
+            }
+            // May have been closed by an earlier event of this round
+            auto it = connections.find(fd);
+            if (it == connections.end()) {
+                continue;
+            }
+            Connection& connection = *it->second;
+            if (events[i].events & EPOLLERR) {
+                close(connection);
+                continue;
+            }
+            if ((events[i].events & EPOLLOUT) && !writeTo(connection)) {
+                continue;
+            }
+            if ((events[i].events & (EPOLLIN | EPOLLHUP)) && (connection.reading || connection.draining)) {
+                readFrom(connection);
+            }
+        }
+    }
+}
+
+void TaskServer::accept() {
+    for (;;) {
+        int fd = ::accept4(listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            // EAGAIN once the backlog is empty; anything else (EMFILE, a
+            // connection reset before it was accepted) is retried on the
+            // next readiness of the listener
+            return;
+        }
+        if (unixPath.empty()) {
+            int on = 1;
+            ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+        }
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.fd = fd;
+        if (::epoll_ctl(epoll, EPOLL_CTL_ADD, fd, &event) < 0) {
+            ::close(fd);
+            continue;
+        }
+
+        std::unique_ptr<UserManager> users;
+        if (idleUsers.empty()) {
+            users = std::make_unique<UserManager>();
+        } else {
+            users = std::move(idleUsers.back());
+            idleUsers.pop_back();
+        }
+        ++counters.connections;
+        auto connection = std::make_unique<Connection>(
+            fd, processor, fmt::format("connection {}", counters.connections), std::move(users));
+        connection->events = EPOLLIN;
+        Connection& added = *connection;
+        connections.emplace(fd, std::move(connection));
+
+        // The task's opening line goes out straight away
+        flush(added);
+        writeTo(added);
+    }
+}
+
+bool TaskServer::readFrom(Connection& connection) {
+    // Input stays in the socket while the session holds back what it has
+    if (!connection.draining && (connection.session.blocked() || connection.pending() >= kMaxPendingBytes)) {
+        return true;
+    }
+    char buffer[kReadBytes];
+    ssize_t count;
+    do {
+        count = ::read(connection.fd, buffer, sizeof(buffer));
+    } while (count < 0 && errno == EINTR);
+
+    if (count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+        return true;
+    }
+    if (count < 0 || (connection.draining && count == 0)) {
+        close(connection);
+        return false;
+    }
+    if (connection.draining) {
+        return true;
+    }
+    size_t room = kMaxPendingBytes - connection.pending();
+    if (count == 0) {
+        connection.session.finish(room);
+    } else {
+        counters.bytesIn += static_cast<std::uint64_t>(count);
+        connection.session.feed(std::string_view(buffer, static_cast<size_t>(count)), room);
+    }
+    noteEnd(connection);
+    flush(connection);
+    return writeTo(connection);
+}
+
+bool TaskServer::writeTo(Connection& connection) {
+    bool resumed = false;
+    for (;;) {
+        while (connection.pending() > 0) {
+            std::string_view transcript = connection.transcript.contents();
+            ssize_t count = ::send(connection.fd, transcript.data(), transcript.size(), MSG_NOSIGNAL);
+            if (count < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                    break;
+                }
+                close(connection);    // The client went away
+                return false;
+            }
+            counters.bytesOut += static_cast<std::uint64_t>(count);
+            connection.transcript.discard(static_cast<size_t>(count));
+        }
+        // The session goes on once what it wrote has drained below the
+        // limit, once per event so that one long transcript cannot hold up
+        // the other connections
+        if (resumed || !connection.session.blocked() || connection.pending() >= kMaxPendingBytes) {
+            break;
+        }
+        connection.session.resume(kMaxPendingBytes - connection.pending());
+        noteEnd(connection);
+        flush(connection);
+        resumed = true;
+    }
+    if (connection.pending() == 0 && !connection.reading && !connection.draining) {
+        // Closing with input unread would reset the connection and could
+        // lose the end of the transcript, so only our side is shut down
+        // and the client's remaining commands are read and dropped
+        if (::shutdown(connection.fd, SHUT_WR) < 0) {
+            close(connection);
+            return false;
+        }
+        connection.draining = true;
+    }
+    updateEvents(connection);
+    return true;
+}
+
+void TaskServer::flush(Connection& connection) {
+    connection.out.flush();
+    counters.peakHeldBytes = std::max<std::uint64_t>(counters.peakHeldBytes, connection.transcript.retained());
+}
+
+void TaskServer::noteEnd(Connection& connection) {
+    if (connection.reading && connection.session.finished()) {
+        connection.reading = false;
+        ++counters.completedTasks;
+    }
+}
+
+void TaskServer::updateEvents(Connection& connection) {
+    std::uint32_t wanted = 0;
+    bool full = connection.session.blocked() || connection.pending() >= kMaxPendingBytes;
+    if ((connection.reading && !full) || connection.draining) {
+        wanted |= EPOLLIN;
+    }
+    // Also with nothing to send, when the session waits to be resumed
+    if (connection.pending() > 0 || connection.session.blocked()) {
+        wanted |= EPOLLOUT;
+    }
+    if (wanted != connection.events) {
+        epoll_event event{};
+        event.events = wanted;
+        event.data.fd = connection.fd;
+        ::epoll_ctl(epoll, EPOLL_CTL_MOD, connection.fd, &event);
+        connection.events = wanted;
+    }
+}
+
+void TaskServer::close(Connection& connection) {
+    int fd = connection.fd;
+    ::epoll_ctl(epoll, EPOLL_CTL_DEL, fd, nullptr);
+    ::close(fd);
+    if (idleUsers.size() < kMaxIdleUsers) {
+        idleUsers.push_back(std::move(connection.users));
+    }
+    connections.erase(fd);
+}
+
+#else
+
+struct TaskServer::Connection {};
+
+TaskServer::TaskServer(const TaskProcessor& processor, const std::string& address) : processor(processor) {
+    throw std::runtime_error(fmt::format("Cannot listen on {}: server mode needs epoll (Linux)", address));
+}
+
+TaskServer::~TaskServer() = default;
+
+void TaskServer::run() {}
+
+void TaskServer::stop() {}
+
+#endif
@@ -0,0 +1,226 @@
+#include "task/cache.hpp"
+
+#include <filesystem>
+#include <random>
+#include <stdexcept>
+#include <system_error>
+#include <utility>
+#include <vector>
+#include <fmt/format.h>
+#include "output/sink.hpp"
+#include "task/codec.hpp"
+
+namespace {
+
+constexpr char kMagic[4] = {'W', 'Z', 'H', 'C'};
+
+// Seeds of the two halves of a content digest
+constexpr std::uint64_t kLowSeed = 0x9e3779b97f4a7c15ull;
+constexpr std::uint64_t kHighSeed = 0xc2b2ae3d27d4eb4full;
+
+// wyhash's default secret
+constexpr std::uint64_t kSecret[4] = {0x2d358dccaa6c78a5ull, 0x8bb84b93962eacc9ull, 0x4b33a62ed433d4a3ull,
+                                      0x4d5a2da51de1aa47ull};
+
+/// @brief The full 128-bit product of a and b, low half in a and high half in b
+inline void multiply(std::uint64_t& a, std::uint64_t& b) {
+#if defined(__SIZEOF_INT128__)
+    __uint128_t product = static_cast<__uint128_t>(a) * b;
+    a = static_cast<std::uint64_t>(product);
+    b = static_cast<std::uint64_t>(product >> 64);
+#else
+    std::uint64_t aHigh = a >> 32, aLow = static_cast<std::uint32_t>(a);
+    std::uint64_t bHigh = b >> 32, bLow = static_cast<std::uint32_t>(b);
+    std::uint64_t high = aHigh * bHigh, middle0 = aHigh * bLow, middle1 = aLow * bHigh, low = aLow * bLow;
+    std::uint64_t carry = (low >> 32) + static_cast<std::uint32_t>(middle0) + static_cast<std::uint32_t>(middle1);
+    a = (carry << 32) | static_cast<std::uint32_t>(low);
+    b = high + (middle0 >> 32) + (middle1 >> 32) + (carry >> 32);
+#endif
+}
+
+inline std::uint64_t mix(std::uint64_t a, std::uint64_t b) {
+    multiply(a, b);
+    return a ^ b;
+}
+
+inline std::uint64_t read8(const char* p) { return getLe(p, 8); }
+inline std::uint64_t read4(const char* p) { return getLe(p, 4); }
+
+/// @brief One to three bytes, each of them at least once
+inline std::uint64_t read3(const char* p, size_t k) {
+    return (std::uint64_t(static_cast<unsigned char>(p[0])) << 16) |
+           (std::uint64_t(static_cast<unsigned char>(p[k >> 1])) << 8) | static_cast<unsigned char>(p[k - 1]);
+}
+
+} // namespace
+
+std::uint64_t ResultCache::hash(std::string_view bytes, std::uint64_t seed) {
+    const char* p = bytes.data();
+    size_t length = bytes.size();
+    seed ^= mix(seed ^ kSecret[0], kSecret[1]);
+    std::uint64_t a;
+    std::uint64_t b;
+    if (length <= 16) {
+        if (length >= 4) {
+            size_t step = (length >> 3) << 2;
+            a = (read4(p) << 32) | read4(p + step);
+            b = (read4(p + length - 4) << 32) | read4(p + length - 4 - step);
+        } else if (length > 0) {
+            a = read3(p, length);
+            b = 0;
+        } else {
+            a = b = 0;
+        }
+    } else {
+        size_t left = length;
+        if (left > 48) {
+            // Three independent lanes, so the multiplies overlap
+            std::uint64_t lane1 = seed;
+            std::uint64_t lane2 = seed;
+            do {
+                seed = mix(read8(p) ^ kSecret[1], read8(p + 8) ^ seed);
+                lane1 = mix(read8(p + 16) ^ kSecret[2], read8(p + 24) ^ lane1);
+                lane2 = mix(read8(p + 32) ^ kSecret[3], read8(p + 40) ^ lane2);
+                p += 48;
+                left -= 48;
+            } while (left > 48);
+            seed ^= lane1 ^ lane2;
+        }
+        while (left > 16) {
+            seed = mix(read8(p) ^ kSecret[1], read8(p + 8) ^ seed);
+            p += 16;
+            left -= 16;
+        }
+        a = read8(p + left - 16);
+        b = read8(p + left - 8);
+    }
+    a ^= kSecret[1];
+    b ^= seed;
+    multiply(a, b);
+    return mix(a ^ kSecret[0] ^ length, b ^ kSecret[1]);
+}
+
+std::uint64_t ResultCache::binaryVersion() {
+    static const std::uint64_t version = [] {
+#if defined(__linux__)
+        try {
+            MappedFile image("/proc/self/exe");
+            if (image.size() > 0) {
+                return hash(image.view(), kLowSeed);
+            }
+        } catch (const std::runtime_error&) {
+            // Fall back to the build time below
+        }
+#endif
+        return hash(__DATE__ " " __TIME__, kLowSeed);
+    }();
+    return version;
+}
+
+CacheKey ResultCache::keyOf(const MappedFile& file, std::uint64_t context) {
+    std::string_view bytes = file.view();
+    return CacheKey{hash(bytes, kLowSeed), hash(bytes, kHighSeed), bytes.size(), context};
+}
+
+ResultCache::ResultCache(std::string directory) : root(std::move(directory)) {
+    if (root.empty()) {
+        return;
+    }
+    std::error_code error;
+    std::filesystem::create_directories(root, error);
+    if (error || !std::filesystem::is_directory(root)) {
+        throw std::runtime_error(fmt::format("Cannot create cache directory {}: {}", root,
+                                             error ? error.message() : "not a directory"));
+    }
+}
+
+std::shared_ptr<const CachedResult> ResultCache::find(const CacheKey& key) {
+    auto it = entries.find(key);
+    if (it != entries.end()) {
+        ++counters.hits;
+        return it->second;
+    }
+    if (auto result = load(key)) {
+        ++counters.hits;
+        ++counters.diskHits;
+        entries.emplace(key, result);
+        return result;
+    }
+    ++counters.misses;
+    return nullptr;
+}
+
+void ResultCache::store(const CacheKey& key, std::shared_ptr<const CachedResult> result) {
+    if (!root.empty() && save(key, *result)) {
+        ++counters.stored;
+    }
+    entries[key] = std::move(result);
+}
+
+void ResultCache::countRepeat() {
+    ++counters.hits;
+    ++counters.repeats;
+}
+
+std::string ResultCache::entryPath(const CacheKey& key) const {
+    return fmt::format("{}/{:016x}{:016x}-{:016x}.wzc", root, key.high, key.low, key.context);
+}
+
+std::shared_ptr<const CachedResult> ResultCache::load(const CacheKey& key) const {
+    if (root.empty()) {
+        return nullptr;
+    }
+    std::string path = entryPath(key);
+    std::error_code error;
+    if (!std::filesystem::exists(path, error)) {
+        return nullptr;
+    }
+    try {
+        MappedFile file(path);
+        std::string_view data = file.view();
+        if (data.size() < kHeaderBytes || data.substr(0, sizeof(kMagic)) != std::string_view(kMagic, sizeof(kMagic)) ||
+            getLe(data.data() + 4, 4) != kVersion) {
+            return nullptr;
+        }
+        CacheKey stored{getLe(data.data() + 8, 8), getLe(data.data() + 16, 8), getLe(data.data() + 24, 8),
+                        getLe(data.data() + 32, 8)};
+        std::string_view body = data.substr(kHeaderBytes);
+        if (!(stored == key) || getLe(data.data() + 41, 8) != checksum(body)) {
+            return nullptr;
+        }
+        return std::make_shared<const CachedResult>(CachedResult{std::string(body), data[40] != 0});
+    } catch (const std::runtime_error&) {
+        return nullptr;
+    }
+}
+
+bool ResultCache::save(const CacheKey& key, const CachedResult& result) const {
+    std::string header(kMagic, sizeof(kMagic));
+    putLe(header, kVersion, 4);
+    putLe(header, key.low, 8);
+    putLe(header, key.high, 8);
+    putLe(header, key.size, 8);
+    putLe(header, key.context, 8);
+    header.push_back(result.completed ? 1 : 0);
+    putLe(header, checksum(result.body), 8);
+
+    // Written aside and renamed into place, so a reader (possibly another
+    // process) sees a whole entry or none
+    std::string path = entryPath(key);
+    std::string temporary = fmt::format("{}.{:08x}.tmp", path, std::random_device{}());
+    try {
+        FileSink out(temporary);
+        out.write(std::vector<std::string_view>{header, result.body});
+    } catch (const std::runtime_error&) {
+        std::error_code ignored;
+        std::filesystem::remove(temporary, ignored);
+        return false;
+    }
+    std::error_code error;
+    std::filesystem::rename(temporary, path, error);
+    if (error) {
+        std::filesystem::remove(temporary, error);
+        return false;
+    }
+    return true;
+}
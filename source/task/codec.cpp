@@ -0,0 +1,21 @@
+#include "task/codec.hpp"
+
+#include <fmt/format.h>
+
+std::uint64_t checksum(std::string_view bytes) {
+    constexpr std::uint64_t kPrime = 1099511628211ull;
+    std::uint64_t h = 14695981039346656037ull;
+    size_t i = 0;
+    for (; i + 8 <= bytes.size(); i += 8) {
+        h = (h ^ getLe(bytes.data() + i, 8)) * kPrime;
+        h ^= h >> 32;
+    }
+    for (; i < bytes.size(); ++i) {
+        h = (h ^ static_cast<unsigned char>(bytes[i])) * kPrime;
+    }
+    return h;
+}
+
+void ByteReader::fail(const char* what) const {
+    throw std::runtime_error(fmt::format("Corrupt {}: {}", format, what));
+}
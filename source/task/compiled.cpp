@@ -0,0 +1,173 @@
+#include "task/compiled.hpp"
+
+#include <limits>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <variant>
+#include <fmt/format.h>
+#include "output/sink.hpp"
+#include "profile/profiler.hpp"
+#include "task/codec.hpp"
+#include "task/processor.hpp"
+#include "task/source.hpp"
+
+namespace {
+
+constexpr char kMagic[4] = {'W', 'Z', 'H', 'T'};
+
+static_assert(std::variant_size_v<Command> < CompiledTask::kInvalidLine, "Opcodes must fit in a byte");
+
+std::runtime_error corrupt(const char* what) {
+    return std::runtime_error(fmt::format("Corrupt compiled task: {}", what));
+}
+
+/// @brief Appends entries, interning their strings
+class Encoder : public OperandWriter<Encoder> {
+private:
+    std::string& strings;
+    std::unordered_map<std::string_view, std::uint32_t> index;
+
+public:
+    Encoder(std::string& code, std::string& strings) : OperandWriter(code), strings(strings) {}
+
+    size_t stringCount() const { return index.size(); }
+
+    using OperandWriter::put;
+    void put(std::string_view text) {
+        auto [it, added] = index.try_emplace(text, static_cast<std::uint32_t>(index.size()));
+        if (added) {
+            if (text.size() > std::numeric_limits<std::uint32_t>::max()) {
+                throw std::runtime_error("String operand exceeds 4 GiB");
+            }
+            putVarint(strings, static_cast<std::uint32_t>(text.size()));
+            strings.append(text);
+        }
+        putVarint(out, it->second);
+    }
+};
+
+/// @brief Reads operands of one entry, bounds-checked
+class Decoder : public OperandReader<Decoder> {
+private:
+    const std::vector<std::string_view>& strings;
+
+public:
+    Decoder(std::string_view data, size_t& position, const std::vector<std::string_view>& strings)
+        : OperandReader(data, position, "compiled task"), strings(strings) {}
+
+    using OperandReader::get;
+    void get(std::string_view& text) {
+        std::uint32_t i = varint();
+        if (i >= strings.size()) {
+            fail("string index out of range");
+        }
+        text = strings[i];
+    }
+};
+
+} // namespace
+
+CompileStats compileTask(const std::string& source, const std::string& target) {
+    TaskSource lines(source);
+    CompileStats stats;
+    stats.sourceBytes = lines.bytes();
+
+    std::string strings;
+    std::string code;
+    Encoder encoder(code, strings);
+    while (auto line = lines.nextTokenized()) {
+        if (auto cmd = TaskProcessor::parseCommand(*line)) {
+            code.push_back(static_cast<char>(cmd->index()));
+            encoder.putCommand(*cmd);
+        } else {
+            code.push_back(static_cast<char>(CompiledTask::kInvalidLine));
+            encoder.put(line->view());
+            ++stats.invalidLines;
+        }
+        ++stats.commands;
+    }
+    if (stats.commands > std::numeric_limits<std::uint32_t>::max()) {
+        throw std::runtime_error("Task has more than 2^32 commands");
+    }
+
+    // Both sections follow the header back to back
+    size_t stringBytes = strings.size();
+    std::string body = std::move(strings);
+    body += code;
+
+    std::string header(kMagic, sizeof(kMagic));
+    putLe(header, CompiledTask::kVersion, 4);
+    putLe(header, checksum(body), 8);
+    putLe(header, encoder.stringCount(), 4);
+    putLe(header, stats.commands, 4);
+    putLe(header, stringBytes, 8);
+
+    FileSink out(target);
+    out.write(std::vector<std::string_view>{header, body});
+
+    stats.strings = encoder.stringCount();
+    stats.compiledBytes = header.size() + body.size();
+    return stats;
+}
+
+bool CompiledTask::matches(std::string_view contents) {
+    return contents.size() >= sizeof(kMagic) && contents.substr(0, sizeof(kMagic)) == std::string_view(kMagic, 4);
+}
+
+CompiledTask::CompiledTask(MappedFile mapped) : file(std::move(mapped)) {
+    std::string_view data = file.view();
+    if (data.size() < kHeaderBytes || !matches(data)) {
+        throw corrupt("missing header");
+    }
+    std::uint32_t version = static_cast<std::uint32_t>(getLe(data.data() + 4, 4));
+    if (version != kVersion) {
+        throw std::runtime_error(fmt::format("Compiled task has format version {}, expected {}; recompile it",
+                                             version, kVersion));
+    }
+    if (getLe(data.data() + 8, 8) != checksum(data.substr(kHeaderBytes))) {
+        throw corrupt("checksum mismatch");
+    }
+    size_t stringCount = static_cast<size_t>(getLe(data.data() + 16, 4));
+    entryCount = static_cast<size_t>(getLe(data.data() + 20, 4));
+    std::uint64_t stringBytes = getLe(data.data() + 24, 8);
+    if (stringBytes > data.size() - kHeaderBytes) {
+        throw corrupt("string section out of range");
+    }
+    // Each string and entry takes a byte at least; this bounds what is reserved
+    if (stringCount > stringBytes || entryCount > data.size() - kHeaderBytes - stringBytes) {
+        throw corrupt("counts out of range");
+    }
+
+    std::string_view section = data.substr(kHeaderBytes, static_cast<size_t>(stringBytes));
+    size_t offset = 0;
+    Decoder decoder(section, offset, strings);
+    strings.reserve(stringCount);
+    for (size_t i = 0; i < stringCount; ++i) {
+        std::uint32_t length = decoder.varint();
+        if (length > section.size() - offset) {
+            throw corrupt("string out of range");
+        }
+        strings.push_back(section.substr(offset, length));
+        offset += length;
+    }
+    position = kHeaderBytes + static_cast<size_t>(stringBytes);
+}
+
+bool CompiledTask::next(CompiledLine& line) {
+    WZH_PROFILE_PHASE(Phase::Read);
+    if (decoded == entryCount) {
+        return false;
+    }
+    Decoder decoder(file.view(), position, strings);
+    std::uint8_t opcode = decoder.byte();
+    if (opcode == kInvalidLine) {
+        line.command.reset();
+        decoder.get(line.text);
+    } else {
+        line.command = decoder.getCommand(opcode);
+        line.text = {};
+    }
+    ++decoded;
+    return true;
+}
@@ -0,0 +1,207 @@
+#include "task/journal.hpp"
+
+#include <filesystem>
+#include <limits>
+#include <stdexcept>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+#include <variant>
+#include <vector>
+#include <fmt/format.h>
+#include "task/codec.hpp"
+#include "task/mapped.hpp"
+
+namespace {
+
+constexpr char kMagic[4] = {'W', 'Z', 'H', 'J'};
+constexpr size_t kBatchHeaderBytes = 16;
+
+/// @brief Appends the operands of a record, strings inline
+class RecordWriter : public OperandWriter<RecordWriter> {
+public:
+    explicit RecordWriter(std::string& out) : OperandWriter(out) {}
+
+    using OperandWriter::put;
+    void put(std::string_view text) {
+        if (text.size() > std::numeric_limits<std::uint32_t>::max()) {
+            throw std::runtime_error("Journal string exceeds 4 GiB");
+        }
+        putVarint(out, static_cast<std::uint32_t>(text.size()));
+        out.append(text);
+    }
+};
+
+/// @brief Reads the records of one batch, bounds-checked
+class RecordReader : public OperandReader<RecordReader> {
+public:
+    RecordReader(std::string_view data, size_t& position) : OperandReader(data, position, "journal") {}
+
+    using OperandReader::get;
+    void get(std::string_view& text) { text = bytes(varint()); }
+};
+
+/// @brief Length of the header and the whole, intact batches after it
+size_t validLength(std::string_view data) {
+    size_t position = Journal::kHeaderBytes;
+    while (data.size() - position >= kBatchHeaderBytes) {
+        std::uint64_t payload = getLe(data.data() + position, 4);
+        if (payload > data.size() - position - kBatchHeaderBytes) {
+            break;
+        }
+        std::string_view body = data.substr(position + kBatchHeaderBytes, static_cast<size_t>(payload));
+        if (getLe(data.data() + position + 8, 8) != checksum(body)) {
+            break;
+        }
+        position += kBatchHeaderBytes + body.size();
+    }
+    return position;
+}
+
+} // namespace
+
+bool Journal::records(const Command& command) {
+    // Everything but the queries; a new command is journaled unless listed here
+    return std::visit([](const auto& cmd) {
+        using T = std::decay_t<decltype(cmd)>;
+        return !(std::is_same_v<T, PingCommand> || std::is_same_v<T, GetUsersCommand> ||
+                 std::is_same_v<T, GetGroupsCommand> || std::is_same_v<T, GetMessageHistoryCommand> ||
+                 std::is_same_v<T, ExitCommand>);
+    }, command);
+}
+
+Journal::Journal(const std::string& filename) : filename(filename) {
+    std::error_code error;
+    auto size = std::filesystem::file_size(filename, error);
+    // Missing, or cut short while it was being created
+    if (error || size < kHeaderBytes) {
+        create(0);
+        return;
+    }
+
+    {
+        MappedFile mapped(filename);
+        std::string_view data = mapped.view();
+        if (data.size() < kHeaderBytes || data.substr(0, sizeof(kMagic)) != std::string_view(kMagic, sizeof(kMagic))) {
+            throw std::runtime_error(fmt::format("Not a journal: {}", filename));
+        }
+        std::uint32_t version = static_cast<std::uint32_t>(getLe(data.data() + 4, 4));
+        if (version != kVersion) {
+            throw std::runtime_error(fmt::format("Journal has format version {}, expected {}", version, kVersion));
+        }
+        journalGeneration = getLe(data.data() + 8, 8);
+        committedBytes = validLength(data);
+    }
+    // Drop a batch torn by a crash, so new ones follow the last intact one
+    if (committedBytes < size) {
+        std::filesystem::resize_file(filename, committedBytes, error);
+        if (error) {
+            throw std::runtime_error(fmt::format("Cannot truncate {}: {}", filename, error.message()));
+        }
+    }
+    file = std::make_unique<FileSink>(filename, FileSink::Mode::Append);
+}
+
+Journal::~Journal() {
+    try {
+        commit();
+    } catch (const std::exception&) {
+        // Whoever needed to know has called commit() already
+    }
+}
+
+void Journal::create(std::uint64_t generation) {
+    std::string header(kMagic, sizeof(kMagic));
+    putLe(header, kVersion, 4);
+    putLe(header, generation, 8);
+
+    file = std::make_unique<FileSink>(filename);
+    file->write(header);
+    file->sync();
+    journalGeneration = generation;
+    committedBytes = header.size();
+}
+
+void Journal::replay(const std::function<void(const Command&)>& apply) {
+    commit();
+    if (committedBytes == kHeaderBytes) {
+        return;
+    }
+    MappedFile mapped(filename);
+    std::string_view data = mapped.view().substr(0, committedBytes);
+
+    // validLength() has checked every batch's size and checksum
+    size_t position = kHeaderBytes;
+    while (position < data.size()) {
+        auto payload = static_cast<size_t>(getLe(data.data() + position, 4));
+        auto count = static_cast<std::uint32_t>(getLe(data.data() + position + 4, 4));
+        std::string_view body = data.substr(position + kBatchHeaderBytes, payload);
+
+        size_t offset = 0;
+        RecordReader reader(body, offset);
+        for (std::uint32_t i = 0; i < count; ++i) {
+            apply(reader.getCommand(reader.byte()));
+            ++counters.replayed;
+        }
+        if (reader.remaining() != 0) {
+            reader.fail("trailing bytes in batch");
+        }
+        position += kBatchHeaderBytes + payload;
+    }
+}
+
+void Journal::append(const Command& command) {
+    batch.push_back(static_cast<char>(command.index()));
+    RecordWriter(batch).putCommand(command);
+    ++batchRecords;
+    ++counters.recorded;
+    if (batch.size() >= kBatchBytes) {
+        commit();
+    }
+}
+
+void Journal::commit() {
+    if (batchRecords == 0) {
+        return;
+    }
+    if (unusable) {
+        throw std::runtime_error(fmt::format("Journal {} could not be cut back after a failed commit", filename));
+    }
+    if (batch.size() > std::numeric_limits<std::uint32_t>::max()) {
+        throw std::runtime_error("Journal batch exceeds 4 GiB");
+    }
+    std::string header;
+    putLe(header, batch.size(), 4);
+    putLe(header, batchRecords, 4);
+    putLe(header, checksum(batch), 8);
+
+    try {
+        file->write(std::vector<std::string_view>{header, batch});
+        file->sync();
+    } catch (const std::exception&) {
+        // Part of the batch may have reached the file. Cut it off, or a
+        // later commit would follow it and be dropped with it on reopening,
+        // and reopen the file to write at its new end; the batch is kept for
+        // the next commit to try again
+        std::error_code error;
+        std::filesystem::resize_file(filename, committedBytes, error);
+        unusable = true;
+        if (!error) {
+            file = std::make_unique<FileSink>(filename, FileSink::Mode::Append);
+            unusable = false;
+        }
+        throw;
+    }
+    committedBytes += header.size() + batch.size();
+    ++counters.commits;
+    counters.bytes += header.size() + batch.size();
+    batch.clear();
+    batchRecords = 0;
+}
+
+void Journal::restart(std::uint64_t generation) {
+    batch.clear();
+    batchRecords = 0;
+    create(generation);
+    unusable = false;
+}
@@ -0,0 +1,85 @@
+#include "task/mapped.hpp"
+
+#include <stdexcept>
+#include <utility>
+#include <fmt/format.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define MAPPED_FILE_MMAP 1
+#else
+#include <fstream>
+#include <iterator>
+#endif
+
+MappedFile::MappedFile(const std::string& filename) {
+#ifdef MAPPED_FILE_MMAP
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error(fmt::format("Cannot open file: {}", filename));
+    }
+    struct stat info {};
+    if (::fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0) {
+        void* addr = ::mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        if (addr != MAP_FAILED) {
+            ::madvise(addr, static_cast<size_t>(info.st_size), MADV_SEQUENTIAL);
+            bytes = static_cast<const char*>(addr);
+            length = static_cast<size_t>(info.st_size);
+            mapped = true;
+            ::close(fd);
+            return;
+        }
+    }
+    // Not mappable: read what the descriptor delivers
+    char chunk[1 << 16];
+    ssize_t count;
+    while ((count = ::read(fd, chunk, sizeof(chunk))) > 0) {
+        fallback.insert(fallback.end(), chunk, chunk + count);
+    }
+    ::close(fd);
+#else
+    std::ifstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
+        throw std::runtime_error(fmt::format("Cannot open file: {}", filename));
+    }
+    fallback.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+#endif
+    bytes = fallback.data();
+    length = fallback.size();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : bytes(other.bytes), length(other.length), mapped(other.mapped), fallback(std::move(other.fallback)) {
+    other.bytes = nullptr;
+    other.length = 0;
+    other.mapped = false;
+}
+
+MappedFile::~MappedFile() {
+#ifdef MAPPED_FILE_MMAP
+    if (mapped) {
+        ::munmap(const_cast<char*>(bytes), length);
+    }
+#endif
+}
+
+size_t MappedFile::release(size_t from, size_t upTo) {
+#ifdef MAPPED_FILE_MMAP
+    if (!mapped) {
+        return from;
+    }
+    static const size_t pageSize = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+    size_t end = upTo - upTo % pageSize;
+    if (end <= from) {
+        return from;
+    }
+    ::madvise(const_cast<char*>(bytes + from), end - from, MADV_DONTNEED);
+    return end;
+#else
+    (void)upTo;
+    return from;
+#endif
+}
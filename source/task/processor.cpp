@@ -1,105 +1,769 @@
 #include "task/processor.hpp"
 #include <algorithm>
+#include <atomic>
 #include <cctype>
-#include <fstream>
-#include <iostream>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
 #include <stdexcept>
+#include <thread>
+#include <unordered_map>
+#include <utility>
 #include <fmt/format.h>
 #include "commands/executor.hpp"
+#include "commands/render.hpp"
 #include "parser/parser.hpp"
+#include "profile/profiler.hpp"
+#include "task/cache.hpp"
+#include "task/codec.hpp"
+#include "task/compiled.hpp"
+#include "task/journal.hpp"
+#include "task/mapped.hpp"
+#include "task/ring.hpp"
+#include "task/scan.hpp"
+#include "task/scheduler.hpp"
+#include "task/snapshot.hpp"
+#include "task/source.hpp"
 
-void TaskProcessor::registerCommands() {
-    registry.registerExecutor<CreateUserCommand>(std::make_unique<CreateUserExecutor>());
-    registry.registerExecutor<DeleteUserCommand>(std::make_unique<DeleteUserExecutor>());
-    registry.registerExecutor<DisableUserCommand>(std::make_unique<DisableUserExecutor>());
-    registry.registerExecutor<SendMessageCommand>(std::make_unique<SendMessageExecutor>());
-    registry.registerExecutor<PingCommand>(std::make_unique<PingExecutor>());
-    registry.registerExecutor<AddUserToGroupCommand>(std::make_unique<AddUserToGroupExecutor>());
-    registry.registerExecutor<RemoveUserFromGroupCommand>(std::make_unique<RemoveUserFromGroupExecutor>());
-    registry.registerExecutor<GetUsersCommand>(std::make_unique<GetUsersExecutor>());
-    registry.registerExecutor<GetGroupsCommand>(std::make_unique<GetGroupsExecutor>());
-    registry.registerExecutor<GetMessageHistoryCommand>(std::make_unique<GetMessageHistoryExecutor>());
-    registry.registerExecutor<ExitCommand>(std::make_unique<ExitExecutor>());
+std::optional<Command> TaskProcessor::parseCommand(std::string_view line) {
+    WZH_PROFILE_PHASE(Phase::Parse);
+    return CommandParser::parse(line);
 }
 
-std::vector<std::string> TaskProcessor::readTaskFile(const std::string& filename) {
-    std::ifstream file(filename);
-    if (!file.is_open()) {
-        throw std::runtime_error(fmt::format("Cannot open file: {}", filename));
+std::optional<Command> TaskProcessor::parseCommand(const grammar::Line& line) {
+    WZH_PROFILE_PHASE(Phase::Parse);
+    return CommandParser::parse(line);
+}
+
+// Built-in executors are bound to their command types at compile time
+// (see ExecutorFor); registry.registerExecutor<T>() overrides one at runtime
+TaskProcessor::TaskProcessor(ProcessorOptions options, OutputSink& output)
+    : options(options), output(output) {
+    if (options.parseWorkers > 1) {
+        parsePool = std::make_unique<WorkStealingScheduler>(options.parseWorkers);
+    }
+    if (options.sharedState != nullptr && (options.snapshot || options.journal || options.cache)) {
+        throw std::runtime_error("Shared user state is neither restored, recorded nor cached, so it cannot be "
+                                 "used with a snapshot, journal or cache");
+    }
+    if (options.cache != nullptr) {
+        if (options.journal != nullptr) {
+            throw std::runtime_error("A journal records every task, so it cannot be used with a cache");
+        }
+        // A transcript depends on the binary, the quiet flag and the state it starts from
+        std::string context;
+        putLe(context, ResultCache::binaryVersion(), 8);
+        putLe(context, options.quiet ? 1 : 0, 1);
+        putLe(context, options.snapshot ? options.snapshot->contentChecksum() : 0, 8);
+        putLe(context, options.snapshot ? options.snapshot->generation() : 0, 8);
+        cacheContext = ResultCache::hash(context, 0);
+    }
+    if (options.journal == nullptr) {
+        return;
+    }
+    std::uint64_t snapshotGeneration = options.snapshot ? options.snapshot->generation() : 0;
+    if (options.journal->generation() > snapshotGeneration) {
+        throw std::runtime_error(fmt::format("The journal continues a snapshot of generation {}, not {}",
+                                             options.journal->generation(), snapshotGeneration));
+    }
+    // Saved before a snapshot that already holds its commands
+    if (options.journal->generation() < snapshotGeneration) {
+        options.journal->restart(snapshotGeneration);
+    }
+}
+
+void TaskProcessor::startState(UserManager& users) const {
+    if (options.sharedState) {
+        return;   // Tasks continue from the shared store as they find it
+    }
+    if (options.snapshot) {
+        options.snapshot->restore(users);
+    } else {
+        users.reset();
+    }
+    if (options.journal) {
+        options.journal->replay([&](const Command& cmd) { registry.execute(cmd, users); });
+    }
+}
+
+namespace {
+
+constexpr size_t kChunkLines = 4096;
+
+// Split parsing: chunks in flight per pool worker
+constexpr size_t kSplitWindowPerWorker = 4;
+
+// Pipeline mode: lines per batch handed from the parser thread, batches in flight
+constexpr size_t kPipelineBatchLines = 256;
+constexpr size_t kPipelineBatches = 16;
+
+/// @brief Slice of a large task parsed ahead of its execution
+struct ParsedChunk {
+    enum State : int { Pending, Running, Done };
+
+    std::string_view text;                         // If set, split into lines by parse()
+    std::vector<std::string_view> lines;
+    std::vector<std::optional<Command>> commands;  // One per line up to error, if any
+    std::exception_ptr error;                      // Thrown while parsing lines[commands.size()]
+    std::atomic<int> state{Pending};
+
+    /// @brief Take ownership of parsing; fails if someone else has it or it was cancelled
+    bool claim() {
+        int expected = Pending;
+        return state.compare_exchange_strong(expected, Running);
     }
-    std::vector<std::string> lines;
-    std::string line;
-    while (std::getline(file, line)) {
-        // Remove comments
-        size_t commentPos = line.find('#');
-        if (commentPos != std::string::npos) {
-            line = line.substr(0, commentPos);
+
+    void parse() {
+        if (!text.empty()) {
+            split();
+        }
+        commands.reserve(lines.size());
+        try {
+            // Nothing past an invalid line runs
+            for (auto line : lines) {
+                commands.push_back(TaskProcessor::parseCommand(line));
+                if (!commands.back()) {
+                    break;
+                }
+            }
+        } catch (...) {
+            error = std::current_exception();
         }
+        state.store(Done, std::memory_order_release);
+    }
 
-        // Trim whitespace (including \r for cross-platform compatibility)
-        line.erase(0, line.find_first_not_of(" \t\r\n"));
-        line.erase(line.find_last_not_of(" \t\r\n") + 1);
+    bool done() const { return state.load(std::memory_order_acquire) == Done; }
 
-        if (!line.empty()) {
-            lines.push_back(line);
+    /// @brief Lines of text, which starts a line and ends with one
+    void split() {
+        LineScanner scanner;
+        std::vector<LineSpan> spans;
+        scanner.scan(text, 0, text.size(), spans);
+        scanner.finish(text.size(), spans);
+        lines.reserve(spans.size());
+        for (const auto& span : spans) {
+            std::string_view line = taskLineCommand(text.substr(span.start, span.end - span.start));
+            if (!line.empty()) {
+                lines.push_back(line);
+            }
         }
     }
-    return lines;
-}
+};
+
+/// @brief Cancels chunks still queued and waits for those being parsed
+///
+/// Chunks view into the task source, so none may be running once it is gone.
+struct ChunkWindowGuard {
+    std::deque<std::shared_ptr<ParsedChunk>>& window;
+
+    ~ChunkWindowGuard() {
+        for (auto& chunk : window) {
+            int expected = ParsedChunk::Pending;
+            if (!chunk->state.compare_exchange_strong(expected, ParsedChunk::Done)) {
+                while (!chunk->done()) {
+                    std::this_thread::yield();
+                }
+            }
+        }
+    }
+};
 
-std::optional<Command> TaskProcessor::parseCommand(const std::string& line) {
-    auto parser = CommandParser::commandParser();
-    auto result = parser(line, 0);
+} // namespace
+
+TaskProcessor::LineOutcome TaskProcessor::executeLine(std::string_view line, const std::optional<Command>& cmdOpt,
+                                                      UserManager& users, BufferedOutput& out) const {
+    if (!cmdOpt) {
+        if (!options.quiet) {
+            out.print("❌ Invalid command: {}\n{}", line, CommandParser::diagnose(line));
+        }
+        return LineOutcome::Stop;
+    }
     
-    if (result.success() && result.index() == line.length()) {
-        return result.value();
+    CommandResult result = executeCommand(*cmdOpt, users);
+    if (!options.quiet) {
+        WZH_PROFILE_PHASE(Phase::Render);
+        renderResult(result, out);
     }
-    return std::nullopt;
+    return lineOutcome(*cmdOpt, result);
 }
 
-TaskProcessor::TaskProcessor() {
-    registerCommands();
+CommandResult TaskProcessor::executeCommand(const Command& cmd, UserManager& users) const {
+    WZH_PROFILE_PHASE(Phase::Execute);
+    if (options.sharedState) {
+        return registry.execute(cmd, *options.sharedState);
+    }
+    return registry.execute(cmd, users);
 }
 
-void TaskProcessor::processTask(const std::string& filename) {
-    userManager.reset();
-    
-    std::cout << fmt::format("[Processing task: {}]\n", filename);
+TaskProcessor::LineOutcome TaskProcessor::lineOutcome(const Command& cmd, const CommandResult& result) const {
+    if (result.shouldExit) {
+        return LineOutcome::Exit;
+    }
     
-    try {
-        auto lines = readTaskFile(filename);
-        
-        for (const auto& line : lines) {
-            auto cmdOpt = parseCommand(line);
-            if (!cmdOpt) {
-                std::cout << fmt::format("❌ Invalid command: {}\n", line);
-                std::cout << fmt::format("[Task {} stopped due to failure]\n\n", filename);
-                return;
-            }
-            
-            auto result = registry.execute(*cmdOpt, userManager);
-            std::cout << result.message << "\n";
-            
-            if (result.shouldExit) {
+    if (!result.success()) {
+        return LineOutcome::Stop;
+    }
+    if (options.journal && Journal::records(cmd)) {
+        options.journal->append(cmd);
+    }
+    return LineOutcome::Continue;
+}
+
+bool TaskProcessor::runLines(TaskSource& source, UserManager& users, BufferedOutput& out) const {
+    while (auto line = source.nextTokenized()) {
+        auto outcome = executeLine(line->view(), parseCommand(*line), users, out);
+        if (outcome != LineOutcome::Continue) {
+            return outcome == LineOutcome::Exit;
+        }
+    }
+    return true;
+}
+
+bool TaskProcessor::runCompiled(CompiledTask& task, UserManager& users, BufferedOutput& out) const {
+    CompiledLine line;
+    while (task.next(line)) {
+        auto outcome = executeLine(line.text, line.command, users, out);
+        if (outcome != LineOutcome::Continue) {
+            return outcome == LineOutcome::Exit;
+        }
+    }
+    return true;
+}
+
+bool TaskProcessor::runChunkedLines(TaskSource& source, UserManager& users, BufferedOutput& out,
+                                    WorkStealingScheduler& scheduler) const {
+    // Chunks are queued on this worker and parsed by whoever gets to them
+    // first; execution consumes them strictly in file order
+    const size_t maxWindow = 2 * scheduler.workerCount();
+    std::deque<std::shared_ptr<ParsedChunk>> window;
+    ChunkWindowGuard guard{window};
+    bool exhausted = false;
+
+    auto refill = [&] {
+        while (!exhausted && window.size() < maxWindow) {
+            auto chunk = std::make_shared<ParsedChunk>();
+            chunk->lines.reserve(kChunkLines);
+            while (chunk->lines.size() < kChunkLines) {
+                auto line = source.next();
+                if (!line) {
+                    exhausted = true;
+                    break;
+                }
+                chunk->lines.push_back(*line);
+            }
+            if (chunk->lines.empty()) {
                 break;
             }
-            
-            if (!result.success) {
-                std::cout << fmt::format("[Task {} stopped due to failure]\n\n", filename);
-                return;
+            window.push_back(chunk);
+            scheduler.submitChunk([chunk] {
+                if (chunk->claim()) {
+                    chunk->parse();
+                }
+            });
+        }
+    };
+
+    refill();
+    while (!window.empty()) {
+        auto chunk = window.front();
+        if (chunk->claim()) {
+            chunk->parse();
+        } else {
+            scheduler.helpWithChunks([&] { return chunk->done(); });
+        }
+        window.pop_front();
+        refill();
+
+        for (size_t k = 0; k < chunk->commands.size(); ++k) {
+            auto outcome = executeLine(chunk->lines[k], chunk->commands[k], users, out);
+            if (outcome != LineOutcome::Continue) {
+                return outcome == LineOutcome::Exit;
+            }
+        }
+        if (chunk->error) {
+            std::rethrow_exception(chunk->error);
+        }
+    }
+    return true;
+}
+
+bool TaskProcessor::runSplitLines(MappedFile& file, UserManager& users, BufferedOutput& out,
+                                  WorkStealingScheduler& pool) const {
+    // Lines never span a newline, so chunks cut after one parse on their
+    // own; the pool scans and parses them while this thread executes the
+    // finished ones strictly in file order
+    std::string_view text = file.view();
+    const size_t maxWindow = kSplitWindowPerWorker * pool.workerCount();
+    std::deque<std::shared_ptr<ParsedChunk>> window;
+    ChunkWindowGuard guard{window};
+    size_t split = 0;
+    size_t submitted = 0;
+    size_t released = 0;
+
+    auto refill = [&] {
+        while (split < text.size() && window.size() < maxWindow) {
+            size_t end = text.size();
+            if (text.size() - split > kSplitBytes) {
+                size_t lineEnd = text.find('\n', split + kSplitBytes);
+                if (lineEnd != std::string_view::npos) {
+                    end = lineEnd + 1;
+                }
             }
+            auto chunk = std::make_shared<ParsedChunk>();
+            chunk->text = text.substr(split, end - split);
+            split = end;
+            window.push_back(chunk);
+            pool.submitTask(submitted++, [chunk] {
+                if (chunk->claim()) {
+                    chunk->parse();
+                }
+            });
         }
-        
-        std::cout << fmt::format("[Task {} completed successfully]\n\n", filename);
-        
+    };
+
+    refill();
+    while (!window.empty()) {
+        auto chunk = window.front();
+        if (chunk->claim()) {
+            chunk->parse();
+        } else {
+            // Parse later chunks rather than wait idle for this one. A chunk
+            // once claimed stays claimed, so the scan only moves forward
+            size_t ahead = 1;
+            while (!chunk->done()) {
+                while (ahead < window.size() && !window[ahead]->claim()) {
+                    ++ahead;
+                }
+                if (ahead < window.size()) {
+                    window[ahead++]->parse();
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        }
+        window.pop_front();
+        refill();
+
+        for (size_t k = 0; k < chunk->commands.size(); ++k) {
+            auto outcome = executeLine(chunk->lines[k], chunk->commands[k], users, out);
+            if (outcome != LineOutcome::Continue) {
+                return outcome == LineOutcome::Exit;
+            }
+        }
+        if (chunk->error) {
+            std::rethrow_exception(chunk->error);
+        }
+        // As TaskSource does, hand executed pages back to the kernel
+        size_t consumed = static_cast<size_t>(chunk->text.data() + chunk->text.size() - text.data());
+        if (consumed - released >= TaskSource::kReleaseWindow) {
+            released = file.release(released, consumed);
+        }
+    }
+    return true;
+}
+
+bool TaskProcessor::runPipelinedLines(TaskSource& source, UserManager& users, BufferedOutput& out) const {
+    // The parser thread is the only producer and this thread the only consumer
+    SpscRing<std::unique_ptr<ParsedChunk>> ring(kPipelineBatches);
+    std::atomic<bool> cancelled{false};
+    std::atomic<bool> parsed{false};
+
+    std::thread parser([&] {
+        bool more = true;
+        while (more && !cancelled.load(std::memory_order_relaxed)) {
+            auto batch = std::make_unique<ParsedChunk>();
+            batch->lines.reserve(kPipelineBatchLines);
+            while (batch->lines.size() < kPipelineBatchLines) {
+                auto line = source.next();
+                if (!line) {
+                    more = false;
+                    break;
+                }
+                batch->lines.push_back(*line);
+            }
+            batch->parse();
+            if (batch->error) {
+                more = false;  // Nothing past the failing line will run
+            }
+            while (!ring.tryPush(batch)) {
+                if (cancelled.load(std::memory_order_relaxed)) {
+                    return;
+                }
+                std::this_thread::yield();
+            }
+        }
+        parsed.store(true, std::memory_order_release);
+    });
+
+    // Stops the parser early and joins it before the source goes away
+    struct ParserGuard {
+        std::thread& thread;
+        std::atomic<bool>& cancelled;
+        ~ParserGuard() {
+            cancelled.store(true, std::memory_order_relaxed);
+            thread.join();
+        }
+    } guard{parser, cancelled};
+
+    std::unique_ptr<ParsedChunk> batch;
+    for (;;) {
+        if (!ring.tryPop(batch)) {
+            // The parser publishes `parsed` after its last push
+            if (!parsed.load(std::memory_order_acquire)) {
+                std::this_thread::yield();
+                continue;
+            }
+            if (!ring.tryPop(batch)) {
+                return true;
+            }
+        }
+        for (size_t k = 0; k < batch->commands.size(); ++k) {
+            auto outcome = executeLine(batch->lines[k], batch->commands[k], users, out);
+            if (outcome != LineOutcome::Continue) {
+                return outcome == LineOutcome::Exit;
+            }
+        }
+        if (batch->error) {
+            std::rethrow_exception(batch->error);
+        }
+    }
+}
+
+void TaskProcessor::runTask(const std::string& filename, UserManager& users, BufferedOutput& out,
+                            WorkStealingScheduler* scheduler) const {
+    WZH_PROFILE_TASK(filename);
+    beginTask(filename, out);
+    
+    try {
+        startState(users);
+        // Commands view into the file, which lives until the task ends
+        endTask(filename, runTaskBody(MappedFile(filename), users, out, scheduler), out);
+    } catch (const std::exception& e) {
+        abortTask(filename, e, out);
+    }
+    if (options.journal) {
+        options.journal->commit();
+    }
+}
+
+bool TaskProcessor::runTaskBody(MappedFile file, UserManager& users, BufferedOutput& out,
+                                WorkStealingScheduler* scheduler) const {
+    if (CompiledTask::matches(file.view())) {
+        CompiledTask task(std::move(file));
+        return runCompiled(task, users, out);
+    }
+    if (scheduler == nullptr && parsePool && file.size() >= kLargeTaskBytes) {
+        return runSplitLines(file, users, out, *parsePool);
+    }
+    TaskSource source(std::move(file));
+    if (scheduler != nullptr && source.bytes() >= kLargeTaskBytes) {
+        return runChunkedLines(source, users, out, *scheduler);
+    }
+    if (scheduler == nullptr && options.pipeline) {
+        return runPipelinedLines(source, users, out);
+    }
+    return runLines(source, users, out);
+}
+
+std::shared_ptr<const CachedResult> TaskProcessor::runCacheableTask(const std::string& filename, const CacheKey& key,
+                                                                    UserManager& users, BufferedOutput& out,
+                                                                    WorkStealingScheduler* scheduler) const {
+    WZH_PROFILE_TASK(filename);
+    MemorySink body;
+    BufferedOutput bodyOut(body);
+    try {
+        startState(users);
+        MappedFile file(filename);
+        bool unchanged = ResultCache::keyOf(file, key.context) == key;
+        bool completed = runTaskBody(std::move(file), users, bodyOut, scheduler);
+        bodyOut.flush();
+        if (unchanged) {
+            return std::make_shared<const CachedResult>(CachedResult{body.take(), completed});
+        }
+        // Rewritten since it was looked up: the transcript is of bytes the
+        // key does not describe, so it is written but not kept
+        beginTask(filename, out);
+        out.append(body.contents());
+        endTask(filename, completed, out);
+        return nullptr;
     } catch (const std::exception& e) {
-        std::cout << fmt::format("❌ Error processing task {}: {}\n", filename, e.what());
-        std::cout << fmt::format("[Task {} stopped due to failure]\n\n", filename);
+        // Error messages name the file, so the transcript is not reusable
+        bodyOut.flush();
+        beginTask(filename, out);
+        out.append(body.contents());
+        abortTask(filename, e, out);
+        return nullptr;
+    }
+}
+
+void TaskProcessor::replayTask(const std::string& name, const CachedResult& result, BufferedOutput& out) const {
+    beginTask(name, out);
+    out.append(result.body);
+    endTask(name, result.completed, out);
+}
+
+void TaskProcessor::beginTask(const std::string& name, BufferedOutput& out) const {
+    // Quiet runs print one status line per task and nothing else
+    if (!options.quiet) {
+        out.print("[Processing task: {}]\n", name);
+    }
+}
+
+void TaskProcessor::endTask(const std::string& name, bool completed, BufferedOutput& out) const {
+    const char* taskEnd = options.quiet ? "\n" : "\n\n";
+    if (completed) {
+        out.print("[Task {} completed successfully]{}", name, taskEnd);
+    } else {
+        out.print("[Task {} stopped due to failure]{}", name, taskEnd);
+    }
+}
+
+void TaskProcessor::abortTask(const std::string& name, const std::exception& error, BufferedOutput& out) const {
+    if (!options.quiet) {
+        out.print("❌ Error processing task {}: {}\n", name, error.what());
+    }
+    endTask(name, false, out);
+}
+
+void TaskProcessor::processTask(const std::string& filename) {
+    BufferedOutput out(output);
+    runTask(filename, userManager, out);
+    out.flush();
+}
+
+void TaskProcessor::processTasks(const std::vector<std::string>& filenames, size_t jobs) {
+    if (options.journal && filenames.size() > 1) {
+        throw std::runtime_error("A journal records a single task");
+    }
+    if (options.cache) {
+        processCachedTasks(filenames, jobs);
+        return;
+    }
+    jobs = std::min(jobs, filenames.size());
+    if (jobs <= 1) {
+        BufferedOutput out(output);
+        for (const auto& filename : filenames) {
+            runTask(filename, userManager, out);
+        }
+        out.flush();
+        if (parsePool) {
+            schedulerStats = parsePool->stats();
+        }
+        arenaStats = userManager.allocationStats();
+        return;
+    }
+
+    // Tasks start spread evenly over the workers and are rebalanced by
+    // stealing. Each buffers its transcript privately; the calling thread
+    // writes finished transcripts in file order as soon as they are
+    // available, every run of consecutive finished ones in one write
+    std::vector<std::string> transcripts(filenames.size());
+    std::vector<bool> finished(filenames.size(), false);
+    std::vector<UserManager> managers(jobs);
+    std::mutex mutex;
+    std::condition_variable taskFinished;
+
+    WorkStealingScheduler scheduler(jobs);
+    for (size_t i = 0; i < filenames.size(); ++i) {
+        scheduler.submitTask(i, [&, i] {
+            MemorySink transcript;
+            {
+                BufferedOutput out(transcript);
+                runTask(filenames[i], managers[scheduler.currentWorker()], out, &scheduler);
+                out.flush();
+            }
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                transcripts[i] = transcript.take();
+                finished[i] = true;
+            }
+            taskFinished.notify_one();
+        });
+    }
+
+    std::vector<std::string> ready;
+    std::vector<std::string_view> blocks;
+    for (size_t next = 0; next < filenames.size();) {
+        ready.clear();
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            taskFinished.wait(lock, [&] { return finished[next]; });
+            for (; next < filenames.size() && finished[next]; ++next) {
+                ready.push_back(std::move(transcripts[next]));
+            }
+        }
+        blocks.assign(ready.begin(), ready.end());
+        output.write(blocks);
+    }
+    schedulerStats = scheduler.stats();
+    arenaStats = userManager.allocationStats();
+    for (const auto& manager : managers) {
+        arenaStats += manager.allocationStats();
     }
 }
 
-void TaskProcessor::processTasks(const std::vector<std::string>& filenames) {
-    for (const auto& filename : filenames) {
-        processTask(filename);
+namespace {
+
+/// @brief What processCachedTasks() knows of a task
+struct CachedTask {
+    std::optional<CacheKey> key;                  // Unset if the file cannot be read
+    size_t first = 0;                             // The earliest task with the same key
+    std::shared_ptr<const CachedResult> result;   // Found in the cache, or once the task has run
+    bool run = false;                             // Neither found nor a repeat
+};
+
+} // namespace
+
+void TaskProcessor::processCachedTasks(const std::vector<std::string>& filenames, size_t jobs) {
+    // Every task is looked up before any runs, so a task repeated in the
+    // list is answered by its first occurrence however the runs interleave
+    ResultCache& cache = *options.cache;
+    std::vector<CachedTask> tasks(filenames.size());
+    std::unordered_map<CacheKey, size_t, CacheKeyHash> firstOf;
+    size_t runCount = 0;
+    for (size_t i = 0; i < filenames.size(); ++i) {
+        auto& task = tasks[i];
+        task.first = i;
+        // Each mapping is dropped once hashed, so a long list never holds
+        // all its files at once; a task that runs is mapped again then
+        try {
+            task.key = ResultCache::keyOf(MappedFile(filenames[i]), cacheContext);
+        } catch (const std::runtime_error&) {
+            // Unreadable: runs without a key, to report the error as usual
+        }
+        if (task.key) {
+            auto [it, inserted] = firstOf.emplace(*task.key, i);
+            if (!inserted) {
+                task.first = it->second;
+                continue;
+            }
+            task.result = cache.find(*task.key);
+        }
+        task.run = task.result == nullptr;
+        runCount += task.run;
     }
-}
\ No newline at end of file
+
+    // A repeat of a task that threw runs again, here, as the result was not kept
+    auto answer = [&](size_t i, BufferedOutput& out) {
+        const auto& task = tasks[i];
+        const auto& known = tasks[task.first].result;
+        if (task.first == i) {
+            if (known) {
+                replayTask(filenames[i], *known, out);
+            }
+        } else if (known) {
+            cache.countRepeat();
+            replayTask(filenames[i], *known, out);
+        } else {
+            runTask(filenames[i], userManager, out);
+        }
+    };
+
+    jobs = std::min(jobs, runCount);
+    if (jobs <= 1) {
+        BufferedOutput out(output);
+        for (size_t i = 0; i < filenames.size(); ++i) {
+            auto& task = tasks[i];
+            if (task.run && !task.key) {
+                runTask(filenames[i], userManager, out);
+            } else if (task.run) {
+                task.result = runCacheableTask(filenames[i], *task.key, userManager, out, nullptr);
+                if (task.result) {
+                    cache.store(*task.key, task.result);
+                }
+            }
+            answer(i, out);
+        }
+        out.flush();
+        if (parsePool) {
+            schedulerStats = parsePool->stats();
+        }
+        arenaStats = userManager.allocationStats();
+        return;
+    }
+
+    // As in processTasks(), but only the tasks to run are scheduled, and
+    // the cache is only touched from this thread
+    std::vector<std::string> transcripts(filenames.size());
+    std::vector<bool> finished(filenames.size(), false);
+    std::vector<UserManager> managers(jobs);
+    std::mutex mutex;
+    std::condition_variable taskFinished;
+
+    WorkStealingScheduler scheduler(jobs);
+    size_t slot = 0;
+    for (size_t i = 0; i < filenames.size(); ++i) {
+        if (!tasks[i].run) {
+            continue;
+        }
+        scheduler.submitTask(slot++, [&, i] {
+            MemorySink transcript;
+            std::shared_ptr<const CachedResult> result;
+            {
+                BufferedOutput out(transcript);
+                UserManager& users = managers[scheduler.currentWorker()];
+                if (tasks[i].key) {
+                    result = runCacheableTask(filenames[i], *tasks[i].key, users, out, &scheduler);
+                } else {
+                    runTask(filenames[i], users, out, &scheduler);
+                }
+                out.flush();
+            }
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                transcripts[i] = transcript.take();
+                tasks[i].result = std::move(result);
+                finished[i] = true;
+            }
+            taskFinished.notify_one();
+        });
+    }
+
+    BufferedOutput out(output);
+    for (size_t i = 0; i < filenames.size(); ++i) {
+        auto& task = tasks[i];
+        size_t waitFor = task.run ? i : task.first;
+        if (tasks[waitFor].run) {
+            std::unique_lock<std::mutex> lock(mutex);
+            if (!finished[waitFor]) {
+                // Hand over what is ready before blocking
+                lock.unlock();
+                out.flush();
+                lock.lock();
+                taskFinished.wait(lock, [&] { return finished[waitFor]; });
+            }
+        }
+        if (task.run) {
+            out.append(transcripts[i]);
+            std::string().swap(transcripts[i]);
+            if (task.result) {
+                cache.store(*task.key, task.result);
+            }
+        }
+        answer(i, out);
+    }
+    out.flush();
+    schedulerStats = scheduler.stats();
+    arenaStats = userManager.allocationStats();
+    for (const auto& manager : managers) {
+        arenaStats += manager.allocationStats();
+    }
+}
+
+void TaskProcessor::saveSnapshot(const std::string& filename) {
+    if (options.cache) {
+        throw std::runtime_error("Tasks answered from a cache leave no user state to save");
+    }
+    if (options.sharedState) {
+        throw std::runtime_error("Shared user state is not saved to a snapshot");
+    }
+    if (options.journal == nullptr) {
+        Snapshot::save(userManager, filename, options.snapshot ? options.snapshot->generation() : 0);
+        return;
+    }
+    // Saved first: a crash before the restart leaves an older journal, which is then dropped
+    std::uint64_t generation = options.journal->generation() + 1;
+    Snapshot::save(userManager, filename, generation);
+    options.journal->restart(generation);
+}
@@ -0,0 +1,366 @@
+#include "task/scan.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include "parser/chars.hpp"
+#include "util/bits.hpp"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <immintrin.h>
+#define TASK_SCAN_X86 1
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define TASK_SCAN_NEON 1
+#endif
+
+#if defined(TASK_SCAN_X86) && (defined(__GNUC__) || defined(__clang__))
+#define TASK_SCAN_AVX2 1
+#define TASK_SCAN_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+namespace {
+
+constexpr size_t kBlock = 64;
+
+/// @brief Token masks of one block
+struct BlockTokens {
+    std::uint64_t spaces = 0;
+    std::uint64_t words = 0;
+    std::uint64_t quotes = 0;
+};
+
+/// @brief Add the masks of the block at at to tokens, which may start
+///        anywhere within a word
+inline void record(TextTokens& tokens, size_t at, const BlockTokens& block) {
+    size_t offset = at - tokens.base;
+    size_t word = offset / 64;
+    unsigned shift = offset % 64;
+    auto store = [&](std::vector<std::uint64_t>& mask, std::uint64_t bits) {
+        mask[word] |= bits << shift;
+        if (shift != 0) {
+            mask[word + 1] |= bits >> (64 - shift);
+        }
+    };
+    store(tokens.spaces, block.spaces);
+    store(tokens.words, block.words);
+    store(tokens.quotes, block.quotes);
+}
+
+/// @brief Turn the newline and `#` masks of the block at base into lines
+inline void consume(std::uint64_t newlines, std::uint64_t hashes, size_t base, LineScanner::State& state,
+                    std::vector<LineSpan>& lines) {
+    if (hashes == 0) {
+        // The common block: line ends only
+        for (; newlines != 0; newlines &= newlines - 1) {
+            size_t at = base + bits::lowest(newlines);
+            lines.push_back({state.lineStart, std::min(state.comment, at)});
+            state.lineStart = at + 1;
+            state.comment = SIZE_MAX;
+        }
+        return;
+    }
+    for (std::uint64_t events = newlines | hashes; events != 0; events &= events - 1) {
+        unsigned bit = bits::lowest(events);
+        size_t at = base + bit;
+        if (newlines & (std::uint64_t(1) << bit)) {
+            lines.push_back({state.lineStart, std::min(state.comment, at)});
+            state.lineStart = at + 1;
+            state.comment = SIZE_MAX;
+        } else if (state.comment == SIZE_MAX) {
+            state.comment = at;
+        }
+    }
+}
+
+/// @brief The byte loop, for the tail of a scan and CPUs without vectors
+void scanScalar(const char* data, size_t from, size_t to, LineScanner::State& state, std::vector<LineSpan>& lines) {
+    for (size_t i = from; i < to; ++i) {
+        if (data[i] == '\n') {
+            lines.push_back({state.lineStart, std::min(state.comment, i)});
+            state.lineStart = i + 1;
+            state.comment = SIZE_MAX;
+        } else if (data[i] == '#' && state.comment == SIZE_MAX) {
+            state.comment = i;
+        }
+    }
+}
+
+/// @brief The token masks of data[from, to) a byte at a time
+void classifyScalar(const char* data, size_t from, size_t to, TextTokens& tokens) {
+    for (size_t i = from; i < to; ++i) {
+        size_t offset = i - tokens.base;
+        std::uint64_t bit = std::uint64_t(1) << (offset % 64);
+        tokens.spaces[offset / 64] |= chars::isSpace(data[i]) ? bit : 0;
+        tokens.words[offset / 64] |= chars::isWord(data[i]) ? bit : 0;
+        tokens.quotes[offset / 64] |= data[i] == '"' ? bit : 0;
+    }
+}
+
+/// @brief Make room in tokens for the masks of text up to to
+void reserveTokens(TextTokens& tokens, size_t to) {
+    size_t words = (to - tokens.base + 63) / 64;
+    tokens.spaces.resize(words);
+    tokens.words.resize(words);
+    tokens.quotes.resize(words);
+}
+
+#if defined(TASK_SCAN_X86)
+
+/// @brief Bytes in [low, low + span], compared unsigned: min(b - low, span) == b - low
+inline __m128i inRangeSse2(__m128i bytes, char low, char span) {
+    __m128i offset = _mm_sub_epi8(bytes, _mm_set1_epi8(low));
+    return _mm_cmpeq_epi8(_mm_min_epu8(offset, _mm_set1_epi8(span)), offset);
+}
+
+/// @brief Add the token masks of the 16 bytes at k of a block
+inline void classifySse2(__m128i bytes, size_t k, BlockTokens& block) {
+    __m128i spaces = _mm_or_si128(_mm_cmpeq_epi8(bytes, _mm_set1_epi8(' ')), inRangeSse2(bytes, '\t', '\r' - '\t'));
+    __m128i letters = inRangeSse2(_mm_or_si128(bytes, _mm_set1_epi8(0x20)), 'a', 'z' - 'a');
+    __m128i words = _mm_or_si128(_mm_or_si128(letters, inRangeSse2(bytes, '0', 9)), _mm_cmpeq_epi8(bytes, _mm_set1_epi8('_')));
+    __m128i quotes = _mm_cmpeq_epi8(bytes, _mm_set1_epi8('"'));
+    block.spaces |= std::uint64_t(static_cast<std::uint16_t>(_mm_movemask_epi8(spaces))) << k;
+    block.words |= std::uint64_t(static_cast<std::uint16_t>(_mm_movemask_epi8(words))) << k;
+    block.quotes |= std::uint64_t(static_cast<std::uint16_t>(_mm_movemask_epi8(quotes))) << k;
+}
+
+// SSE2 is part of x86-64, so this kernel needs no check
+template<bool Tokenize>
+size_t scanSse2(const char* data, size_t from, size_t to, LineScanner::State& state, std::vector<LineSpan>& lines,
+                TextTokens* tokens) {
+    const __m128i newline = _mm_set1_epi8('\n');
+    const __m128i hash = _mm_set1_epi8('#');
+    size_t i = from;
+    for (; i + kBlock <= to; i += kBlock) {
+        std::uint64_t newlines = 0;
+        std::uint64_t hashes = 0;
+        BlockTokens block;
+        for (size_t k = 0; k < kBlock; k += 16) {
+            __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + k));
+            newlines |= std::uint64_t(static_cast<std::uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, newline)))) << k;
+            hashes |= std::uint64_t(static_cast<std::uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, hash)))) << k;
+            if constexpr (Tokenize) {
+                classifySse2(bytes, k, block);
+            }
+        }
+        consume(newlines, hashes, i, state, lines);
+        if constexpr (Tokenize) {
+            record(*tokens, i, block);
+        }
+    }
+    return i;
+}
+
+#endif
+
+#if defined(TASK_SCAN_AVX2)
+
+/// @brief Add the token masks of the 32 bytes at k of a block
+///
+/// The class of a byte is the AND of two table lookups, by its low and by
+/// its high nibble. Bits 0-3 stand for the ranges of word characters
+/// (0-9, A-O and a-o, P-Z and p-z, _), 4 and 5 for ' ' and \t-\r, 6 for '"';
+/// bytes from 0x80 up look up nothing.
+TASK_SCAN_TARGET_AVX2
+inline void classifyAvx2(__m256i bytes, size_t k, BlockTokens& block) {
+    const __m256i byLow = _mm256_setr_epi8(
+        0x15, 0x07, 0x47, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x27, 0x26, 0x22, 0x22, 0x22, 0x02, 0x0a,
+        0x15, 0x07, 0x47, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x27, 0x26, 0x22, 0x22, 0x22, 0x02, 0x0a);
+    const __m256i byHigh = _mm256_setr_epi8(
+        0x20, 0x00, 0x50, 0x01, 0x02, 0x0c, 0x02, 0x04, 0, 0, 0, 0, 0, 0, 0, 0,
+        0x20, 0x00, 0x50, 0x01, 0x02, 0x0c, 0x02, 0x04, 0, 0, 0, 0, 0, 0, 0, 0);
+    __m256i high = _mm256_and_si256(_mm256_srli_epi16(bytes, 4), _mm256_set1_epi8(0x0f));
+    __m256i classes = _mm256_and_si256(_mm256_shuffle_epi8(byLow, bytes), _mm256_shuffle_epi8(byHigh, high));
+    // Adding 0x7f, or 0x70, sets the top bit of a byte exactly when one of its class bits is set
+    __m256i words = _mm256_add_epi8(_mm256_and_si256(classes, _mm256_set1_epi8(0x0f)), _mm256_set1_epi8(0x7f));
+    __m256i spaces = _mm256_add_epi8(_mm256_and_si256(classes, _mm256_set1_epi8(0x30)), _mm256_set1_epi8(0x70));
+    __m256i quotes = _mm256_add_epi8(classes, classes);
+    block.spaces |= std::uint64_t(static_cast<std::uint32_t>(_mm256_movemask_epi8(spaces))) << k;
+    block.words |= std::uint64_t(static_cast<std::uint32_t>(_mm256_movemask_epi8(words))) << k;
+    block.quotes |= std::uint64_t(static_cast<std::uint32_t>(_mm256_movemask_epi8(quotes))) << k;
+}
+
+template<bool Tokenize>
+TASK_SCAN_TARGET_AVX2
+size_t scanAvx2(const char* data, size_t from, size_t to, LineScanner::State& state, std::vector<LineSpan>& lines,
+                TextTokens* tokens) {
+    const __m256i newline = _mm256_set1_epi8('\n');
+    const __m256i hash = _mm256_set1_epi8('#');
+    size_t i = from;
+    for (; i + kBlock <= to; i += kBlock) {
+        __m256i low = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        __m256i high = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i + 32));
+        std::uint64_t newlines =
+            std::uint64_t(static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(low, newline)))) |
+            std::uint64_t(static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(high, newline)))) << 32;
+        std::uint64_t hashes =
+            std::uint64_t(static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(low, hash)))) |
+            std::uint64_t(static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(high, hash)))) << 32;
+        consume(newlines, hashes, i, state, lines);
+        if constexpr (Tokenize) {
+            BlockTokens block;
+            classifyAvx2(low, 0, block);
+            classifyAvx2(high, 32, block);
+            record(*tokens, i, block);
+        }
+    }
+    return i;
+}
+
+#endif
+
+#if defined(TASK_SCAN_NEON)
+
+/// @brief One bit per byte of a comparison result, like movemask on x86
+inline std::uint16_t neonMask(uint8x16_t matches) {
+    static const std::uint8_t kWeights[16] = {1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128};
+    uint8x16_t bits = vandq_u8(matches, vld1q_u8(kWeights));
+    return static_cast<std::uint16_t>(vaddv_u8(vget_low_u8(bits)) | (vaddv_u8(vget_high_u8(bits)) << 8));
+}
+
+inline uint8x16_t inRangeNeon(uint8x16_t bytes, std::uint8_t low, std::uint8_t span) {
+    return vcleq_u8(vsubq_u8(bytes, vdupq_n_u8(low)), vdupq_n_u8(span));
+}
+
+inline void classifyNeon(uint8x16_t bytes, size_t k, BlockTokens& block) {
+    uint8x16_t spaces = vorrq_u8(vceqq_u8(bytes, vdupq_n_u8(' ')), inRangeNeon(bytes, '\t', '\r' - '\t'));
+    uint8x16_t letters = inRangeNeon(vorrq_u8(bytes, vdupq_n_u8(0x20)), 'a', 'z' - 'a');
+    uint8x16_t words = vorrq_u8(vorrq_u8(letters, inRangeNeon(bytes, '0', 9)), vceqq_u8(bytes, vdupq_n_u8('_')));
+    block.spaces |= std::uint64_t(neonMask(spaces)) << k;
+    block.words |= std::uint64_t(neonMask(words)) << k;
+    block.quotes |= std::uint64_t(neonMask(vceqq_u8(bytes, vdupq_n_u8('"')))) << k;
+}
+
+// NEON is part of AArch64, so this kernel needs no check
+template<bool Tokenize>
+size_t scanNeon(const char* data, size_t from, size_t to, LineScanner::State& state, std::vector<LineSpan>& lines,
+                TextTokens* tokens) {
+    const uint8x16_t newline = vdupq_n_u8('\n');
+    const uint8x16_t hash = vdupq_n_u8('#');
+    size_t i = from;
+    for (; i + kBlock <= to; i += kBlock) {
+        std::uint64_t newlines = 0;
+        std::uint64_t hashes = 0;
+        BlockTokens block;
+        for (size_t k = 0; k < kBlock; k += 16) {
+            uint8x16_t bytes = vld1q_u8(reinterpret_cast<const std::uint8_t*>(data + i + k));
+            newlines |= std::uint64_t(neonMask(vceqq_u8(bytes, newline))) << k;
+            hashes |= std::uint64_t(neonMask(vceqq_u8(bytes, hash))) << k;
+            if constexpr (Tokenize) {
+                classifyNeon(bytes, k, block);
+            }
+        }
+        consume(newlines, hashes, i, state, lines);
+        if constexpr (Tokenize) {
+            record(*tokens, i, block);
+        }
+    }
+    return i;
+}
+
+#endif
+
+} // namespace
+
+ScanKernel LineScanner::bestKernel() {
+    static const ScanKernel best = [] {
+        if (supported(ScanKernel::Avx2)) {
+            return ScanKernel::Avx2;
+        }
+        if (supported(ScanKernel::Sse2)) {
+            return ScanKernel::Sse2;
+        }
+        if (supported(ScanKernel::Neon)) {
+            return ScanKernel::Neon;
+        }
+        return ScanKernel::Scalar;
+    }();
+    return best;
+}
+
+bool LineScanner::supported(ScanKernel kernel) {
+    switch (kernel) {
+    case ScanKernel::Scalar:
+        return true;
+    case ScanKernel::Sse2:
+#if defined(TASK_SCAN_X86)
+        return true;
+#else
+        return false;
+#endif
+    case ScanKernel::Avx2:
+#if defined(TASK_SCAN_AVX2)
+        return __builtin_cpu_supports("avx2");
+#else
+        return false;
+#endif
+    case ScanKernel::Neon:
+#if defined(TASK_SCAN_NEON)
+        return true;
+#else
+        return false;
+#endif
+    }
+    return false;
+}
+
+const char* LineScanner::name(ScanKernel kernel) {
+    switch (kernel) {
+    case ScanKernel::Scalar:
+        return "scalar";
+    case ScanKernel::Sse2:
+        return "sse2";
+    case ScanKernel::Avx2:
+        return "avx2";
+    case ScanKernel::Neon:
+        return "neon";
+    }
+    return "unknown";
+}
+
+void LineScanner::scan(std::string_view text, size_t from, size_t to, std::vector<LineSpan>& lines,
+                       TextTokens* tokens) {
+    const char* data = text.data();
+    if (tokens) {
+        reserveTokens(*tokens, to);
+    }
+    size_t done = from;
+    switch (kernel) {
+#if defined(TASK_SCAN_X86)
+    case ScanKernel::Sse2:
+        done = tokens ? scanSse2<true>(data, from, to, state, lines, tokens)
+                      : scanSse2<false>(data, from, to, state, lines, tokens);
+        break;
+#endif
+#if defined(TASK_SCAN_AVX2)
+    case ScanKernel::Avx2:
+        done = tokens ? scanAvx2<true>(data, from, to, state, lines, tokens)
+                      : scanAvx2<false>(data, from, to, state, lines, tokens);
+        break;
+#endif
+#if defined(TASK_SCAN_NEON)
+    case ScanKernel::Neon:
+        done = tokens ? scanNeon<true>(data, from, to, state, lines, tokens)
+                      : scanNeon<false>(data, from, to, state, lines, tokens);
+        break;
+#endif
+    default:
+        break;
+    }
+    // Less than a block left (or no vector kernel)
+    scanScalar(data, done, to, state, lines);
+    if (tokens) {
+        classifyScalar(data, done, to, *tokens);
+    }
+}
+
+void LineScanner::classify(std::string_view text, size_t from, size_t to, TextTokens& tokens) {
+    reserveTokens(tokens, to);
+    classifyScalar(text.data(), from, to, tokens);
+}
+
+void LineScanner::finish(size_t size, std::vector<LineSpan>& lines) {
+    if (state.lineStart < size) {
+        lines.push_back({state.lineStart, std::min(state.comment, size)});
+    }
+    state = State{};
+}
@@ -0,0 +1,140 @@
+#include "task/scheduler.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+
+// Worker index of the current thread, or npos outside the scheduler
+thread_local size_t currentWorkerIndex = static_cast<size_t>(-1);
+thread_local const void* currentScheduler = nullptr;
+
+} // namespace
+
+WorkStealingScheduler::WorkStealingScheduler(size_t workerCount) {
+    workerCount = std::max<size_t>(1, workerCount);
+    workers.reserve(workerCount);
+    for (size_t i = 0; i < workerCount; ++i) {
+        workers.push_back(std::make_unique<Worker>());
+    }
+    threads.reserve(workerCount);
+    for (size_t i = 0; i < workerCount; ++i) {
+        threads.emplace_back(&WorkStealingScheduler::workerLoop, this, i);
+    }
+}
+
+WorkStealingScheduler::~WorkStealingScheduler() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+void WorkStealingScheduler::push(Worker& worker, std::deque<Job> Worker::*queue, Job job) {
+    {
+        // Counted before it becomes visible, so a pop never precedes its increment;
+        // taking the lock orders the increment with a worker about to sleep
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        ++queued;
+    }
+    {
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        (worker.*queue).push_back(std::move(job));
+    }
+    wake.notify_one();
+}
+
+void WorkStealingScheduler::submitTask(size_t worker, Job job) {
+    push(*workers[worker % workers.size()], &Worker::tasks, std::move(job));
+}
+
+void WorkStealingScheduler::submitChunk(Job job) {
+    push(*workers[currentWorker()], &Worker::chunks, std::move(job));
+}
+
+size_t WorkStealingScheduler::currentWorker() const {
+    if (currentScheduler != this) {
+        throw std::logic_error("Not running on this scheduler");
+    }
+    return currentWorkerIndex;
+}
+
+bool WorkStealingScheduler::popOwn(size_t self, std::deque<Job> Worker::*queue, Job& job) {
+    Worker& worker = *workers[self];
+    std::lock_guard<std::mutex> lock(worker.mutex);
+    auto& jobs = worker.*queue;
+    if (jobs.empty()) {
+        return false;
+    }
+    job = std::move(jobs.back());
+    jobs.pop_back();
+    return true;
+}
+
+bool WorkStealingScheduler::steal(size_t self, std::deque<Job> Worker::*queue, Job& job) {
+    for (size_t offset = 1; offset < workers.size(); ++offset) {
+        Worker& victim = *workers[(self + offset) % workers.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        auto& jobs = victim.*queue;
+        if (!jobs.empty()) {
+            job = std::move(jobs.front());
+            jobs.pop_front();
+            workers[self]->steals.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool WorkStealingScheduler::runOne(size_t self, bool chunksOnly) {
+    Job job;
+    bool isChunk = popOwn(self, &Worker::chunks, job) || steal(self, &Worker::chunks, job);
+    if (!isChunk && (chunksOnly || !(popOwn(self, &Worker::tasks, job) || steal(self, &Worker::tasks, job)))) {
+        return false;
+    }
+    --queued;
+    job();
+    auto& counter = isChunk ? workers[self]->chunksRun : workers[self]->tasksRun;
+    counter.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void WorkStealingScheduler::helpWithChunks(const std::function<bool()>& done) {
+    size_t self = currentWorker();
+    while (!done()) {
+        if (!runOne(self, true)) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void WorkStealingScheduler::workerLoop(size_t self) {
+    currentWorkerIndex = self;
+    currentScheduler = this;
+    for (;;) {
+        if (runOne(self, false)) {
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        if (queued == 0 && stopping) {
+            return;
+        }
+        wake.wait(lock, [&] { return queued > 0 || stopping; });
+        if (queued == 0 && stopping) {
+            return;
+        }
+    }
+}
+
+std::vector<WorkerStats> WorkStealingScheduler::stats() const {
+    std::vector<WorkerStats> result;
+    result.reserve(workers.size());
+    for (const auto& worker : workers) {
+        result.push_back({worker->tasksRun.load(), worker->chunksRun.load(), worker->steals.load()});
+    }
+    return result;
+}
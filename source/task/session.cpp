@@ -0,0 +1,163 @@
+#include "task/session.hpp"
+#include <stdexcept>
+#include <utility>
+#include <fmt/format.h>
+#include "profile/profiler.hpp"
+#include "task/source.hpp"
+
+TaskSession::TaskSession(const TaskProcessor& processor, std::string name, UserManager& users,
+                         BufferedOutput& out)
+    : processor(processor), name(std::move(name)), users(users), out(out) {
+    processor.startState(users);
+    processor.beginTask(this->name, out);
+}
+
+std::uint64_t TaskSession::stopAt(size_t room) const {
+    std::uint64_t written = out.written();
+    return room < UINT64_MAX - written ? written + room : UINT64_MAX;
+}
+
+size_t TaskSession::runLines(std::string_view text, std::uint64_t limit) {
+    size_t used = 0;
+    while (!ended && out.written() < limit) {
+        size_t lineEnd = text.find('\n', used);
+        if (lineEnd == std::string_view::npos) {
+            break;
+        }
+        bool complete = runLine(text.substr(used, lineEnd - used), limit);
+        used = lineEnd + 1;
+        if (!complete) {
+            break;
+        }
+    }
+    return used;
+}
+
+bool TaskSession::runLine(std::string_view text, std::uint64_t limit) {
+    text = taskLineCommand(text);
+    if (text.empty()) {
+        return true;
+    }
+    try {
+        auto cmdOpt = TaskProcessor::parseCommand(text);
+        // An invalid line's transcript is no longer than the line
+        if (!cmdOpt || processor.options.quiet) {
+            settle(processor.executeLine(text, cmdOpt, users, out));
+            return true;
+        }
+        result = processor.executeCommand(*cmdOpt, users);
+        outcome = processor.lineOutcome(*cmdOpt, result);
+        cursor = {};
+        if (continueRender(limit)) {
+            return true;
+        }
+        line.assign(text);
+        command = TaskProcessor::parseCommand(line);
+        result.command = &*command;
+        rendering = true;
+        return false;
+    } catch (const std::exception& e) {
+        processor.abortTask(name, e, out);
+        ended = true;
+        return true;
+    }
+}
+
+bool TaskSession::continueRender(std::uint64_t limit) {
+    {
+        WZH_PROFILE_PHASE(Phase::Render);
+        std::uint64_t written = out.written();
+        if (!renderSome(result, out, cursor, written < limit ? limit - written : 0)) {
+            return false;
+        }
+    }
+    if (rendering) {
+        rendering = false;
+        command.reset();
+    }
+    settle(outcome);
+    return true;
+}
+
+void TaskSession::hold(std::string_view bytes) {
+    if (overlong) {
+        return;
+    }
+    size_t lastNewline = bytes.rfind('\n');
+    size_t lineBytes = lastNewline == std::string_view::npos ? tail + bytes.size() : bytes.size() - lastNewline - 1;
+    if (lineBytes > kMaxLineBytes) {
+        // Only the lines before it are kept; the task fails on reaching it
+        if (lastNewline != std::string_view::npos) {
+            input.append(bytes.substr(0, lastNewline + 1));
+            tail = 0;
+        }
+        overlong = true;
+        return;
+    }
+    input.append(bytes);
+    tail = lineBytes;
+}
+
+void TaskSession::advance(std::uint64_t limit) {
+    if (ended || (rendering && !continueRender(limit))) {
+        return;
+    }
+    input.erase(0, runLines(input, limit));
+    if (ended || blocked()) {
+        return;
+    }
+    // Only the start of a line is left
+    if (overlong) {
+        processor.abortTask(name, std::length_error(fmt::format("Line longer than {} bytes", kMaxLineBytes)), out);
+        ended = true;
+    } else if (closing) {
+        if (!input.empty()) {
+            runLine(input, limit);
+            input.clear();
+            tail = 0;
+        }
+        if (!ended && !rendering) {
+            end(true);
+        }
+    }
+}
+
+void TaskSession::settle(TaskProcessor::LineOutcome lineOutcome) {
+    if (lineOutcome != TaskProcessor::LineOutcome::Continue) {
+        end(lineOutcome == TaskProcessor::LineOutcome::Exit);
+    }
+}
+
+void TaskSession::end(bool completed) {
+    processor.endTask(name, completed, out);
+    ended = true;
+}
+
+bool TaskSession::feed(std::string_view bytes, size_t room) {
+    if (ended) {
+        return false;
+    }
+    std::uint64_t limit = stopAt(room);
+    if (input.empty() && !rendering) {
+        // Lines that arrive whole are run in place, without a copy
+        bytes.remove_prefix(runLines(bytes, limit));
+    }
+    if (!ended) {
+        hold(bytes);
+        advance(limit);
+    }
+    return !ended;
+}
+
+bool TaskSession::resume(size_t room) {
+    advance(stopAt(room));
+    return !ended;
+}
+
+void TaskSession::finish(size_t room) {
+    if (ended) {
+        return;
+    }
+    closing = true;
+    advance(stopAt(room));
+}
@@ -0,0 +1,219 @@
+#include "task/snapshot.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <limits>
+#include <stdexcept>
+#include <string_view>
+#include <system_error>
+#include <unordered_set>
+#include <vector>
+#include <fmt/format.h>
+#include "output/sink.hpp"
+#include "task/codec.hpp"
+
+namespace {
+
+constexpr char kMagic[4] = {'W', 'Z', 'H', 'S'};
+
+std::runtime_error corrupt(const char* what) {
+    return std::runtime_error(fmt::format("Corrupt snapshot: {}", what));
+}
+
+void putString(std::string& out, std::string_view text) {
+    if (text.size() > std::numeric_limits<std::uint32_t>::max()) {
+        throw std::runtime_error("Snapshot string exceeds 4 GiB");
+    }
+    putVarint(out, static_cast<std::uint32_t>(text.size()));
+    out.append(text);
+}
+
+void putCount(std::string& out, size_t count) {
+    if (count > std::numeric_limits<std::uint32_t>::max()) {
+        throw std::runtime_error("Snapshot list has more than 2^32 entries");
+    }
+    putVarint(out, static_cast<std::uint32_t>(count));
+}
+
+} // namespace
+
+void Snapshot::save(const UserManager& manager, const std::string& filename, std::uint64_t generation) {
+    const auto& state = *manager.state;
+    const UserStore& store = state.users;
+    std::string body;
+
+    // Groups with members, numbered in GroupId order so that the users'
+    // sorted group lists stay sorted by index
+    std::vector<std::uint32_t> groupIndex(state.groupMembers.size(), 0);
+    size_t groupCount = 0;
+    for (GroupId group = 0; group < state.groupMembers.size(); ++group) {
+        if (state.groupMembers[group] > 0) {
+            groupIndex[group] = static_cast<std::uint32_t>(groupCount++);
+            putString(body, state.groupNames.name(group));
+        }
+    }
+
+    std::uint64_t nameBytes = 0;
+    for (UserId id = 0; id < store.slotCount(); ++id) {
+        if (!store.live(id)) {
+            continue;
+        }
+        std::string_view name = store.name(id);
+        putString(body, name);
+        nameBytes += name.size();
+        body.push_back(store.enabled(id) ? 1 : 0);
+
+        const auto& groups = store.groups(id);
+        putCount(body, groups.size());
+        for (GroupId group : groups) {
+            putVarint(body, groupIndex[group]);
+        }
+        const auto& messages = store.messages(id);
+        putCount(body, messages.size());
+        for (std::string_view message : messages) {
+            putString(body, message);
+        }
+    }
+
+    std::string header(kMagic, sizeof(kMagic));
+    putLe(header, kVersion, 4);
+    putLe(header, checksum(body), 8);
+    putLe(header, store.size(), 4);
+    putLe(header, groupCount, 4);
+    putLe(header, generation, 8);
+    putLe(header, nameBytes, 8);
+
+    // A crash while writing leaves the previous snapshot in place
+    std::string temporary = filename + ".tmp";
+    {
+        FileSink out(temporary);
+        out.write(std::vector<std::string_view>{header, body});
+        out.sync();
+    }
+    std::error_code error;
+    std::filesystem::rename(temporary, filename, error);
+    if (error) {
+        throw std::runtime_error(fmt::format("Cannot replace {}: {}", filename, error.message()));
+    }
+}
+
+Snapshot::Snapshot(const std::string& filename) : file(filename) {
+    std::string_view data = file.view();
+    if (data.size() < kHeaderBytes || data.substr(0, sizeof(kMagic)) != std::string_view(kMagic, sizeof(kMagic))) {
+        throw corrupt("missing header");
+    }
+    std::uint32_t version = static_cast<std::uint32_t>(getLe(data.data() + 4, 4));
+    if (version != kVersion) {
+        throw std::runtime_error(fmt::format("Snapshot has format version {}, expected {}", version, kVersion));
+    }
+    bodyChecksum = getLe(data.data() + 8, 8);
+    if (bodyChecksum != checksum(data.substr(kHeaderBytes))) {
+        throw corrupt("checksum mismatch");
+    }
+    users = static_cast<size_t>(getLe(data.data() + 16, 4));
+    groups = static_cast<size_t>(getLe(data.data() + 20, 4));
+    snapshotGeneration = getLe(data.data() + 24, 8);
+    nameBytes = static_cast<size_t>(getLe(data.data() + 32, 8));
+    // Each entry takes a byte at least; this bounds what restore() reserves
+    if (users > data.size() || groups > data.size() || nameBytes > data.size()) {
+        throw corrupt("counts out of range");
+    }
+    validate();
+}
+
+void Snapshot::validate() const {
+    size_t position = kHeaderBytes;
+    ByteReader reader(file.view(), position, "snapshot");
+    std::unordered_set<std::string_view> seen;
+
+    seen.reserve(groups);
+    for (size_t i = 0; i < groups; ++i) {
+        if (!seen.insert(reader.bytes(reader.varint())).second) {
+            reader.fail("duplicate group");
+        }
+    }
+
+    seen.clear();
+    seen.reserve(users);
+    size_t userNameBytes = 0;
+    for (size_t i = 0; i < users; ++i) {
+        std::string_view name = reader.bytes(reader.varint());
+        if (!seen.insert(name).second) {
+            reader.fail("duplicate user");
+        }
+        userNameBytes += name.size();
+        reader.byte();
+
+        std::uint32_t groupCount = reader.varint();
+        if (groupCount > groups) {
+            reader.fail("group count out of range");
+        }
+        for (std::uint32_t k = 0, previous = 0; k < groupCount; ++k) {
+            std::uint32_t group = reader.varint();
+            if (group >= groups || (k > 0 && group <= previous)) {
+                reader.fail("group index out of order");
+            }
+            previous = group;
+        }
+
+        std::uint32_t messageCount = reader.varint();
+        if (messageCount > reader.remaining()) {
+            reader.fail("message count out of range");
+        }
+        for (std::uint32_t k = 0; k < messageCount; ++k) {
+            reader.bytes(reader.varint());
+        }
+    }
+    if (reader.remaining() != 0) {
+        reader.fail("trailing bytes");
+    }
+    if (userNameBytes != nameBytes) {
+        reader.fail("name bytes mismatch");
+    }
+}
+
+void Snapshot::restore(UserManager& manager) const {
+    manager.reset();
+    auto& state = *manager.state;
+    UserStore& store = state.users;
+    size_t position = kHeaderBytes;
+    ByteReader reader(file.view(), position, "snapshot");
+
+    // The body was validated on opening: the groups and users are distinct,
+    // so a fresh state numbers the groups 0, 1, 2, ... as they are interned
+    for (size_t i = 0; i < groups; ++i) {
+        manager.groupIdFor(reader.bytes(reader.varint()));
+    }
+
+    store.reserve(users, nameBytes);
+    for (size_t i = 0; i < users; ++i) {
+        UserId id = store.insert(reader.bytes(reader.varint())).first;
+        if (reader.byte() == 0) {
+            store.disable(id);
+        }
+
+        std::uint32_t groupCount = reader.varint();
+        auto& userGroups = store.groups(id);
+        userGroups.reserve(groupCount);
+        for (std::uint32_t k = 0; k < groupCount; ++k) {
+            std::uint32_t group = reader.varint();
+            userGroups.push_back(group);
+            ++state.groupMembers[group];
+        }
+
+        std::uint32_t messageCount = reader.varint();
+        auto& messages = store.messages(id);
+        messages.reserve(messageCount);
+        for (std::uint32_t k = 0; k < messageCount; ++k) {
+            messages.push_back(state.messages.append(reader.bytes(reader.varint())));
+        }
+    }
+
+    state.sortedGroups.reserve(groups);
+    for (GroupId group = 0; group < groups; ++group) {
+        if (state.groupMembers[group] > 0) {
+            state.sortedGroups.push_back(state.groupNames.name(group));
+        }
+    }
+    std::sort(state.sortedGroups.begin(), state.sortedGroups.end());
+}
@@ -0,0 +1,87 @@
+#include "task/source.hpp"
+
+#include <algorithm>
+#include <utility>
+
+#include "profile/profiler.hpp"
+
+namespace {
+
+/// @brief Trim whitespace (including \r for cross-platform compatibility)
+std::string_view trim(std::string_view line) {
+    size_t first = line.find_first_not_of(" \t\r\n");
+    if (first == std::string_view::npos) {
+        return {};
+    }
+    return line.substr(first, line.find_last_not_of(" \t\r\n") - first + 1);
+}
+
+} // namespace
+
+std::string_view taskLineCommand(std::string_view line) {
+    // Remove comments
+    return trim(line.substr(0, line.find('#')));
+}
+
+TaskSource::TaskSource(const std::string& filename) : file(filename) {}
+
+TaskSource::TaskSource(MappedFile file) : file(std::move(file)) {}
+
+void TaskSource::releaseConsumed(size_t upTo) {
+    if (upTo - released >= kReleaseWindow) {
+        released = file.release(released, upTo);
+    }
+}
+
+bool TaskSource::scanMore() {
+    size_t size = file.size();
+    if (scanned == size) {
+        return false;
+    }
+    lines.clear();
+    nextLine = 0;
+    tokens.restart(scanned);
+    std::string_view text(file.data(), size);
+    // A piece may end mid-line; the scanner carries it into the next one
+    while (lines.empty() && scanned < size) {
+        size_t to = std::min(size, scanned + kScanBytes);
+        scanner.scan(text, scanned, to, lines, tokenize ? &tokens : nullptr);
+        scanned = to;
+    }
+    if (scanned == size) {
+        scanner.finish(size, lines);
+    }
+    return !lines.empty();
+}
+
+std::optional<std::string_view> TaskSource::next() {
+    WZH_PROFILE_PHASE(Phase::Read);
+    const char* data = file.data();
+    while (nextLine < lines.size() || scanMore()) {
+        LineSpan span = lines[nextLine++];
+        // Everything before the line about to be returned has been consumed
+        releaseConsumed(span.start);
+        std::string_view line = trim(std::string_view(data + span.start, span.end - span.start));
+        if (!line.empty()) {
+            return line;
+        }
+    }
+    return std::nullopt;
+}
+
+std::optional<grammar::Line> TaskSource::nextTokenized() {
+    tokenize = true;
+    auto line = next();
+    if (!line) {
+        return std::nullopt;
+    }
+    size_t start = static_cast<size_t>(line->data() - file.data());
+    const TextTokens* masks = &tokens;
+    if (start < tokens.base || start + line->size() > tokens.base + 64 * tokens.spaces.size()) {
+        // Begun in an earlier piece, or scanned before the first call
+        lineTokens.restart(start);
+        LineScanner::classify(std::string_view(file.data(), file.size()), start, start + line->size(), lineTokens);
+        masks = &lineTokens;
+    }
+    return grammar::Line(*line, masks->spaces.data(), masks->words.data(), masks->quotes.data(), start - masks->base);
+}
@@ -0,0 +1,53 @@
+#include "user/arena.hpp"
+
+#include <algorithm>
+
+namespace {
+
+// Buffer of the first task; also the rounding of later sizes
+constexpr size_t kInitialBuffer = size_t(64) << 10;
+
+} // namespace
+
+TaskArena::TaskArena() {
+    rebuild();
+}
+
+void TaskArena::rebuild() {
+    pool.reset();
+    monotonic.reset();
+
+    // Bytes the monotonic resource needed beyond its buffer during the last task
+    std::uint64_t overflow = system.bytes() - systemBytesAtReset;
+    if (!buffer || overflow > 0) {
+        size_t wanted = bufferSize + static_cast<size_t>(overflow);
+        bufferSize = std::max(kInitialBuffer, (wanted + kInitialBuffer - 1) / kInitialBuffer * kInitialBuffer);
+        buffer.reset();
+        buffer.reset(new std::byte[bufferSize]);
+        ++bufferAllocations;
+        bufferBytes += bufferSize;
+    }
+    systemBytesAtReset = system.bytes();
+
+    monotonic.emplace(buffer.get(), bufferSize, &system);
+    pool.emplace(&*monotonic);
+    if (front) {
+        requestsBeforeReset += front->allocations();
+    }
+    front.emplace(&*pool);
+}
+
+void TaskArena::reset() {
+    ++resetCount;
+    rebuild();
+}
+
+AllocationStats TaskArena::stats() const {
+    AllocationStats result;
+    result.requests = requestsBeforeReset + front->allocations();
+    result.systemAllocations = system.allocations() + bufferAllocations;
+    result.systemBytes = system.bytes() + bufferBytes;
+    result.resets = resetCount;
+    result.bufferBytes = bufferSize;
+    return result;
+}
@@ -0,0 +1,279 @@
+#include "user/concurrent.hpp"
+#include <algorithm>
+#include <functional>
+#include <mutex>
+#include <shared_mutex>
+#include <utility>
+
+#include "user/manager.hpp"
+#include "util/bits.hpp"
+
+struct alignas(64) ConcurrentUserManager::Shard {
+    mutable std::shared_mutex mutex;
+    mutable std::mutex listing;   // getUsers() updates the shard's listing cache, even for readers
+    UserManager users;
+};
+
+namespace {
+
+// Call f(shard index) for every bit of mask, lowest first
+template<typename F>
+void forEachShard(std::uint64_t mask, F&& f) {
+    for (; mask != 0; mask &= mask - 1) {
+        f(static_cast<size_t>(bits::lowest(mask)));
+    }
+}
+
+/// @brief Holds the locks of a set of shards, taken in ascending order so
+///        that two multi-shard operations can never deadlock
+template<typename Shard, bool Exclusive>
+class ShardLocks {
+private:
+    Shard* shards;
+    std::uint64_t mask;
+
+public:
+    ShardLocks(Shard* shards, std::uint64_t mask) : shards(shards), mask(mask) {
+        forEachShard(mask, [this](size_t i) {
+            if constexpr (Exclusive) {
+                this->shards[i].mutex.lock();
+            } else {
+                this->shards[i].mutex.lock_shared();
+            }
+        });
+    }
+
+    ~ShardLocks() {
+        forEachShard(mask, [this](size_t i) {
+            if constexpr (Exclusive) {
+                shards[i].mutex.unlock();
+            } else {
+                shards[i].mutex.unlock_shared();
+            }
+        });
+    }
+
+    ShardLocks(const ShardLocks&) = delete;
+    ShardLocks& operator=(const ShardLocks&) = delete;
+};
+
+/// @brief Merge of sorted runs of names, one per shard
+///
+/// Adjacent runs are merged pairwise into a second buffer until one is
+/// left, comparing each name once per level (six for 64 shards). Shards
+/// hold different users, so a user name is in one run only; a group with
+/// members in several shards is in each of their runs. The views are valid
+/// while the shard locks are held.
+std::vector<std::string_view> mergeRuns(const std::vector<ViewRange>& runs) {
+    std::vector<std::string_view> names;
+    std::vector<size_t> bounds{0};   // Run i is names[bounds[i], bounds[i + 1])
+    for (const auto& run : runs) {
+        if (!run.empty()) {
+            names.insert(names.end(), run.begin(), run.end());
+            bounds.push_back(names.size());
+        }
+    }
+    std::vector<std::string_view> merged(names.size());
+    std::vector<size_t> mergedBounds;
+    while (bounds.size() > 2) {
+        mergedBounds.assign(1, 0);
+        for (size_t i = 0; i + 1 < bounds.size(); i += 2) {
+            size_t last = std::min(i + 2, bounds.size() - 1);
+            std::merge(names.begin() + bounds[i], names.begin() + bounds[i + 1], names.begin() + bounds[i + 1],
+                       names.begin() + bounds[last], merged.begin() + bounds[i]);
+            mergedBounds.push_back(bounds[last]);
+        }
+        names.swap(merged);
+        bounds.swap(mergedBounds);
+    }
+    return names;
+}
+
+} // namespace
+
+ConcurrentUserManager::ConcurrentUserManager(size_t shards) {
+    size_t count = 1;
+    while (count < std::min(shards, kMaxShards)) {
+        count *= 2;
+    }
+    this->shards = std::make_unique<Shard[]>(count);
+    shardMask = count - 1;
+}
+
+ConcurrentUserManager::~ConcurrentUserManager() = default;
+
+size_t ConcurrentUserManager::shardOf(std::string_view username) const {
+    // Fibonacci hashing spreads the high bits of the string hash over the shards
+    auto hash = static_cast<std::uint64_t>(std::hash<std::string_view>{}(username));
+    return static_cast<size_t>((hash * 0x9E3779B97F4A7C15ull) >> 58) & shardMask;
+}
+
+std::uint64_t ConcurrentUserManager::shardsOf(const std::string_view* names, size_t count) const {
+    std::uint64_t mask = 0;
+    for (size_t i = 0; i < count; ++i) {
+        mask |= std::uint64_t(1) << shardOf(names[i]);
+    }
+    return mask;
+}
+
+std::vector<std::vector<std::string_view>> ConcurrentUserManager::byShard(const std::string_view* names,
+                                                                        size_t count) const {
+    std::vector<std::vector<std::string_view>> parts(shardCount());
+    for (size_t i = 0; i < count; ++i) {
+        parts[shardOf(names[i])].push_back(names[i]);
+    }
+    return parts;
+}
+
+std::uint64_t ConcurrentUserManager::allShards() const {
+    return shardMask == kMaxShards - 1 ? ~std::uint64_t(0) : (std::uint64_t(1) << (shardMask + 1)) - 1;
+}
+
+void ConcurrentUserManager::reset() {
+    ShardLocks<Shard, true> locks(shards.get(), allShards());
+    for (size_t i = 0; i < shardCount(); ++i) {
+        shards[i].users.reset();
+    }
+}
+
+bool ConcurrentUserManager::createUser(std::string_view username) {
+    Shard& shard = shards[shardOf(username)];
+    std::unique_lock<std::shared_mutex> lock(shard.mutex);
+    return shard.users.createUser(username);
+}
+
+bool ConcurrentUserManager::createUsers(const std::string_view* usernames, size_t count) {
+    auto parts = byShard(usernames, count);
+    std::uint64_t mask = shardsOf(usernames, count);
+    ShardLocks<Shard, true> locks(shards.get(), mask);
+
+    // Each shard creates its part or nothing; a later refusal undoes the
+    // shards before it, all before any other thread can look
+    std::uint64_t created = 0;
+    bool failed = false;
+    forEachShard(mask, [&](size_t i) {
+        if (failed) {
+            return;
+        }
+        if (shards[i].users.createUsers(parts[i].data(), parts[i].size())) {
+            created |= std::uint64_t(1) << i;
+        } else {
+            failed = true;
+        }
+    });
+    if (failed) {
+        forEachShard(created, [&](size_t i) {
+            for (auto name : parts[i]) {
+                shards[i].users.deleteUser(name);
+            }
+        });
+    }
+    return !failed;
+}
+
+bool ConcurrentUserManager::deleteUser(std::string_view username) {
+    Shard& shard = shards[shardOf(username)];
+    std::unique_lock<std::shared_mutex> lock(shard.mutex);
+    return shard.users.deleteUser(username);
+}
+
+bool ConcurrentUserManager::disableUser(std::string_view username) {
+    Shard& shard = shards[shardOf(username)];
+    std::unique_lock<std::shared_mutex> lock(shard.mutex);
+    return shard.users.disableUser(username);
+}
+
+bool ConcurrentUserManager::userExists(std::string_view username) const {
+    const Shard& shard = shards[shardOf(username)];
+    std::shared_lock<std::shared_mutex> lock(shard.mutex);
+    return shard.users.userExists(username);
+}
+
+std::uint64_t ConcurrentUserManager::usersExist(const std::string_view* names, size_t count) const {
+    ShardLocks<const Shard, false> locks(shards.get(), shardsOf(names, count));
+    std::uint64_t found = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (shards[shardOf(names[i])].users.userExists(names[i])) {
+            found |= std::uint64_t(1) << i;
+        }
+    }
+    return found;
+}
+
+bool ConcurrentUserManager::isUserEnabled(std::string_view username) const {
+    const Shard& shard = shards[shardOf(username)];
+    std::shared_lock<std::shared_mutex> lock(shard.mutex);
+    return shard.users.isUserEnabled(username);
+}
+
+bool ConcurrentUserManager::sendMessage(std::string_view username, std::string_view message) {
+    Shard& shard = shards[shardOf(username)];
+    std::unique_lock<std::shared_mutex> lock(shard.mutex);
+    return shard.users.sendMessage(username, message);
+}
+
+bool ConcurrentUserManager::addUserToGroup(std::string_view username, std::string_view group) {
+    Shard& shard = shards[shardOf(username)];
+    std::unique_lock<std::shared_mutex> lock(shard.mutex);
+    return shard.users.addUserToGroup(username, group);
+}
+
+bool ConcurrentUserManager::addUsersToGroup(const std::string_view* usernames, size_t count,
+                                            std::string_view group) {
+    auto parts = byShard(usernames, count);
+    std::uint64_t mask = shardsOf(usernames, count);
+    ShardLocks<Shard, true> locks(shards.get(), mask);
+
+    // Every user is checked before any joins, so no shard is left to undo
+    for (size_t i = 0; i < count; ++i) {
+        if (!shards[shardOf(usernames[i])].users.userExists(usernames[i])) {
+            return false;
+        }
+    }
+    forEachShard(mask, [&](size_t i) { shards[i].users.addUsersToGroup(parts[i].data(), parts[i].size(), group); });
+    return true;
+}
+
+bool ConcurrentUserManager::removeUserFromGroup(std::string_view username, std::string_view group) {
+    Shard& shard = shards[shardOf(username)];
+    std::unique_lock<std::shared_mutex> lock(shard.mutex);
+    return shard.users.removeUserFromGroup(username, group);
+}
+
+std::vector<std::string> ConcurrentUserManager::getUsers(std::string_view prefix) const {
+    ShardLocks<const Shard, false> locks(shards.get(), allShards());
+    std::vector<ViewRange> runs;
+    runs.reserve(shardCount());
+    for (size_t i = 0; i < shardCount(); ++i) {
+        // Views stay valid after the listing lock is dropped: only writers,
+        // kept out by the shared lock, can make the listing stale again
+        std::lock_guard<std::mutex> listing(shards[i].listing);
+        runs.push_back(shards[i].users.getUsers(prefix));
+    }
+    auto names = mergeRuns(runs);
+    return std::vector<std::string>(names.begin(), names.end());
+}
+
+std::vector<std::string> ConcurrentUserManager::getGroups() const {
+    ShardLocks<const Shard, false> locks(shards.get(), allShards());
+    std::vector<ViewRange> runs;
+    runs.reserve(shardCount());
+    for (size_t i = 0; i < shardCount(); ++i) {
+        runs.push_back(shards[i].users.getGroups());
+    }
+    auto names = mergeRuns(runs);
+    names.erase(std::unique(names.begin(), names.end()), names.end());
+    return std::vector<std::string>(names.begin(), names.end());
+}
+
+std::optional<std::vector<std::string>> ConcurrentUserManager::getMessageHistory(std::string_view username, size_t from,
+                                                                                 size_t limit) const {
+    const Shard& shard = shards[shardOf(username)];
+    std::shared_lock<std::shared_mutex> lock(shard.mutex);
+    auto id = shard.users.findUser(username);
+    if (!id) {
+        return std::nullopt;
+    }
+    auto page = shard.users.getMessageHistory(*id, from, limit);
+    return std::vector<std::string>(page.begin(), page.end());
+}
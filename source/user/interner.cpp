@@ -0,0 +1,56 @@
+#include "user/interner.hpp"
+
+#include <algorithm>
+#include <functional>
+
+StringInterner::StringInterner(std::pmr::memory_resource* resource)
+    : resource(resource), strings(resource), names(resource), slots(resource) {}
+
+size_t StringInterner::probe(std::string_view text) const {
+    size_t mask = slots.size() - 1;
+    size_t slot = std::hash<std::string_view>{}(text) & mask;
+    while (slots[slot] != kEmpty && names[slots[slot]] != text) {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+void StringInterner::grow() {
+    std::pmr::vector<Id> previous(std::max<size_t>(16, slots.size() * 2), kEmpty, resource);
+    previous.swap(slots);
+    for (Id id : previous) {
+        if (id != kEmpty) {
+            slots[probe(names[id])] = id;
+        }
+    }
+}
+
+StringInterner::Id StringInterner::intern(std::string_view text) {
+    // Keep the table at most half full
+    if (2 * (names.size() + 1) > slots.size()) {
+        grow();
+    }
+    size_t slot = probe(text);
+    if (slots[slot] == kEmpty) {
+        slots[slot] = static_cast<Id>(names.size());
+        names.push_back(strings.store(text));
+    }
+    return slots[slot];
+}
+
+std::optional<StringInterner::Id> StringInterner::find(std::string_view text) const {
+    if (slots.empty()) {
+        return std::nullopt;
+    }
+    Id id = slots[probe(text)];
+    if (id == kEmpty) {
+        return std::nullopt;
+    }
+    return id;
+}
+
+void StringInterner::clear() {
+    names.clear();
+    slots.clear();
+    strings.clear();
+}
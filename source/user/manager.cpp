@@ -1,110 +1,289 @@
 #include "user/manager.hpp"
 #include <algorithm>
+#include <iterator>
+#include <new>
+
+UserManager::UserManager() : state(new (storage) State(arena.resource())) {}
 
 void UserManager::reset() {
-    users.clear();
-    groups.clear();
+    arena.reset();
+    state = new (storage) State(arena.resource());
 }
 
-bool UserManager::createUser(const std::string& username) {
-    if (users.find(username) != users.end()) {
+bool UserManager::createUser(std::string_view username) {
+    auto [id, inserted] = state->users.insert(username);
+    if (!inserted) {
         return false; // User already exists
     }
-    users[username] = std::make_unique<User>();
-    users[username]->username = username;
+    userCreated(id);
+    return true;
+}
+
+bool UserManager::createUsers(const std::string_view* usernames, size_t count) {
+    size_t nameBytes = 0;
+    for (size_t i = 0; i < count; ++i) {
+        nameBytes += usernames[i].size();
+    }
+    UserStore& users = state->users;
+    users.reserve(count, nameBytes);
+
+    std::vector<UserId> created(count);
+    size_t inserted = users.insertMany(usernames, count, created.data());
+    if (inserted < count) {
+        // Taken before or earlier in the list: undo this command's inserts
+        for (size_t i = 0; i < inserted; ++i) {
+            users.erase(created[i]);
+        }
+        state->userNamesStale = true; // The names may have moved meanwhile
+        return false;
+    }
+    for (UserId id : created) {
+        userCreated(id);
+    }
     return true;
 }
 
-bool UserManager::deleteUser(const std::string& username) {
-    auto it = users.find(username);
-    if (it == users.end()) {
+void UserManager::userCreated(UserId id) {
+    state->userNamesStale = true;
+    if (state->sortedUsersBuilt) {
+        // Past a point merging costs more than sorting from scratch
+        if (state->newUsers.size() < state->sortedUsers.size()) {
+            state->newUsers.push_back(id);
+        } else {
+            state->sortedUsersBuilt = false;
+            state->newUsers.clear();
+        }
+    }
+}
+
+void UserManager::refreshUserListing() const {
+    State& s = *state;
+    if (!s.userNamesStale) {
+        return;
+    }
+    const UserStore& store = s.users;
+    auto byName = [&store](UserId a, UserId b) { return store.name(a) < store.name(b); };
+
+    if (!s.sortedUsersBuilt) {
+        s.sortedUsers.clear();
+        s.sortedUsers.reserve(store.size());
+        for (UserId id = 0; id < store.slotCount(); ++id) {
+            if (store.live(id)) {
+                s.sortedUsers.push_back(id);
+            }
+        }
+        std::sort(s.sortedUsers.begin(), s.sortedUsers.end(), byName);
+    } else {
+        auto* resource = s.sortedUsers.get_allocator().resource();
+        if (s.usersDeleted) {
+            // Drop deleted users, and slots reused by a user created since
+            std::pmr::vector<std::uint8_t> reused(store.slotCount(), 0, resource);
+            for (UserId id : s.newUsers) {
+                reused[id] = 1;
+            }
+            s.sortedUsers.erase(std::remove_if(s.sortedUsers.begin(), s.sortedUsers.end(),
+                                               [&](UserId id) { return !store.live(id) || reused[id]; }),
+                                s.sortedUsers.end());
+        }
+
+        // A slot may appear twice (created, deleted, created again) or no longer be live
+        auto& added = s.newUsers;
+        added.erase(std::remove_if(added.begin(), added.end(), [&](UserId id) { return !store.live(id); }),
+                    added.end());
+        std::sort(added.begin(), added.end(), byName);
+        added.erase(std::unique(added.begin(), added.end()), added.end());
+
+        std::pmr::vector<UserId> merged(resource);
+        merged.reserve(s.sortedUsers.size() + added.size());
+        std::merge(s.sortedUsers.begin(), s.sortedUsers.end(), added.begin(), added.end(),
+                   std::back_inserter(merged), byName);
+        s.sortedUsers.swap(merged);
+    }
+    s.newUsers.clear();
+    s.sortedUsersBuilt = true;
+    s.usersDeleted = false;
+
+    s.sortedUserNames.resize(s.sortedUsers.size());
+    for (size_t i = 0; i < s.sortedUsers.size(); ++i) {
+        s.sortedUserNames[i] = store.name(s.sortedUsers[i]);
+    }
+    s.userNamesStale = false;
+}
+
+void UserManager::groupAppeared(GroupId group) {
+    auto& sorted = state->sortedGroups;
+    std::string_view name = state->groupNames.name(group);
+    sorted.insert(std::lower_bound(sorted.begin(), sorted.end(), name), name);
+}
+
+void UserManager::groupVanished(GroupId group) {
+    auto& sorted = state->sortedGroups;
+    auto it = std::lower_bound(sorted.begin(), sorted.end(), state->groupNames.name(group));
+    sorted.erase(it);
+}
+
+bool UserManager::deleteUser(std::string_view username) {
+    auto id = state->users.find(username);
+    if (!id) {
         return false; // User doesn't exist
     }
-    // Remove user from all groups
-    for (const auto& group : it->second->groups) {
-        groups.erase(group);
+    // Leave every group; groups without other members disappear
+    for (GroupId group : state->users.groups(*id)) {
+        if (--state->groupMembers[group] == 0) {
+            groupVanished(group);
+        }
     }
-    users.erase(it);
+    state->users.erase(*id);
+    state->usersDeleted = true;
+    state->userNamesStale = true;
     return true;
 }
 
-bool UserManager::disableUser(const std::string& username) {
-    auto it = users.find(username);
-    if (it == users.end()) {
+bool UserManager::disableUser(std::string_view username) {
+    auto id = state->users.find(username);
+    if (!id) {
         return false; // User doesn't exist
     }
-    it->second->enabled = false;
+    state->users.disable(*id);
     return true;
 }
 
-bool UserManager::userExists(const std::string& username) const {
-    return users.find(username) != users.end();
+bool UserManager::userExists(std::string_view username) const {
+    return state->users.find(username).has_value();
+}
+
+std::uint64_t UserManager::usersExist(const std::string_view* names, size_t count) const {
+    std::optional<UserId> ids[64];
+    state->users.findMany(names, count, ids);
+    std::uint64_t found = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (ids[i]) {
+            found |= std::uint64_t(1) << i;
+        }
+    }
+    return found;
+}
+
+bool UserManager::isUserEnabled(std::string_view username) const {
+    auto id = state->users.find(username);
+    return id && state->users.enabled(*id);
 }
 
-bool UserManager::isUserEnabled(const std::string& username) const {
-    auto it = users.find(username);
-    return it != users.end() && it->second->enabled;
+bool UserManager::sendMessage(std::string_view username, std::string_view message) {
+    auto id = state->users.find(username);
+    return id && sendMessage(*id, message);
 }
 
-bool UserManager::sendMessage(const std::string& username, const std::string& message) {
-    auto it = users.find(username);
-    if (it == users.end() || !it->second->enabled) {
+bool UserManager::sendMessage(UserId id, std::string_view message) {
+    if (!state->users.enabled(id)) {
         return false;
     }
-    it->second->messages.push_back(message);
+    state->users.messages(id).push_back(state->messages.append(message));
     return true;
 }
 
-bool UserManager::addUserToGroup(const std::string& username, const std::string& group) {
-    auto it = users.find(username);
-    if (it == users.end()) {
+bool UserManager::addUserToGroup(std::string_view username, std::string_view group) {
+    auto id = state->users.find(username);
+    if (!id) {
         return false;
     }
-    it->second->groups.insert(group);
-    groups.insert(group);
+    addUserToGroup(*id, group);
     return true;
 }
 
-bool UserManager::removeUserFromGroup(const std::string& username, const std::string& group) {
-    auto it = users.find(username);
-    if (it == users.end()) {
+bool UserManager::addUsersToGroup(const std::string_view* usernames, size_t count, std::string_view group) {
+    std::vector<std::optional<UserId>> ids(count);
+    state->users.findMany(usernames, count, ids.data());
+    if (std::any_of(ids.begin(), ids.end(), [](const std::optional<UserId>& id) { return !id; })) {
         return false;
     }
-    it->second->groups.erase(group);
-    
-    // Check if group is empty
-    bool groupEmpty = true;
-    for (const auto& [_, user] : users) {
-        if (user->groups.find(group) != user->groups.end()) {
-            groupEmpty = false;
-            break;
+
+    GroupId groupId = groupIdFor(group);
+    std::uint32_t joined = 0;
+    for (const auto& id : ids) {
+        auto& userGroups = state->users.groups(*id);
+        auto it = std::lower_bound(userGroups.begin(), userGroups.end(), groupId);
+        if (it == userGroups.end() || *it != groupId) {
+            userGroups.insert(it, groupId);
+            ++joined;
         }
     }
-    if (groupEmpty) {
-        groups.erase(group);
+    // One update of the group index for the whole batch
+    if (joined > 0 && state->groupMembers[groupId] == 0) {
+        groupAppeared(groupId);
     }
+    state->groupMembers[groupId] += joined;
     return true;
 }
 
-std::vector<std::string> UserManager::getUsers() const {
-    std::vector<std::string> userList;
-    for (const auto& [username, user] : users) {
-        userList.push_back(username);
+GroupId UserManager::groupIdFor(std::string_view group) {
+    GroupId groupId = state->groupNames.intern(group);
+    if (groupId == state->groupMembers.size()) {
+        state->groupMembers.push_back(0);
     }
-    std::sort(userList.begin(), userList.end());
-    return userList;
+    return groupId;
 }
 
-std::vector<std::string> UserManager::getGroups() const {
-    std::vector<std::string> groupList(groups.begin(), groups.end());
-    std::sort(groupList.begin(), groupList.end());
-    return groupList;
+void UserManager::addUserToGroup(UserId id, std::string_view group) {
+    GroupId groupId = groupIdFor(group);
+    auto& userGroups = state->users.groups(id);
+    auto it = std::lower_bound(userGroups.begin(), userGroups.end(), groupId);
+    if (it == userGroups.end() || *it != groupId) {
+        userGroups.insert(it, groupId);
+        if (state->groupMembers[groupId]++ == 0) {
+            groupAppeared(groupId);
+        }
+    }
 }
 
-std::vector<std::string> UserManager::getMessageHistory(const std::string& username) const {
-    auto it = users.find(username);
-    if (it == users.end()) {
-        return {};
+bool UserManager::removeUserFromGroup(std::string_view username, std::string_view group) {
+    auto id = state->users.find(username);
+    if (!id) {
+        return false;
     }
-    return it->second->messages;
-}
\ No newline at end of file
+    removeUserFromGroup(*id, group);
+    return true;
+}
+
+void UserManager::removeUserFromGroup(UserId id, std::string_view group) {
+    auto groupId = state->groupNames.find(group);
+    if (!groupId) {
+        return;
+    }
+    auto& userGroups = state->users.groups(id);
+    auto it = std::lower_bound(userGroups.begin(), userGroups.end(), *groupId);
+    if (it != userGroups.end() && *it == *groupId) {
+        userGroups.erase(it);
+        if (--state->groupMembers[*groupId] == 0) {
+            groupVanished(*groupId);
+        }
+    }
+}
+
+ViewRange UserManager::getUsers(std::string_view prefix) const {
+    refreshUserListing();
+    const auto& names = state->sortedUserNames;
+    // Names with the prefix form one block, starting where the prefix would sort
+    auto first = std::lower_bound(names.begin(), names.end(), prefix);
+    auto last = std::partition_point(first, names.end(), [prefix](std::string_view name) {
+        return name.substr(0, prefix.size()) == prefix;
+    });
+    return ViewRange(names.data() + (first - names.begin()), names.data() + (last - names.begin()));
+}
+
+ViewRange UserManager::getGroups() const {
+    const auto& sorted = state->sortedGroups;
+    return ViewRange(sorted.data(), sorted.data() + sorted.size());
+}
+
+MessageRange UserManager::getMessageHistory(std::string_view username, size_t from, size_t limit) const {
+    auto id = state->users.find(username);
+    return id ? getMessageHistory(*id, from, limit) : MessageRange();
+}
+
+MessageRange UserManager::getMessageHistory(UserId id, size_t from, size_t limit) const {
+    const auto& messages = state->users.messages(id);
+    size_t first = std::min(from, messages.size());
+    size_t count = std::min(limit, messages.size() - first);
+    return MessageRange(messages.data() + first, messages.data() + first + count);
+}
@@ -0,0 +1,235 @@
+#include "user/store.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <stdexcept>
+
+UserStore::UserStore(std::pmr::memory_resource* resource)
+    : flags(resource), handles(resource), messageLists(resource), groupLists(resource),
+      arena(resource), freeSlots(resource), buckets(resource) {}
+
+std::uint32_t UserStore::hashName(std::string_view name) {
+    auto h = static_cast<std::uint64_t>(std::hash<std::string_view>{}(name));
+    return static_cast<std::uint32_t>(h ^ (h >> 32));
+}
+
+size_t UserStore::distance(size_t bucket) const {
+    size_t mask = buckets.size() - 1;
+    return (bucket - (buckets[bucket].hash & mask)) & mask;
+}
+
+size_t UserStore::locate(std::string_view text, std::uint32_t hash) const {
+    if (buckets.empty()) {
+        return 0;
+    }
+    size_t mask = buckets.size() - 1;
+    size_t bucket = hash & mask;
+    // Robin Hood invariant: once we are further from home than the
+    // occupant is from its own, the name cannot be further along
+    for (size_t dist = 0;; ++dist, bucket = (bucket + 1) & mask) {
+        const Bucket& b = buckets[bucket];
+        if (b.id == kEmpty || distance(bucket) < dist) {
+            return buckets.size();
+        }
+        if (b.hash == hash && name(b.id) == text) {
+            return bucket;
+        }
+    }
+}
+
+void UserStore::place(Bucket entry) {
+    size_t mask = buckets.size() - 1;
+    size_t bucket = entry.hash & mask;
+    for (size_t dist = 0;; ++dist, bucket = (bucket + 1) & mask) {
+        if (buckets[bucket].id == kEmpty) {
+            buckets[bucket] = entry;
+            return;
+        }
+        // Take the bucket from an entry closer to its home, and carry that one on
+        size_t occupantDist = distance(bucket);
+        if (occupantDist < dist) {
+            std::swap(entry, buckets[bucket]);
+            dist = occupantDist;
+        }
+    }
+}
+
+void UserStore::grow() {
+    rehash(std::max<size_t>(16, buckets.size() * 2));
+}
+
+void UserStore::rehash(size_t bucketCount) {
+    std::pmr::vector<Bucket> previous(bucketCount, Bucket{kEmpty, 0}, buckets.get_allocator());
+    previous.swap(buckets);
+    for (const Bucket& entry : previous) {
+        if (entry.id != kEmpty) {
+            place(entry);
+        }
+    }
+}
+
+void UserStore::compactArena() {
+    std::pmr::vector<char> packed(arena.get_allocator());
+    packed.reserve(arena.size() - deadBytes);
+    for (UserId id = 0; id < slotCount(); ++id) {
+        if (live(id)) {
+            std::string_view text = name(id);
+            handles[id].offset = static_cast<std::uint32_t>(packed.size());
+            packed.insert(packed.end(), text.begin(), text.end());
+        }
+    }
+    arena.swap(packed);
+    deadBytes = 0;
+}
+
+std::optional<UserId> UserStore::find(std::string_view name) const {
+    size_t bucket = locate(name, hashName(name));
+    if (bucket == buckets.size()) {
+        return std::nullopt;
+    }
+    return buckets[bucket].id;
+}
+
+void UserStore::findMany(const std::string_view* names, size_t count, std::optional<UserId>* ids) const {
+    constexpr size_t kBatch = 16;
+    std::uint32_t hashes[kBatch];
+    for (size_t start = 0; start < count; start += kBatch) {
+        size_t n = std::min(kBatch, count - start);
+        for (size_t i = 0; i < n; ++i) {
+            hashes[i] = hashName(names[start + i]);
+#if defined(__GNUC__) || defined(__clang__)
+            if (!buckets.empty()) {
+                __builtin_prefetch(&buckets[hashes[i] & (buckets.size() - 1)]);
+            }
+#endif
+        }
+        for (size_t i = 0; i < n; ++i) {
+            size_t bucket = locate(names[start + i], hashes[i]);
+            ids[start + i] = bucket == buckets.size() ? std::nullopt : std::optional<UserId>(buckets[bucket].id);
+        }
+    }
+}
+
+std::pair<UserId, bool> UserStore::insert(std::string_view name) {
+    return insert(name, hashName(name));
+}
+
+size_t UserStore::insertMany(const std::string_view* names, size_t count, UserId* ids) {
+    reserve(count, 0);
+    constexpr size_t kBatch = 16;
+    std::uint32_t hashes[kBatch];
+    for (size_t start = 0; start < count; start += kBatch) {
+        size_t n = std::min(kBatch, count - start);
+        // The index does not grow within the call, so the fetched buckets stay valid
+        for (size_t i = 0; i < n; ++i) {
+            hashes[i] = hashName(names[start + i]);
+#if defined(__GNUC__) || defined(__clang__)
+            __builtin_prefetch(&buckets[hashes[i] & (buckets.size() - 1)]);
+#endif
+        }
+        for (size_t i = 0; i < n; ++i) {
+            auto [id, inserted] = insert(names[start + i], hashes[i]);
+            if (!inserted) {
+                return start + i;
+            }
+            ids[start + i] = id;
+        }
+    }
+    return count;
+}
+
+std::pair<UserId, bool> UserStore::insert(std::string_view name, std::uint32_t hash) {
+    size_t bucket = locate(name, hash);
+    if (bucket != buckets.size()) {
+        return {buckets[bucket].id, false};
+    }
+    if (arena.size() + name.size() > std::numeric_limits<std::uint32_t>::max()) {
+        throw std::length_error("User names exceed 4 GiB");
+    }
+
+    UserId id;
+    if (!freeSlots.empty()) {
+        id = freeSlots.back();
+        freeSlots.pop_back();
+    } else {
+        id = slotCount();
+        flags.push_back(0);
+        handles.push_back({});
+        messageLists.emplace_back();
+        groupLists.emplace_back();
+    }
+    flags[id] = kLive | kEnabled;
+    handles[id] = {static_cast<std::uint32_t>(arena.size()), static_cast<std::uint32_t>(name.size())};
+    arena.insert(arena.end(), name.begin(), name.end());
+    ++liveCount;
+
+    // Keep the index at most 7/8 full; Robin Hood keeps probes short there
+    if (8 * (liveCount + 1) > 7 * buckets.size()) {
+        grow();
+    }
+    place({id, hash});
+    return {id, true};
+}
+
+void UserStore::reserve(size_t count, size_t nameBytes) {
+    size_t slots = slotCount() + (count > freeSlots.size() ? count - freeSlots.size() : 0);
+    flags.reserve(slots);
+    handles.reserve(slots);
+    messageLists.reserve(slots);
+    groupLists.reserve(slots);
+    arena.reserve(arena.size() + nameBytes);
+
+    // The same 7/8 bound as insert(), reached with a single rehash
+    size_t bucketCount = std::max<size_t>(16, buckets.size());
+    while (8 * (liveCount + count + 1) > 7 * bucketCount) {
+        bucketCount *= 2;
+    }
+    if (bucketCount != buckets.size()) {
+        rehash(bucketCount);
+    }
+}
+
+void UserStore::erase(UserId id) {
+    std::string_view text = name(id);
+    size_t bucket = locate(text, hashName(text));
+
+    // Backward-shift deletion: pull the following entries one step closer
+    // to home until one is already there
+    size_t mask = buckets.size() - 1;
+    size_t next = (bucket + 1) & mask;
+    while (buckets[next].id != kEmpty && distance(next) > 0) {
+        buckets[bucket] = buckets[next];
+        bucket = next;
+        next = (next + 1) & mask;
+    }
+    buckets[bucket] = {kEmpty, 0};
+
+    deadBytes += handles[id].length;
+    flags[id] = 0;
+    handles[id] = {};
+    // Hand the lists' memory back for reuse by later users
+    messageLists[id].clear();
+    messageLists[id].shrink_to_fit();
+    groupLists[id].clear();
+    groupLists[id].shrink_to_fit();
+    freeSlots.push_back(id);
+    --liveCount;
+
+    // Reclaim the arena once most of it belongs to deleted users
+    if (deadBytes > (size_t(1) << 20) && 2 * deadBytes > arena.size()) {
+        compactArena();
+    }
+}
+
+void UserStore::clear() {
+    flags.clear();
+    handles.clear();
+    messageLists.clear();
+    groupLists.clear();
+    arena.clear();
+    deadBytes = 0;
+    freeSlots.clear();
+    liveCount = 0;
+    buckets.clear();
+}
@@ -0,0 +1,36 @@
+#include "user/text.hpp"
+
+#include <cstring>
+
+char* TextArena::allocateBlock(size_t bytes) {
+    blocks.emplace_back(static_cast<char*>(resource->allocate(bytes, 1)), bytes);
+    return blocks.back().first;
+}
+
+std::string_view TextArena::store(std::string_view text) {
+    char* data;
+    if (text.size() > kBlockBytes / 4) {
+        data = allocateBlock(text.size());
+    } else {
+        if (text.size() > blockFree) {
+            cursor = allocateBlock(kBlockBytes);
+            blockFree = kBlockBytes;
+        }
+        data = cursor;
+        cursor += text.size();
+        blockFree -= text.size();
+    }
+    if (!text.empty()) {
+        std::memcpy(data, text.data(), text.size());
+    }
+    return {data, text.size()};
+}
+
+void TextArena::clear() {
+    for (auto [block, bytes] : blocks) {
+        resource->deallocate(block, bytes, 1);
+    }
+    blocks.clear();
+    cursor = nullptr;
+    blockFree = 0;
+}
@@ -0,0 +1,167 @@
+// CompiledTask (.wzt): a compiled task replays exactly as its text runs, and
+// a damaged or truncated file is refused rather than misread
+#include <cstddef>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#include <gtest/gtest.h>
+#include <fmt/format.h>
+
+#include "output/sink.hpp"
+#include "task/codec.hpp"
+#include "task/compiled.hpp"
+#include "task/mapped.hpp"
+#include "task/processor.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#endif
+
+namespace {
+
+// Every command kind, a comment and, last, a line the parser rejects, which
+// fails the task
+const std::string kTask = "CREATE USER alice\n"
+                          "CREATE USERS u[1..40]\n"
+                          "# a comment\n"
+                          "DISABLE USER u3\n"
+                          "DELETE USER u4\n"
+                          "SEND MESSAGE alice \"hello, world\"\n"
+                          "SEND MESSAGE alice \"again\"\n"
+                          "ADD USER alice TO GROUP admins\n"
+                          "ADD USERS u[5..9] TO GROUP staff\n"
+                          "REMOVE USER u5 FROM GROUP staff\n"
+                          "PING alice,u1 3 SUMMARY\n"
+                          "GET USERS WITH PREFIX u1\n"
+                          "GET GROUPS\n"
+                          "GET MESSAGE HISTORY alice FROM 1 LIMIT 5\n"
+                          "CREATE USR alice\n";
+
+std::string tempPath(const char* name) {
+    return fmt::format("{}wzh-compiled-test-{}-{}", ::testing::TempDir(), ::getpid(), name);
+}
+
+void writeFile(const std::string& path, std::string_view bytes) { FileSink(path).write(bytes); }
+
+std::string readFile(const std::string& path) { return std::string(MappedFile(path).view()); }
+
+/// @brief The transcript of the task in path, with its name replaced by "task"
+std::string transcriptOf(const std::string& path) {
+    MemorySink transcript;
+    {
+        TaskProcessor processor(ProcessorOptions{}, transcript);
+        processor.processTask(path);
+    }
+    std::string text(transcript.contents());
+    for (size_t at = text.find(path); at != std::string::npos; at = text.find(path, at)) {
+        text.replace(at, path.size(), "task");
+    }
+    return text;
+}
+
+/// @brief Decode every entry of the compiled task in bytes
+size_t decodeAll(std::string_view bytes) {
+    std::string path = tempPath("decode.wzt");
+    writeFile(path, bytes);
+    CompiledTask task{MappedFile(path)};
+    std::remove(path.c_str());
+    CompiledLine line;
+    size_t entries = 0;
+    while (task.next(line)) {
+        ++entries;
+    }
+    return entries;
+}
+
+/// @brief The compiled form of kTask
+class CompiledFixture : public ::testing::Test {
+protected:
+    std::string source = tempPath("task.txt");
+    std::string target = tempPath("task.wzt");
+    CompileStats stats;
+    std::string compiled;
+
+    void SetUp() override {
+        writeFile(source, kTask);
+        stats = compileTask(source, target);
+        compiled = readFile(target);
+    }
+
+    void TearDown() override {
+        std::remove(source.c_str());
+        std::remove(target.c_str());
+    }
+
+    /// @brief compiled with its checksum recomputed, as if written that way
+    static std::string resealed(std::string bytes) {
+        std::string sum;
+        putLe(sum, checksum(std::string_view(bytes).substr(CompiledTask::kHeaderBytes)), 8);
+        bytes.replace(8, 8, sum);
+        return bytes;
+    }
+};
+
+TEST_F(CompiledFixture, ReplaysAsTheTextRuns) {
+    EXPECT_EQ(stats.commands, 14u);
+    EXPECT_EQ(stats.invalidLines, 1u);
+    EXPECT_EQ(stats.compiledBytes, compiled.size());
+    ASSERT_TRUE(CompiledTask::matches(compiled));
+
+    std::string expected = transcriptOf(source);
+    ASSERT_NE(expected.find("❌ Invalid command: CREATE USR alice"), std::string::npos);
+    EXPECT_EQ(transcriptOf(target), expected);
+    EXPECT_EQ(decodeAll(compiled), stats.commands);
+}
+
+TEST_F(CompiledFixture, RejectsAnyChangedByte) {
+    // After the magic: the version, the checksum itself, or what it covers
+    for (size_t i = 4; i < compiled.size(); ++i) {
+        std::string damaged = compiled;
+        damaged[i] = static_cast<char>(damaged[i] ^ 0x20);
+        EXPECT_THROW(decodeAll(damaged), std::runtime_error) << "byte " << i;
+    }
+}
+
+TEST_F(CompiledFixture, RejectsAnotherVersion) {
+    std::string other = compiled;
+    other[4] = static_cast<char>(CompiledTask::kVersion + 1);
+    try {
+        decodeAll(other);
+        FAIL() << "decoded";
+    } catch (const std::runtime_error& e) {
+        EXPECT_NE(std::string(e.what()).find("recompile it"), std::string::npos) << e.what();
+    }
+}
+
+TEST_F(CompiledFixture, RejectsTruncation) {
+    for (size_t length = 0; length < compiled.size(); ++length) {
+        EXPECT_THROW(decodeAll(compiled.substr(0, length)), std::runtime_error) << "length " << length;
+    }
+}
+
+TEST_F(CompiledFixture, BoundsChecksEntriesThatPassTheChecksum) {
+    // A short file whose checksum matches: every read past the end is caught
+    // while decoding rather than run over
+    size_t header = CompiledTask::kHeaderBytes + static_cast<size_t>(getLe(compiled.data() + 24, 8));
+    for (size_t length = header; length < compiled.size(); ++length) {
+        try {
+            decodeAll(resealed(compiled.substr(0, length)));
+            ADD_FAILURE() << "decoded at length " << length;
+        } catch (const std::runtime_error& e) {
+            EXPECT_EQ(std::string_view(e.what()).substr(0, 22), "Corrupt compiled task:") << e.what();
+        }
+    }
+}
+
+TEST_F(CompiledFixture, RunningADamagedFileFailsTheTask) {
+    writeFile(target, compiled.substr(0, compiled.size() - 3));
+    std::string transcript = transcriptOf(target);
+    EXPECT_NE(transcript.find("❌ Error processing task task: Corrupt compiled task: checksum mismatch"),
+              std::string::npos)
+        << transcript;
+    EXPECT_EQ(transcript.find("✅"), std::string::npos);
+}
+
+} // namespace
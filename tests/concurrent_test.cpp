@@ -0,0 +1,284 @@
+// ConcurrentUserManager: bulk creation and group joins are all-or-none
+// across shards, listings merge the shards into one consistent, ordered
+// snapshot while other threads write, and tasks given it as shared state
+// see each other's changes
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdio>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <fmt/format.h>
+
+#include "output/sink.hpp"
+#include "task/processor.hpp"
+#include "user/concurrent.hpp"
+#include "user/manager.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#endif
+
+namespace {
+
+std::vector<std::string> names(const std::string& stem, size_t count) {
+    std::vector<std::string> result;
+    for (size_t i = 0; i < count; ++i) {
+        result.push_back(fmt::format("{}{}", stem, i));
+    }
+    return result;
+}
+
+std::vector<std::string_view> views(const std::vector<std::string>& strings) {
+    return std::vector<std::string_view>(strings.begin(), strings.end());
+}
+
+size_t shardsSpanned(const ConcurrentUserManager& users, const std::vector<std::string>& batch) {
+    std::unordered_set<size_t> shards;
+    for (const auto& name : batch) {
+        shards.insert(users.shardOf(name));
+    }
+    return shards.size();
+}
+
+TEST(ConcurrentUserManager, CreateUsersIsAllOrNoneAcrossShards) {
+    ConcurrentUserManager users;
+    auto batch = names("user", 200);
+    ASSERT_GT(shardsSpanned(users, batch), 32u);
+
+    // Taken in the last shard the batch locks, so every other shard has
+    // created its part by the time the refusal comes
+    auto taken = *std::max_element(batch.begin(), batch.end(), [&](const std::string& a, const std::string& b) {
+        return users.shardOf(a) < users.shardOf(b);
+    });
+    ASSERT_TRUE(users.createUser(taken));
+    auto all = views(batch);
+    EXPECT_FALSE(users.createUsers(all.data(), all.size()));
+    for (const auto& name : batch) {
+        EXPECT_EQ(users.userExists(name), name == taken) << name;
+    }
+    EXPECT_EQ(users.getUsers(), std::vector<std::string>{taken});
+
+    // Then without it, all of them
+    all.erase(std::find(all.begin(), all.end(), taken));
+    EXPECT_TRUE(users.createUsers(all.data(), all.size()));
+    EXPECT_EQ(users.getUsers().size(), batch.size());
+}
+
+TEST(ConcurrentUserManager, CreateUsersRefusesRepeatedNames) {
+    ConcurrentUserManager users;
+    auto batch = names("user", 50);
+    batch.push_back("user7");
+    auto all = views(batch);
+    EXPECT_FALSE(users.createUsers(all.data(), all.size()));
+    EXPECT_TRUE(users.getUsers().empty());
+}
+
+TEST(ConcurrentUserManager, GetUsersMergesShardsInNameOrder) {
+    ConcurrentUserManager users;
+    UserManager reference;
+    auto batch = names("member", 3000);
+    for (const auto& name : batch) {
+        users.createUser(name);
+        reference.createUser(name);
+    }
+    for (std::string_view prefix : {"", "member1", "member29", "member2999", "nobody"}) {
+        auto expected = reference.getUsers(prefix);
+        EXPECT_EQ(users.getUsers(prefix), std::vector<std::string>(expected.begin(), expected.end())) << prefix;
+    }
+}
+
+TEST(ConcurrentUserManager, AddUsersToGroupIsAllOrNoneAcrossShards) {
+    ConcurrentUserManager users;
+    auto batch = names("user", 200);
+    auto all = views(batch);
+    ASSERT_TRUE(users.createUsers(all.data(), all.size()));
+
+    // Missing from the last shard the batch locks
+    std::string missing = "ghost";
+    for (size_t i = 0; users.shardOf(missing) != users.shardCount() - 1; ++i) {
+        missing = fmt::format("ghost{}", i);
+    }
+    all.push_back(missing);
+    EXPECT_FALSE(users.addUsersToGroup(all.data(), all.size(), "staff"));
+    EXPECT_TRUE(users.getGroups().empty());
+
+    all.pop_back();
+    EXPECT_TRUE(users.addUsersToGroup(all.data(), all.size(), "staff"));
+    EXPECT_EQ(users.getGroups(), std::vector<std::string>{"staff"});
+}
+
+TEST(ConcurrentUserManager, GetGroupsListsEachGroupOnceAcrossShards) {
+    ConcurrentUserManager users;
+    auto batch = names("user", 100);
+    for (const auto& name : batch) {
+        ASSERT_TRUE(users.createUser(name));
+        ASSERT_TRUE(users.addUserToGroup(name, "everyone"));
+    }
+    ASSERT_TRUE(users.addUserToGroup(batch[3], "admins"));
+    ASSERT_TRUE(users.addUserToGroup(batch[70], "zebras"));
+    EXPECT_EQ(users.getGroups(), (std::vector<std::string>{"admins", "everyone", "zebras"}));
+
+    // A group goes when its last member, in whichever shard, leaves
+    EXPECT_TRUE(users.removeUserFromGroup(batch[3], "admins"));
+    EXPECT_TRUE(users.deleteUser(batch[70]));
+    EXPECT_EQ(users.getGroups(), std::vector<std::string>{"everyone"});
+    EXPECT_FALSE(users.addUserToGroup("nobody", "admins"));
+}
+
+TEST(ConcurrentUserManager, RunsEveryCommandAUserManagerRuns) {
+    ConcurrentUserManager users;
+    ASSERT_TRUE(users.createUser("alice"));
+    ASSERT_TRUE(users.createUser("bob"));
+    EXPECT_FALSE(users.createUser("bob"));
+
+    for (int i = 0; i < 5; ++i) {
+        EXPECT_TRUE(users.sendMessage("alice", fmt::format("m{}", i)));
+    }
+    EXPECT_FALSE(users.sendMessage("carol", "hi"));
+    EXPECT_EQ(users.getMessageHistory("alice", 1, 2), (std::vector<std::string>{"m1", "m2"}));
+    EXPECT_EQ(users.getMessageHistory("alice", 9), std::vector<std::string>{});
+    EXPECT_EQ(users.getMessageHistory("carol"), std::nullopt);
+
+    EXPECT_TRUE(users.disableUser("bob"));
+    EXPECT_FALSE(users.isUserEnabled("bob"));
+    EXPECT_FALSE(users.disableUser("carol"));
+
+    std::vector<std::string_view> targets{"carol", "alice", "bob", "dave"};
+    EXPECT_EQ(users.usersExist(targets.data(), targets.size()), 0b0110u);
+    EXPECT_TRUE(users.deleteUser("bob"));
+    EXPECT_FALSE(users.deleteUser("bob"));
+    EXPECT_EQ(users.usersExist(targets.data(), targets.size()), 0b0010u);
+
+    users.reset();
+    EXPECT_TRUE(users.getUsers().empty());
+    EXPECT_FALSE(users.userExists("alice"));
+    EXPECT_TRUE(users.createUser("alice"));
+    EXPECT_EQ(users.getMessageHistory("alice"), std::vector<std::string>{});
+}
+
+// Writers create batches across every shard, every third of them refused
+// over a taken name; readers must only ever see whole batches, in order
+TEST(ConcurrentUserManager, ListingsSeeWholeBatchesWhileWritersRun) {
+    constexpr size_t kWriters = 4;
+    constexpr size_t kBatches = 150;
+    constexpr size_t kBatchSize = 40;
+
+    ConcurrentUserManager users;
+    ASSERT_TRUE(users.createUser("taken"));
+
+    std::atomic<size_t> writersDone{0};
+    std::vector<std::thread> threads;
+    for (size_t w = 0; w < kWriters; ++w) {
+        threads.emplace_back([&, w] {
+            for (size_t b = 0; b < kBatches; ++b) {
+                auto batch = names(fmt::format("w{}b{}-", w, b), kBatchSize);
+                if (b % 3 == 2) {
+                    batch.push_back("taken");
+                }
+                auto all = views(batch);
+                EXPECT_EQ(users.createUsers(all.data(), all.size()), b % 3 != 2);
+            }
+            ++writersDone;
+        });
+    }
+
+    std::atomic<size_t> listings{0};
+    for (size_t r = 0; r < 2; ++r) {
+        threads.emplace_back([&] {
+            do {
+                auto listing = users.getUsers("w");
+                ASSERT_TRUE(std::is_sorted(listing.begin(), listing.end()));
+                // Members of a batch differ in the suffix only, so one is
+                // present exactly when the whole batch is
+                std::unordered_map<std::string, size_t> perBatch;
+                for (const auto& name : listing) {
+                    ++perBatch[name.substr(0, name.find('-'))];
+                }
+                for (const auto& [batch, count] : perBatch) {
+                    ASSERT_EQ(count, kBatchSize) << batch;
+                    size_t b = std::stoul(batch.substr(batch.find('b') + 1));
+                    ASSERT_NE(b % 3, 2u) << batch;
+                }
+                ++listings;
+            } while (writersDone < kWriters);
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    EXPECT_GT(listings.load(), 0u);
+    size_t created = kWriters * (kBatches - kBatches / 3) * kBatchSize;
+    EXPECT_EQ(users.getUsers("w").size(), created);
+    EXPECT_EQ(users.getUsers().size(), created + 1);
+}
+
+class SharedStateFixture : public ::testing::Test {
+protected:
+    std::vector<std::string> paths;
+
+    void TearDown() override {
+        for (const auto& path : paths) {
+            std::remove(path.c_str());
+        }
+    }
+
+    std::string task(const std::string& text) {
+        paths.push_back(fmt::format("{}wzh-shared-test-{}-{}.txt", ::testing::TempDir(), ::getpid(), paths.size()));
+        FileSink(paths.back()).write(text);
+        return paths.back();
+    }
+
+    std::string run(ConcurrentUserManager& users, const std::vector<std::string>& tasks, size_t jobs) {
+        MemorySink transcript;
+        ProcessorOptions options;
+        options.sharedState = &users;
+        TaskProcessor processor(options, transcript);
+        processor.processTasks(tasks, jobs);
+        return std::string(transcript.contents());
+    }
+};
+
+TEST_F(SharedStateFixture, TasksStartFromWhatEarlierOnesLeft) {
+    ConcurrentUserManager users;
+    std::string transcript = run(users, {task("CREATE USER alice\nADD USER alice TO GROUP admins\n"),
+                                         task("CREATE USER bob\nGET USERS\nGET GROUPS\n"),
+                                         task("CREATE USER alice\n")}, 1);
+    EXPECT_NE(transcript.find("Users: alice, bob"), std::string::npos) << transcript;
+    EXPECT_NE(transcript.find("Groups: admins"), std::string::npos) << transcript;
+    EXPECT_NE(transcript.find("User already exists"), std::string::npos) << transcript;
+    EXPECT_EQ(users.getUsers(), (std::vector<std::string>{"alice", "bob"}));
+}
+
+TEST_F(SharedStateFixture, ParallelTasksChangeOneStore) {
+    constexpr size_t kTasks = 8;
+    std::vector<std::string> tasks;
+    for (size_t i = 0; i < kTasks; ++i) {
+        tasks.push_back(task(fmt::format("CREATE USERS t{0}u[1..100]\nADD USERS t{0}u[1..100] TO GROUP all\n"
+                                         "SEND MESSAGE t{0}u1 \"from {0}\"\nGET GROUPS\n", i)));
+    }
+    ConcurrentUserManager users;
+    std::string transcript = run(users, tasks, 4);
+    EXPECT_EQ(transcript.find("stopped"), std::string::npos) << transcript;
+    EXPECT_EQ(users.getUsers().size(), kTasks * 100);
+    EXPECT_EQ(users.getGroups(), std::vector<std::string>{"all"});
+    EXPECT_EQ(users.getMessageHistory("t5u1"), std::vector<std::string>{"from 5"});
+}
+
+TEST(SharedState, RefusesStateThatIsRestoredOrRecorded) {
+    ConcurrentUserManager users;
+    ProcessorOptions options;
+    options.sharedState = &users;
+    EXPECT_THROW(TaskProcessor(options).saveSnapshot("unused.wzs"), std::runtime_error);
+}
+
+} // namespace
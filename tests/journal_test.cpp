@@ -0,0 +1,308 @@
+// Journal: committed commands replay as appended, across reopening, and a
+// batch torn by a crash is cut off so that later batches follow intact ones
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <fmt/format.h>
+
+#include "output/sink.hpp"
+#include "task/codec.hpp"
+#include "task/journal.hpp"
+#include "task/mapped.hpp"
+#include "task/processor.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <csignal>
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+constexpr size_t kBatchHeaderBytes = 16;
+
+/// @brief A command as comparable text: its opcode, then every operand
+class Flattener : public OperandWriter<Flattener> {
+public:
+    explicit Flattener(std::string& out) : OperandWriter(out) {}
+
+    using OperandWriter::put;
+    void put(std::string_view text) { out += fmt::format("[{}]", text); }
+};
+
+std::string flatten(const Command& command) {
+    std::string text = std::to_string(command.index());
+    Flattener(text).putCommand(command);
+    return text;
+}
+
+const std::vector<std::string> kLines = {
+    "CREATE USER alice",
+    "CREATE USERS u[1..5]",
+    "CREATE USERS bob,carol",
+    "DELETE USER u2",
+    "DISABLE USER u3",
+    "SEND MESSAGE alice \"hello, world\"",
+    "ADD USER alice TO GROUP admins",
+    "ADD USERS u[4..5] TO GROUP staff",
+    "REMOVE USER u4 FROM GROUP staff",
+};
+
+class JournalFixture : public ::testing::Test {
+protected:
+    std::string path = fmt::format("{}wzh-journal-test-{}.wzj", ::testing::TempDir(), ::getpid());
+
+    void SetUp() override { std::remove(path.c_str()); }
+    void TearDown() override { std::remove(path.c_str()); }
+
+    std::string read() { return std::string(MappedFile(path).view()); }
+    void write(std::string_view bytes) { FileSink(path).write(bytes); }
+    size_t fileSize() { return static_cast<size_t>(std::filesystem::file_size(path)); }
+
+    /// @brief Append the given lines' commands, one batch per commit
+    void append(Journal& journal, const std::vector<std::string>& lines) {
+        for (const auto& line : lines) {
+            auto command = TaskProcessor::parseCommand(line);
+            ASSERT_TRUE(command) << line;
+            journal.append(*command);
+        }
+        journal.commit();
+    }
+
+    std::vector<std::string> flattened(const std::vector<std::string>& lines) {
+        std::vector<std::string> result;
+        for (const auto& line : lines) {
+            result.push_back(flatten(*TaskProcessor::parseCommand(line)));
+        }
+        return result;
+    }
+
+    std::vector<std::string> replayed() {
+        Journal journal(path);
+        std::vector<std::string> result;
+        journal.replay([&](const Command& command) { result.push_back(flatten(command)); });
+        EXPECT_EQ(journal.stats().replayed, result.size());
+        return result;
+    }
+};
+
+TEST_F(JournalFixture, ReplaysCommittedCommandsInOrder) {
+    {
+        Journal journal(path);
+        EXPECT_EQ(journal.generation(), 0u);
+        append(journal, {kLines.begin(), kLines.begin() + 4});
+        append(journal, {kLines.begin() + 4, kLines.end()});
+        EXPECT_EQ(journal.stats().commits, 2u);
+        EXPECT_EQ(journal.stats().recorded, kLines.size());
+        EXPECT_EQ(journal.stats().bytes + Journal::kHeaderBytes, fileSize());
+    }
+    EXPECT_EQ(replayed(), flattened(kLines));
+
+    // Opened again, new batches follow the old ones
+    {
+        Journal journal(path);
+        append(journal, {"CREATE USER dave"});
+    }
+    auto expected = flattened(kLines);
+    expected.push_back(flatten(*TaskProcessor::parseCommand("CREATE USER dave")));
+    EXPECT_EQ(replayed(), expected);
+}
+
+TEST_F(JournalFixture, UncommittedRecordsAreCommittedByTheDestructor) {
+    {
+        Journal journal(path);
+        auto command = TaskProcessor::parseCommand(kLines[0]);
+        journal.append(*command);
+    }
+    EXPECT_EQ(replayed(), flattened({kLines[0]}));
+}
+
+TEST_F(JournalFixture, RestartDropsRecordsForTheNextGeneration) {
+    {
+        Journal journal(path);
+        append(journal, kLines);
+        journal.restart(4);
+        append(journal, {kLines[0]});
+    }
+    EXPECT_EQ(Journal(path).generation(), 4u);
+    EXPECT_EQ(replayed(), flattened({kLines[0]}));
+}
+
+TEST_F(JournalFixture, TornTailBatchIsTruncatedOnReopen) {
+    size_t intact = 0;
+    {
+        Journal journal(path);
+        append(journal, {kLines.begin(), kLines.begin() + 3});
+        intact = fileSize();
+        append(journal, {kLines.begin() + 3, kLines.end()});
+    }
+    const std::string whole = read();
+    const auto first = flattened({kLines.begin(), kLines.begin() + 3});
+
+    // Cut anywhere in the second batch, its header included
+    for (size_t length = intact; length < whole.size(); ++length) {
+        write(whole.substr(0, length));
+        EXPECT_EQ(replayed(), first) << "length " << length;
+        EXPECT_EQ(fileSize(), intact) << "length " << length;
+    }
+
+    // Its payload damaged instead, or its size claiming more than is there
+    std::string damaged = whole;
+    damaged.back() = static_cast<char>(damaged.back() ^ 0x01);
+    write(damaged);
+    EXPECT_EQ(replayed(), first);
+    EXPECT_EQ(fileSize(), intact);
+    damaged = whole;
+    damaged[intact] = static_cast<char>(damaged[intact] + 1);
+    write(damaged);
+    EXPECT_EQ(replayed(), first);
+    EXPECT_EQ(fileSize(), intact);
+
+    // Damage to the first batch drops both
+    damaged = whole;
+    damaged[Journal::kHeaderBytes + kBatchHeaderBytes] ^= 0x01;
+    write(damaged);
+    EXPECT_TRUE(replayed().empty());
+    EXPECT_EQ(fileSize(), Journal::kHeaderBytes);
+
+    // What is appended after a cut replays after the intact batches
+    write(whole.substr(0, whole.size() - 1));
+    {
+        Journal journal(path);
+        append(journal, {"CREATE USER dave"});
+    }
+    auto expected = first;
+    expected.push_back(flatten(*TaskProcessor::parseCommand("CREATE USER dave")));
+    EXPECT_EQ(replayed(), expected);
+}
+
+#if defined(__unix__) || defined(__APPLE__)
+// A file size limit makes the write stop partway through the batch, as a
+// full disk would
+TEST_F(JournalFixture, FailedCommitIsCutOffBeforeTheNextOne) {
+    Journal journal(path);
+    append(journal, {kLines[0]});
+    const size_t intact = fileSize();
+
+    rlimit saved{};
+    ASSERT_EQ(::getrlimit(RLIMIT_FSIZE, &saved), 0);
+    auto handler = std::signal(SIGXFSZ, SIG_IGN);
+    rlimit limited = saved;
+    limited.rlim_cur = intact + kBatchHeaderBytes + 2;
+    ASSERT_EQ(::setrlimit(RLIMIT_FSIZE, &limited), 0);
+    auto command = TaskProcessor::parseCommand(kLines[5]);
+    journal.append(*command);
+    EXPECT_THROW(journal.commit(), std::runtime_error);
+    ::setrlimit(RLIMIT_FSIZE, &saved);
+    std::signal(SIGXFSZ, handler);
+
+    EXPECT_EQ(fileSize(), intact);
+    EXPECT_EQ(journal.stats().commits, 1u);
+
+    // The kept record goes out with the next commit, after the intact batch
+    append(journal, {kLines[6]});
+    EXPECT_EQ(replayed(), flattened({kLines[0], kLines[5], kLines[6]}));
+}
+#endif
+
+TEST_F(JournalFixture, ShortFileIsStartedAfresh) {
+    write("WZHJ\x01");
+    Journal journal(path);
+    EXPECT_EQ(journal.generation(), 0u);
+    EXPECT_EQ(fileSize(), Journal::kHeaderBytes);
+}
+
+TEST_F(JournalFixture, RejectsOtherFilesAndVersions) {
+    write("not a journal at all");
+    EXPECT_THROW(Journal{path}, std::runtime_error);
+    EXPECT_EQ(read(), "not a journal at all");
+
+    std::string header("WZHJ");
+    putLe(header, Journal::kVersion + 1, 4);
+    putLe(header, 0, 8);
+    write(header);
+    try {
+        Journal journal(path);
+        FAIL() << "opened";
+    } catch (const std::runtime_error& e) {
+        EXPECT_EQ(std::string(e.what()), fmt::format("Journal has format version {}, expected {}",
+                                                     Journal::kVersion + 1, Journal::kVersion));
+    }
+}
+
+TEST_F(JournalFixture, ReplayBoundsChecksBatchesThatPassTheChecksum) {
+    {
+        Journal journal(path);
+        append(journal, {kLines[5]});
+    }
+    const std::string whole = read();
+    std::string_view payload = std::string_view(whole).substr(Journal::kHeaderBytes + kBatchHeaderBytes);
+
+    /// @brief The journal with its one batch made of body, claiming count records
+    auto reseal = [&](std::string_view body, std::uint32_t count) {
+        std::string bytes = whole.substr(0, Journal::kHeaderBytes);
+        putLe(bytes, body.size(), 4);
+        putLe(bytes, count, 4);
+        putLe(bytes, checksum(body), 8);
+        bytes.append(body);
+        return bytes;
+    };
+    auto replayError = [&](const std::string& bytes) -> std::string {
+        write(bytes);
+        try {
+            replayed();
+        } catch (const std::runtime_error& e) {
+            return e.what();
+        }
+        return "";
+    };
+
+    EXPECT_EQ(replayError(reseal(payload, 1)), "");
+    EXPECT_EQ(replayError(reseal(payload, 2)), "Corrupt journal: truncated entry");
+    EXPECT_EQ(replayError(reseal(payload, 0)), "Corrupt journal: trailing bytes in batch");
+    for (size_t length = 0; length < payload.size(); ++length) {
+        EXPECT_NE(replayError(reseal(payload.substr(0, length), 1)), "") << "length " << length;
+    }
+    std::string unknown(1, static_cast<char>(0x7F));
+    EXPECT_EQ(replayError(reseal(unknown, 1)), "Corrupt journal: unknown opcode");
+}
+
+TEST_F(JournalFixture, TaskStateCarriesOverThroughTheJournal) {
+    const std::string task = fmt::format("{}\n", fmt::join(kLines, "\n"));
+    const std::string queries = "GET USERS\nGET GROUPS\nGET MESSAGE HISTORY alice\n";
+    auto run = [&](const std::string& text, Journal* journal) {
+        std::string taskPath = path + ".txt";
+        FileSink(taskPath).write(text);
+        MemorySink transcript;
+        {
+            ProcessorOptions options;
+            options.journal = journal;
+            TaskProcessor processor(options, transcript);
+            processor.processTask(taskPath);
+        }
+        std::remove(taskPath.c_str());
+        std::string result(transcript.contents());
+        return result.substr(result.find('\n') + 1);
+    };
+    {
+        Journal journal(path);
+        run(task, &journal);
+        // Queries change nothing, so are not recorded
+        run(queries, &journal);
+        EXPECT_EQ(journal.stats().recorded, kLines.size());
+    }
+    Journal journal(path);
+    std::string continued = run(queries, &journal);
+    std::string whole = run(task + queries, nullptr);
+    EXPECT_EQ(whole.substr(whole.size() - continued.size()), continued);
+    EXPECT_NE(continued.find("Users: alice, bob, carol, u1, u3, u4, u5"), std::string::npos) << continued;
+}
+
+} // namespace
@@ -0,0 +1,55 @@
+// MappedFile: views taken before a move stay valid after it, for mapped
+// files and for contents read from a pipe alike
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+
+#include <gtest/gtest.h>
+#include <fmt/format.h>
+
+#include "output/sink.hpp"
+#include "task/mapped.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+std::string tempPath(const char* name) {
+    return fmt::format("{}wzh-mapped-test-{}-{}", ::testing::TempDir(), ::getpid(), name);
+}
+
+TEST(MappedFile, ViewsOfAMappedFileSurviveAMove) {
+    std::string path = tempPath("file");
+    FileSink(path).write("CREATE USER alice\n");
+    MappedFile file(path);
+    std::string_view before = file.view();
+    MappedFile moved(std::move(file));
+    EXPECT_EQ(moved.view().data(), before.data());
+    EXPECT_EQ(before, "CREATE USER alice\n");
+    EXPECT_EQ(file.size(), 0u);
+    std::remove(path.c_str());
+}
+
+#if defined(__unix__) || defined(__APPLE__)
+// Short enough for a string's inline buffer, which would move with the object
+TEST(MappedFile, ViewsOfShortPipedContentsSurviveAMove) {
+    std::string path = tempPath("fifo");
+    ASSERT_EQ(::mkfifo(path.c_str(), 0600), 0);
+    std::thread writer([&] { FileSink(path).write("EXIT\n"); });
+    MappedFile file(path);
+    writer.join();
+    std::string_view before = file.view();
+    ASSERT_EQ(before, "EXIT\n");
+    MappedFile moved(std::move(file));
+    EXPECT_EQ(moved.view().data(), before.data());
+    EXPECT_EQ(before, "EXIT\n");
+    std::remove(path.c_str());
+}
+#endif
+
+} // namespace
@@ -0,0 +1,276 @@
+// CommandParser: every row of CommandTable parses into its command, rows
+// sharing a verb and optional tails pick the right alternative, limits are
+// enforced, and a rejected line is explained at the right column
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <variant>
+
+#include <gtest/gtest.h>
+
+#include "parser/grammar.hpp"
+#include "parser/parser.hpp"
+#include "task/scan.hpp"
+
+namespace {
+
+/// @brief Parse line as plain text and with the token masks of a scan,
+///        which must agree
+std::optional<Command> parse(std::string_view line) {
+    auto plain = CommandParser::parse(line);
+    TextTokens tokens;
+    LineScanner::classify(line, 0, line.size(), tokens);
+    auto tokenized = CommandParser::parse(
+        grammar::Line(line, tokens.spaces.data(), tokens.words.data(), tokens.quotes.data(), 0));
+    EXPECT_EQ(plain.has_value(), tokenized.has_value()) << line;
+    if (plain && tokenized) {
+        EXPECT_EQ(plain->index(), tokenized->index()) << line;
+    }
+    return plain;
+}
+
+/// @brief The command of type T line parses into; fails the test if it
+///        parses into nothing or something else
+template<typename T>
+T parseAs(std::string_view line) {
+    auto command = parse(line);
+    if (!command) {
+        ADD_FAILURE() << "rejected: " << line;
+        return T{};
+    }
+    if (!std::holds_alternative<T>(*command)) {
+        ADD_FAILURE() << "parsed into alternative " << command->index() << ": " << line;
+        return T{};
+    }
+    return std::get<T>(*command);
+}
+
+/// @brief The caret line of the diagnosis of line, without the indent
+std::string caret(std::string_view line) {
+    std::string diagnosis = CommandParser::diagnose(line);
+    size_t second = diagnosis.find('\n') + 1;
+    std::string caretLine = diagnosis.substr(second, diagnosis.size() - second - 1);
+    return caretLine.substr(caretLine.find('^'));
+}
+
+std::string names(size_t count) {
+    std::string list = "u1";
+    for (size_t i = 2; i <= count; ++i) {
+        list += ",u" + std::to_string(i);
+    }
+    return list;
+}
+
+// Every row
+
+TEST(CommandParser, CreateUser) {
+    EXPECT_EQ(parseAs<CreateUserCommand>("CREATE USER alice").username, "alice");
+    EXPECT_EQ(parseAs<CreateUserCommand>("CREATE \t USER\tuser_1").username, "user_1");
+}
+
+TEST(CommandParser, CreateUsersFromAList) {
+    auto command = parseAs<CreateUsersCommand>("CREATE USERS alice,bob,carol");
+    EXPECT_FALSE(command.names.isRange);
+    EXPECT_EQ(command.names.text, "alice,bob,carol");
+    EXPECT_EQ(command.names.count(), 3u);
+}
+
+TEST(CommandParser, CreateUsersFromARange) {
+    auto command = parseAs<CreateUsersCommand>("CREATE USERS user[1..100]");
+    EXPECT_TRUE(command.names.isRange);
+    EXPECT_EQ(command.names.text, "user");
+    EXPECT_EQ(command.names.first, 1);
+    EXPECT_EQ(command.names.last, 100);
+    EXPECT_EQ(command.names.count(), 100u);
+}
+
+TEST(CommandParser, DeleteAndDisableUser) {
+    EXPECT_EQ(parseAs<DeleteUserCommand>("DELETE USER alice").username, "alice");
+    EXPECT_EQ(parseAs<DisableUserCommand>("DISABLE USER bob").username, "bob");
+}
+
+TEST(CommandParser, SendMessage) {
+    auto command = parseAs<SendMessageCommand>("SEND MESSAGE alice \"Welcome, to the system!\"");
+    EXPECT_EQ(command.username, "alice");
+    EXPECT_EQ(command.message, "Welcome, to the system!");
+    EXPECT_EQ(parseAs<SendMessageCommand>("SEND MESSAGE alice \"\"").message, "");
+    EXPECT_EQ(parseAs<SendMessageCommand>("SEND MESSAGE alice \"# not a comment\"").message, "# not a comment");
+}
+
+TEST(CommandParser, Ping) {
+    auto command = parseAs<PingCommand>("PING alice,bob 3");
+    EXPECT_EQ(command.targets, "alice,bob");
+    EXPECT_EQ(command.times, 3);
+    EXPECT_FALSE(command.summary);
+}
+
+TEST(CommandParser, AddUserToGroup) {
+    auto command = parseAs<AddUserToGroupCommand>("ADD USER alice TO GROUP admins");
+    EXPECT_EQ(command.username, "alice");
+    EXPECT_EQ(command.group, "admins");
+}
+
+TEST(CommandParser, AddUsersToGroup) {
+    auto list = parseAs<AddUsersToGroupCommand>("ADD USERS alice,bob TO GROUP admins");
+    EXPECT_EQ(list.names.text, "alice,bob");
+    EXPECT_EQ(list.group, "admins");
+    auto range = parseAs<AddUsersToGroupCommand>("ADD USERS u[5..9] TO GROUP staff");
+    EXPECT_TRUE(range.names.isRange);
+    EXPECT_EQ(range.names.count(), 5u);
+    EXPECT_EQ(range.group, "staff");
+}
+
+TEST(CommandParser, RemoveUserFromGroup) {
+    auto command = parseAs<RemoveUserFromGroupCommand>("REMOVE USER alice FROM GROUP admins");
+    EXPECT_EQ(command.username, "alice");
+    EXPECT_EQ(command.group, "admins");
+}
+
+TEST(CommandParser, GetUsers) {
+    EXPECT_FALSE(parseAs<GetUsersCommand>("GET USERS").prefix);
+}
+
+TEST(CommandParser, GetGroups) {
+    parseAs<GetGroupsCommand>("GET GROUPS");
+}
+
+TEST(CommandParser, GetMessageHistory) {
+    auto command = parseAs<GetMessageHistoryCommand>("GET MESSAGE HISTORY alice");
+    EXPECT_EQ(command.username, "alice");
+    EXPECT_FALSE(command.from);
+    EXPECT_FALSE(command.limit);
+}
+
+TEST(CommandParser, Exit) {
+    parseAs<ExitCommand>("EXIT");
+}
+
+// Rows that share a verb
+
+TEST(CommandParser, CreateUserAndCreateUsersAreToldApart) {
+    EXPECT_EQ(parseAs<CreateUserCommand>("CREATE USER alice").username, "alice");
+    EXPECT_EQ(parseAs<CreateUsersCommand>("CREATE USERS alice").names.text, "alice");
+    // The first row that matches decides, so a list after USER is not read as USERS
+    EXPECT_FALSE(parse("CREATE USER alice,bob"));
+    EXPECT_EQ(caret("CREATE USER alice,bob"), "^ column 18: expected end of line");
+    EXPECT_FALSE(parse("CREATE USERSalice"));
+}
+
+TEST(CommandParser, GetUsersAndGetUsersWithPrefixAreToldApart) {
+    EXPECT_FALSE(parseAs<GetUsersCommand>("GET USERS").prefix);
+    EXPECT_EQ(parseAs<GetUsersCommand>("GET USERS WITH PREFIX al").prefix, "al");
+    parseAs<GetGroupsCommand>("GET GROUPS");
+    EXPECT_EQ(parseAs<GetMessageHistoryCommand>("GET MESSAGE HISTORY al").username, "al");
+}
+
+TEST(CommandParser, AddUserAndAddUsersAreToldApart) {
+    EXPECT_EQ(parseAs<AddUserToGroupCommand>("ADD USER alice TO GROUP g").username, "alice");
+    EXPECT_EQ(parseAs<AddUsersToGroupCommand>("ADD USERS alice TO GROUP g").names.text, "alice");
+    EXPECT_FALSE(parse("ADD USER alice,bob TO GROUP g"));
+}
+
+// Optional tails
+
+TEST(CommandParser, PingSummaryIsOptional) {
+    EXPECT_TRUE(parseAs<PingCommand>("PING alice 3 SUMMARY").summary);
+    EXPECT_FALSE(parseAs<PingCommand>("PING alice 3").summary);
+    EXPECT_FALSE(parse("PING alice 3 SUMMARIES"));
+    EXPECT_FALSE(parse("PING alice 3 "));
+    EXPECT_EQ(caret("PING alice 3 "), "^ column 14: expected SUMMARY");
+}
+
+TEST(CommandParser, GetUsersPrefixNeedsAName) {
+    EXPECT_FALSE(parse("GET USERS WITH PREFIX"));
+    EXPECT_FALSE(parse("GET USERS WITH"));
+    EXPECT_EQ(caret("GET USERS WITH PREFIX "), "^ column 23: expected a name");
+}
+
+TEST(CommandParser, MessageHistoryTakesFromAndLimitInThatOrder) {
+    auto from = parseAs<GetMessageHistoryCommand>("GET MESSAGE HISTORY alice FROM 10");
+    EXPECT_EQ(from.from, 10);
+    EXPECT_FALSE(from.limit);
+    auto limit = parseAs<GetMessageHistoryCommand>("GET MESSAGE HISTORY alice LIMIT 20");
+    EXPECT_FALSE(limit.from);
+    EXPECT_EQ(limit.limit, 20);
+    auto both = parseAs<GetMessageHistoryCommand>("GET MESSAGE HISTORY alice FROM 10 LIMIT 20");
+    EXPECT_EQ(both.from, 10);
+    EXPECT_EQ(both.limit, 20);
+    EXPECT_FALSE(parse("GET MESSAGE HISTORY alice LIMIT 20 FROM 10"));
+    EXPECT_FALSE(parse("GET MESSAGE HISTORY alice FROM"));
+    EXPECT_EQ(caret("GET MESSAGE HISTORY alice FROM x"), "^ column 32: expected a number");
+}
+
+// Limits
+
+TEST(CommandParser, PingTakesAtMost64Targets) {
+    EXPECT_EQ(PingCommand::kMaxTargets, 64u);
+    EXPECT_EQ(parseAs<PingCommand>("PING " + names(64) + " 1").targets, names(64));
+    std::string tooMany = "PING " + names(65) + " 1";
+    EXPECT_FALSE(parse(tooMany));
+    size_t column = tooMany.find("u65") + 1;
+    EXPECT_EQ(caret(tooMany), "^ column " + std::to_string(column) + ": expected at most 64 names");
+}
+
+TEST(CommandParser, RangesNameAtMostAMillionUsers) {
+    EXPECT_EQ(NameList::kMaxRangeNames, 1000000u);
+    EXPECT_EQ(parseAs<CreateUsersCommand>("CREATE USERS u[1..1000000]").names.count(), 1000000u);
+    EXPECT_EQ(parseAs<CreateUsersCommand>("CREATE USERS u[0..999999]").names.count(), 1000000u);
+    EXPECT_FALSE(parse("CREATE USERS u[1..1000001]"));
+    EXPECT_EQ(caret("CREATE USERS u[1..1000001]"), "^ column 19: expected a range of at most 1000000 names");
+    EXPECT_FALSE(parse("ADD USERS u[0..2147483647] TO GROUP g"));
+}
+
+TEST(CommandParser, RangesCountUp) {
+    EXPECT_EQ(parseAs<CreateUsersCommand>("CREATE USERS u[7..7]").names.count(), 1u);
+    EXPECT_FALSE(parse("CREATE USERS u[5..3]"));
+    EXPECT_EQ(caret("CREATE USERS u[5..3]"), "^ column 19: expected first <= last");
+}
+
+TEST(CommandParser, NumbersFitAnInt) {
+    EXPECT_EQ(parseAs<PingCommand>("PING alice 2147483647").times, 2147483647);
+    EXPECT_FALSE(parse("PING alice 2147483648"));
+    EXPECT_EQ(caret("PING alice 2147483648"), "^ column 12: expected a number of at most 2147483647");
+    EXPECT_FALSE(parse("CREATE USERS u[1..99999999999]"));
+    EXPECT_EQ(caret("CREATE USERS u[1..99999999999]"), "^ column 19: expected a number of at most 2147483647");
+}
+
+// Diagnoses
+
+TEST(CommandParser, DiagnosisPointsAtTheColumnAndListsWhatWasExpected) {
+    EXPECT_EQ(CommandParser::diagnose("SEND MESSAGE alice"),
+              "   SEND MESSAGE alice\n"
+              "                     ^ column 19: expected whitespace or a quoted string\n");
+    EXPECT_EQ(caret("SEND MESSAGE alice "), "^ column 20: expected a quoted string");
+    EXPECT_EQ(caret("SEND MESSAGE alice \"hi"), "^ column 23: expected a closing quote");
+    EXPECT_EQ(caret("ADD USER alice TO GRUP admins"), "^ column 19: expected GROUP");
+    EXPECT_EQ(caret("GET"), "^ column 4: expected USERS, GROUPS, MESSAGE or whitespace");
+    EXPECT_EQ(caret("GET THINGS"), "^ column 5: expected USERS, GROUPS or MESSAGE");
+    EXPECT_EQ(caret("PING alice"), "^ column 11: expected ',', whitespace or a number");
+    EXPECT_EQ(caret("CREATE USERS u[1..5"), "^ column 20: expected ']'");
+}
+
+TEST(CommandParser, LinesEndingEarlyNameWhatIsMissing) {
+    // Task lines are trimmed, so these fail on the whitespace at their end
+    EXPECT_EQ(caret("ADD USER fede"), "^ column 14: expected TO or whitespace");
+    EXPECT_EQ(caret("ADD USER alice TO"), "^ column 18: expected GROUP or whitespace");
+    EXPECT_EQ(caret("ADD USER alice TO GROUP"), "^ column 24: expected whitespace or a name");
+    EXPECT_EQ(caret("GET MESSAGE HISTORY alice LIMIT"), "^ column 32: expected whitespace or a number");
+    EXPECT_EQ(caret("CREATE"), "^ column 7: expected USER, USERS or whitespace");
+}
+
+TEST(CommandParser, UnknownVerbsListEveryVerb) {
+    EXPECT_FALSE(parse("FROBNICATE alice"));
+    EXPECT_FALSE(parse(""));
+    EXPECT_EQ(caret("FROBNICATE alice"),
+              "^ column 1: expected CREATE, DELETE, DISABLE, SEND, PING, ADD, REMOVE, GET or EXIT");
+}
+
+TEST(CommandParser, ColumnsCountCharactersNotBytes) {
+    EXPECT_EQ(caret("SEND MESSAGE \xC3\xA9l\xC3\xA8ve"), "^ column 14: expected a name");
+    EXPECT_EQ(caret("CREATE USER \xC3\xA9mile"), "^ column 13: expected a name");
+    EXPECT_EQ(caret("DELETE USER al\xC3\xA9"), "^ column 15: expected end of line");
+    EXPECT_TRUE(CommandParser::diagnose("CREATE USER alice").empty());
+}
+
+} // namespace
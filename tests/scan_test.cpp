@@ -0,0 +1,188 @@
+// LineScanner: every kernel splits lines and classifies tokens exactly as
+// the scalar loop does, for every byte value and wherever blocks end;
+// grammar::Line reads the masks as a plain line reads the bytes, and
+// TaskSource hands out masks for every line, wherever its pieces end
+#include <algorithm>
+#include <cstdio>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <fmt/format.h>
+
+#include "parser/chars.hpp"
+#include "output/sink.hpp"
+#include "parser/grammar.hpp"
+#include "parser/parser.hpp"
+#include "task/scan.hpp"
+#include "task/source.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#endif
+
+namespace {
+
+const ScanKernel kKernels[] = {ScanKernel::Scalar, ScanKernel::Sse2, ScanKernel::Avx2, ScanKernel::Neon};
+
+/// @brief Text of length bytes drawn mostly from the grammar's alphabet,
+///        with every other byte value now and then
+std::string randomText(size_t length, std::mt19937& random) {
+    static const std::string kCommon = "abzAZ09_ \t\"#\n,.[]\r\v\f";
+    std::string text(length, ' ');
+    for (auto& c : text) {
+        std::uint32_t draw = random();
+        c = draw % 4 == 0 ? static_cast<char>(draw >> 8) : kCommon[(draw >> 8) % kCommon.size()];
+    }
+    return text;
+}
+
+/// @brief Bit i set when byte i of text has the class, as TextTokens keeps it
+std::vector<std::uint64_t> expectedMask(const std::string& text, bool (*has)(char)) {
+    std::vector<std::uint64_t> mask((text.size() + 63) / 64);
+    for (size_t i = 0; i < text.size(); ++i) {
+        if (has(text[i])) {
+            mask[i / 64] |= std::uint64_t(1) << (i % 64);
+        }
+    }
+    return mask;
+}
+
+TEST(LineScanner, KernelsTokenizeLikeTheCharacterTable) {
+    std::mt19937 random(26);
+    std::string text = randomText(3000, random);
+    auto spaces = expectedMask(text, chars::isSpace);
+    auto words = expectedMask(text, chars::isWord);
+    auto quotes = expectedMask(text, [](char c) { return c == '"'; });
+    for (auto kernel : kKernels) {
+        if (!LineScanner::supported(kernel)) {
+            continue;
+        }
+        for (size_t piece : {size_t(1), size_t(63), size_t(64), size_t(1000), text.size()}) {
+            LineScanner scanner(kernel);
+            std::vector<LineSpan> spans;
+            TextTokens tokens;
+            tokens.restart(0);
+            for (size_t from = 0; from < text.size(); from += piece) {
+                scanner.scan(text, from, std::min(from + piece, text.size()), spans, &tokens);
+            }
+            EXPECT_EQ(tokens.spaces, spaces) << LineScanner::name(kernel) << " piece " << piece;
+            EXPECT_EQ(tokens.words, words) << LineScanner::name(kernel) << " piece " << piece;
+            EXPECT_EQ(tokens.quotes, quotes) << LineScanner::name(kernel) << " piece " << piece;
+        }
+    }
+}
+
+TEST(LineScanner, TokensRestartedMidTextCoverTheRestOnly) {
+    std::mt19937 random(27);
+    std::string text = randomText(700, random);
+    for (auto kernel : kKernels) {
+        if (!LineScanner::supported(kernel)) {
+            continue;
+        }
+        for (size_t at : {size_t(0), size_t(5), size_t(64), size_t(101)}) {
+            LineScanner scanner(kernel);
+            std::vector<LineSpan> spans;
+            TextTokens tokens;
+            scanner.scan(text, 0, at, spans);
+            tokens.restart(at);
+            scanner.scan(text, at, text.size(), spans, &tokens);
+            EXPECT_EQ(tokens.base, at);
+            EXPECT_EQ(tokens.words, expectedMask(text.substr(at), chars::isWord))
+                << LineScanner::name(kernel) << " at " << at;
+        }
+    }
+}
+
+TEST(LineScanner, TokenizedLinesReadLikePlainOnes) {
+    std::mt19937 random(28);
+    std::string text = randomText(2000, random);
+    LineScanner scanner;
+    std::vector<LineSpan> spans;
+    TextTokens tokens;
+    tokens.restart(0);
+    scanner.scan(text, 0, text.size(), spans, &tokens);
+    scanner.finish(text.size(), spans);
+    for (const auto& span : spans) {
+        std::string_view view(text.data() + span.start, span.end - span.start);
+        grammar::Line line(view, tokens.spaces.data(), tokens.words.data(), tokens.quotes.data(), span.start);
+        for (size_t i = 0; i <= view.size(); ++i) {
+            ASSERT_EQ(grammar::endOfSpace(line, i), grammar::endOfSpace(view, i)) << "line at " << span.start << ", byte " << i;
+            ASSERT_EQ(grammar::endOfWord(line, i), grammar::endOfWord(view, i)) << "line at " << span.start << ", byte " << i;
+            ASSERT_EQ(grammar::nextQuote(line, i), grammar::nextQuote(view, i)) << "line at " << span.start << ", byte " << i;
+        }
+    }
+}
+
+TEST(LineScanner, KernelsSplitLinesLikeTheScalarLoop) {
+    std::mt19937 random(64);
+    std::string text = randomText(5000, random);
+    auto lines = [&](ScanKernel kernel, size_t piece) {
+        LineScanner scanner(kernel);
+        std::vector<LineSpan> spans;
+        for (size_t from = 0; from < text.size(); from += piece) {
+            scanner.scan(text, from, std::min(from + piece, text.size()), spans);
+        }
+        scanner.finish(text.size(), spans);
+        std::vector<std::pair<size_t, size_t>> result;
+        for (const auto& span : spans) {
+            result.emplace_back(span.start, span.end);
+        }
+        return result;
+    };
+    auto expected = lines(ScanKernel::Scalar, text.size());
+    ASSERT_GT(expected.size(), 100u);
+    for (auto kernel : kKernels) {
+        if (!LineScanner::supported(kernel)) {
+            continue;
+        }
+        for (size_t piece : {size_t(1), size_t(63), size_t(64), size_t(1000), text.size()}) {
+            EXPECT_EQ(lines(kernel, piece), expected) << LineScanner::name(kernel) << " piece " << piece;
+        }
+    }
+}
+
+TEST(TaskSource, TokenizedLinesMatchPlainOnesAcrossPieces) {
+    // Lines of every length around a piece, so some begin in one and end in the next
+    std::mt19937 random(29);
+    std::string text;
+    while (text.size() < 3 * TaskSource::kScanBytes) {
+        text += "SEND MESSAGE alice \"" + std::string(random() % 200, 'x') + "\"  # note\n";
+        text += "ADD USER bob TO GROUP g" + std::string(random() % 20, '_') + "\n\n";
+        text += "CREATE USERS u[1.." + std::to_string(random() % 2000) + "]\n";
+    }
+    text += "PING alice,bob 3";
+    std::string path = fmt::format("{}wzh-scan-test-{}", ::testing::TempDir(), ::getpid());
+    FileSink(path).write(text);
+    for (size_t plainFirst : {size_t(0), size_t(1), size_t(100)}) {
+        TaskSource plain(path);
+        TaskSource tokenized(path);
+        size_t count = 0;
+        while (auto expected = plain.next()) {
+            if (count < plainFirst) {
+                ASSERT_EQ(tokenized.next(), expected);
+            } else {
+                auto line = tokenized.nextTokenized();
+                ASSERT_TRUE(line);
+                ASSERT_EQ(line->view(), *expected) << "line " << count;
+                auto command = CommandParser::parse(*line);
+                auto plainCommand = CommandParser::parse(*expected);
+                ASSERT_EQ(command.has_value(), plainCommand.has_value()) << *expected;
+                if (command) {
+                    ASSERT_EQ(command->index(), plainCommand->index()) << *expected;
+                }
+            }
+            ++count;
+        }
+        EXPECT_FALSE(tokenized.nextTokenized());
+        EXPECT_GT(count, 3000u);
+    }
+    std::remove(path.c_str());
+}
+
+} // namespace
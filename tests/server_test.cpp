@@ -0,0 +1,188 @@
+// TaskServer against clients that do not read their transcripts: what the
+// server holds stays bounded and the other connections are still served.
+// With shared state, connections see each other's changes
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <fmt/format.h>
+
+#include "output/buffered.hpp"
+#include "output/sink.hpp"
+#include "server/server.hpp"
+#include "task/processor.hpp"
+#include "task/session.hpp"
+#include "user/concurrent.hpp"
+#include "user/manager.hpp"
+
+#if defined(__linux__)
+
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+// Most a connection may hold: the unsent limit, as many sent bytes not yet
+// compacted away, and the last piece written, a block roughly
+constexpr size_t kMaxHeld = 2 * TaskServer::kMaxPendingBytes + BufferedOutput::kBlockBytes;
+
+/// @brief One client connection, failing the test rather than hanging
+class Client {
+private:
+    int fd = -1;
+
+public:
+    explicit Client(const std::string& path) {
+        fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        path.copy(address.sun_path, sizeof(address.sun_path) - 1);
+        timeval timeout{30, 0};
+        ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        EXPECT_EQ(::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)), 0);
+    }
+
+    ~Client() { close(); }
+
+    Client(const Client&) = delete;
+    Client& operator=(const Client&) = delete;
+
+    /// @brief Send text, then shut down the sending side, which ends the task
+    void sendTask(std::string_view text) {
+        while (!text.empty()) {
+            ssize_t count = ::send(fd, text.data(), text.size(), MSG_NOSIGNAL);
+            ASSERT_GT(count, 0);
+            text.remove_prefix(static_cast<size_t>(count));
+        }
+        ::shutdown(fd, SHUT_WR);
+    }
+
+    /// @brief Read until the server closes its side, or up to limit bytes
+    std::string receive(size_t limit = std::string::npos) {
+        std::string received;
+        char buffer[1 << 16];
+        while (received.size() < limit) {
+            ssize_t count = ::recv(fd, buffer, std::min(sizeof(buffer), limit - received.size()), 0);
+            if (count <= 0) {
+                EXPECT_EQ(count, 0) << "timed out or failed";
+                break;
+            }
+            received.append(buffer, static_cast<size_t>(count));
+        }
+        return received;
+    }
+
+    void close() {
+        if (fd >= 0) {
+            ::close(fd);
+            fd = -1;
+        }
+    }
+};
+
+/// @brief A server running on its own thread until destruction
+class ServerFixture : public ::testing::Test {
+protected:
+    MemorySink discarded;
+    TaskProcessor processor{ProcessorOptions{}, discarded};
+    std::string path = fmt::format("{}wzh-server-test-{}.sock", ::testing::TempDir(), ::getpid());
+    TaskServer server{processor, "unix:" + path};
+    std::thread loop{[this] { server.run(); }};
+
+    ~ServerFixture() override { stopServer(); }
+
+    void stopServer() {
+        if (loop.joinable()) {
+            server.stop();
+            loop.join();
+        }
+    }
+
+    /// @brief The transcript the task gets as connection number n
+    std::string expected(const std::string& task, size_t n) {
+        UserManager users;
+        MemorySink transcript;
+        {
+            BufferedOutput out(transcript);
+            TaskSession session(processor, fmt::format("connection {}", n), users, out);
+            session.feed(task);
+            session.finish();
+        }
+        return std::string(transcript.contents());
+    }
+};
+
+TEST_F(ServerFixture, ClientThatDoesNotReadIsHeldAtTheLimit) {
+    // About 70 MB of transcript from one line
+    const std::string flood = "CREATE USER a\nPING a 2000000\nGET USERS\n";
+    Client idle(path);
+    idle.sendTask(flood);
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    // Served in full while the flood waits
+    const std::string task = "CREATE USER b\nGET USERS\n";
+    Client other(path);
+    other.sendTask(task);
+    EXPECT_EQ(other.receive(), expected(task, 2));
+
+    // The flood resumes as it is read, and arrives whole
+    EXPECT_EQ(idle.receive(), expected(flood, 1));
+
+    stopServer();
+    EXPECT_EQ(server.stats().completedTasks, 2u);
+    EXPECT_LE(server.stats().peakHeldBytes, kMaxHeld);
+}
+
+TEST_F(ServerFixture, ClientThatLeavesMidTranscriptIsDropped) {
+    Client idle(path);
+    idle.sendTask("PING a 2000000000\n");
+    EXPECT_EQ(idle.receive(100).size(), 100u);
+    idle.close();
+
+    const std::string task = "CREATE USER b\nEXIT\n";
+    Client other(path);
+    other.sendTask(task);
+    EXPECT_EQ(other.receive(), expected(task, 2));
+
+    stopServer();
+    EXPECT_EQ(server.stats().completedTasks, 1u);
+    EXPECT_LE(server.stats().peakHeldBytes, kMaxHeld);
+}
+
+TEST(SharedStateServer, ConnectionsSeeEachOthersChanges) {
+    ConcurrentUserManager users;
+    ProcessorOptions options;
+    options.sharedState = &users;
+    MemorySink discarded;
+    TaskProcessor processor(options, discarded);
+    std::string path = fmt::format("{}wzh-shared-server-test-{}.sock", ::testing::TempDir(), ::getpid());
+    TaskServer server(processor, "unix:" + path);
+    std::thread loop([&] { server.run(); });
+
+    {
+        Client first(path);
+        first.sendTask("CREATE USER alice\nADD USER alice TO GROUP admins\n");
+        EXPECT_NE(first.receive().find("ADD USER alice TO GROUP admins"), std::string::npos);
+    }
+    Client second(path);
+    second.sendTask("GET USERS\nGET GROUPS\nCREATE USER alice\n");
+    std::string transcript = second.receive();
+    EXPECT_NE(transcript.find("Users: alice"), std::string::npos) << transcript;
+    EXPECT_NE(transcript.find("Groups: admins"), std::string::npos) << transcript;
+    EXPECT_NE(transcript.find("User already exists"), std::string::npos) << transcript;
+
+    server.stop();
+    loop.join();
+    EXPECT_EQ(users.getUsers(), std::vector<std::string>{"alice"});
+}
+
+} // namespace
+
+#endif
@@ -0,0 +1,133 @@
+// TaskSession fed with bounded room: transcripts stop partway and resume
+// to exactly what an unbounded session writes
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+#include <gtest/gtest.h>
+
+#include "output/buffered.hpp"
+#include "output/sink.hpp"
+#include "task/processor.hpp"
+#include "task/session.hpp"
+#include "user/manager.hpp"
+
+namespace {
+
+constexpr size_t kRoom = 4096;
+
+// Slack a piece may overrun its room by: a quarter block of PING lines
+constexpr size_t kOverrun = BufferedOutput::kBlockBytes / 4 + 256;
+
+const std::string kTask = "CREATE USERS u[1..20000]\n"
+                          "SEND MESSAGE u7 \"hello\"\n"
+                          "PING u1,u2,nobody 30000\n"
+                          "GET USERS WITH PREFIX u1\n"
+                          "GET MESSAGE HISTORY u7\n"
+                          "PING u3 5 SUMMARY\n"
+                          "GET GROUPS\n";
+
+/// @brief A task session writing to memory, with its own processor and users
+struct Harness {
+    MemorySink discarded;
+    TaskProcessor processor{ProcessorOptions{}, discarded};
+    UserManager users;
+    MemorySink transcript;
+    BufferedOutput out{transcript, 1024};
+    TaskSession session{processor, "session", users, out};
+
+    std::string contents() {
+        out.flush();
+        return std::string(transcript.contents());
+    }
+};
+
+std::string unbounded(const std::string& task) {
+    Harness harness;
+    harness.session.feed(task);
+    harness.session.finish();
+    return harness.contents();
+}
+
+/// @brief Resume with kRoom at a time until the session stops waiting,
+///        checking each step stays near its room
+void drain(Harness& harness) {
+    while (harness.session.blocked()) {
+        std::uint64_t before = harness.out.written();
+        harness.session.resume(kRoom);
+        ASSERT_LE(harness.out.written() - before, kRoom + kOverrun);
+    }
+}
+
+TEST(TaskSession, StopsAtRoomAndResumesToTheSameTranscript) {
+    Harness harness;
+    harness.session.feed(kTask, kRoom);
+    EXPECT_TRUE(harness.session.blocked());
+    EXPECT_LE(harness.out.written(), kRoom + kOverrun);
+    drain(harness);
+    harness.session.finish(kRoom);
+    drain(harness);
+    EXPECT_TRUE(harness.session.finished());
+    EXPECT_EQ(harness.contents(), unbounded(kTask));
+}
+
+TEST(TaskSession, StopsPartwayThroughOnePing) {
+    Harness harness;
+    harness.session.feed("PING a 1000000\n", kRoom);
+    ASSERT_TRUE(harness.session.blocked());
+    EXPECT_LE(harness.out.written(), kRoom + kOverrun);
+
+    // Lines given meanwhile wait for it
+    harness.session.feed("CREATE USER a\n", kRoom);
+    EXPECT_EQ(harness.contents().find("CREATE USER"), std::string::npos);
+    drain(harness);
+    EXPECT_NE(harness.contents().find("✅ CREATE USER a\n"), std::string::npos);
+    EXPECT_FALSE(harness.session.finished());
+}
+
+TEST(TaskSession, BytesFedInPiecesWhileBlocked) {
+    Harness harness;
+    for (size_t i = 0; i < kTask.size(); i += 7) {
+        harness.session.feed(std::string_view(kTask).substr(i, 7), kRoom);
+    }
+    drain(harness);
+    harness.session.finish(kRoom);
+    drain(harness);
+    EXPECT_EQ(harness.contents(), unbounded(kTask));
+}
+
+TEST(TaskSession, UnterminatedLastLineRunsOnceResumed) {
+    std::string task = "CREATE USER a\nPING a 50000\nGET USERS";
+    Harness harness;
+    harness.session.feed(task, kRoom);
+    harness.session.finish(kRoom);
+    EXPECT_FALSE(harness.session.finished());
+    drain(harness);
+    EXPECT_TRUE(harness.session.finished());
+    std::string transcript = harness.contents();
+    EXPECT_EQ(transcript, unbounded(task));
+    EXPECT_NE(transcript.find("Users: a\n[Task session completed successfully]"), std::string::npos);
+}
+
+TEST(TaskSession, FailingLineEndsTaskAfterItsTranscript) {
+    std::string task = "PING a 50000\nDELETE USER a\nCREATE USER b\n";
+    Harness harness;
+    harness.session.feed(task, kRoom);
+    drain(harness);
+    EXPECT_TRUE(harness.session.finished());
+    EXPECT_EQ(harness.contents(), unbounded(task));
+    EXPECT_EQ(harness.contents().find("CREATE USER b"), std::string::npos);
+}
+
+TEST(TaskSession, OverlongLineFailsOnceTheLinesBeforeItHaveRun) {
+    std::string task = "CREATE USER a\nPING a 50000\n" + std::string(TaskSession::kMaxLineBytes + 1, 'x');
+    Harness harness;
+    harness.session.feed(task, kRoom);
+    EXPECT_FALSE(harness.session.finished());
+    drain(harness);
+    EXPECT_TRUE(harness.session.finished());
+    EXPECT_EQ(harness.contents(), unbounded(task));
+    EXPECT_NE(harness.contents().find("Line longer than"), std::string::npos);
+}
+
+} // namespace
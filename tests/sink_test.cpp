@@ -0,0 +1,44 @@
+// MemorySink: contents drained from the front in pieces, as the server sends them
+#include <algorithm>
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+#include <gtest/gtest.h>
+
+#include "output/sink.hpp"
+
+namespace {
+
+TEST(MemorySink, DiscardTakesBytesOffTheFront) {
+    MemorySink sink;
+    sink.write("hello, ");
+    sink.write("world");
+    sink.discard(3);
+    EXPECT_EQ(sink.contents(), "lo, world");
+    sink.write("!");
+    sink.discard(4);
+    EXPECT_EQ(sink.contents(), "world!");
+    EXPECT_EQ(sink.take(), "world!");
+    EXPECT_TRUE(sink.contents().empty());
+}
+
+TEST(MemorySink, DrainingInSmallPiecesKeepsAtMostTwiceWhatIsLeft) {
+    MemorySink sink;
+    std::string expected;
+    for (size_t i = 0; i < 1000; ++i) {
+        expected += std::to_string(i) + ",";
+    }
+    sink.write(expected);
+    size_t drained = 0;
+    while (drained < expected.size()) {
+        size_t piece = std::min<size_t>(7, expected.size() - drained);
+        sink.discard(piece);
+        drained += piece;
+        ASSERT_EQ(sink.contents(), std::string_view(expected).substr(drained));
+        ASSERT_LE(sink.retained(), 2 * sink.contents().size() + 1);
+    }
+    EXPECT_EQ(sink.retained(), 0u);
+}
+
+} // namespace
@@ -0,0 +1,245 @@
+// Snapshot: a saved state restores to the same users, groups and messages,
+// and a damaged file or malformed contents are refused
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <fmt/format.h>
+
+#include "output/sink.hpp"
+#include "task/codec.hpp"
+#include "task/mapped.hpp"
+#include "task/snapshot.hpp"
+#include "user/manager.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#endif
+
+namespace {
+
+template<typename Range>
+std::vector<std::string> strings(const Range& range) {
+    return std::vector<std::string>(range.begin(), range.end());
+}
+
+/// @brief A snapshot written by hand, to the documented layout
+class Image {
+private:
+    std::string body;
+
+public:
+    std::uint32_t users = 0;
+    std::uint32_t groups = 0;
+    std::uint64_t nameBytes = 0;
+
+    Image& group(std::string_view name) {
+        putVarint(body, static_cast<std::uint32_t>(name.size()));
+        body.append(name);
+        ++groups;
+        return *this;
+    }
+
+    Image& user(std::string_view name, bool enabled, const std::vector<std::uint32_t>& groupIndices,
+                const std::vector<std::string>& messages = {}) {
+        putVarint(body, static_cast<std::uint32_t>(name.size()));
+        body.append(name);
+        body.push_back(enabled ? 1 : 0);
+        putVarint(body, static_cast<std::uint32_t>(groupIndices.size()));
+        for (std::uint32_t index : groupIndices) {
+            putVarint(body, index);
+        }
+        putVarint(body, static_cast<std::uint32_t>(messages.size()));
+        for (const auto& message : messages) {
+            putVarint(body, static_cast<std::uint32_t>(message.size()));
+            body.append(message);
+        }
+        ++users;
+        nameBytes += name.size();
+        return *this;
+    }
+
+    Image& raw(std::string_view bytes) {
+        body.append(bytes);
+        return *this;
+    }
+
+    std::string bytes(std::uint64_t generation = 0) const {
+        std::string header("WZHS");
+        putLe(header, Snapshot::kVersion, 4);
+        putLe(header, checksum(body), 8);
+        putLe(header, users, 4);
+        putLe(header, groups, 4);
+        putLe(header, generation, 8);
+        putLe(header, nameBytes, 8);
+        return header + body;
+    }
+};
+
+class SnapshotFixture : public ::testing::Test {
+protected:
+    std::string path = fmt::format("{}wzh-snapshot-test-{}.wzs", ::testing::TempDir(), ::getpid());
+
+    void TearDown() override { std::remove(path.c_str()); }
+
+    void write(std::string_view bytes) { FileSink(path).write(bytes); }
+
+    std::string read() { return std::string(MappedFile(path).view()); }
+
+    /// @brief The message opening bytes throws with, or "" if it does not,
+    /// in which case they must restore
+    std::string openError(std::string_view bytes) {
+        write(bytes);
+        std::unique_ptr<Snapshot> snapshot;
+        try {
+            snapshot = std::make_unique<Snapshot>(path);
+        } catch (const std::runtime_error& e) {
+            return e.what();
+        }
+        UserManager users;
+        snapshot->restore(users);
+        return "";
+    }
+
+    /// @brief A state with every kind of content, saved to path
+    void saveSample(UserManager& users, std::uint64_t generation) {
+        for (const char* name : {"carol", "alice", "bob", "dave", "eve"}) {
+            ASSERT_TRUE(users.createUser(name));
+        }
+        ASSERT_TRUE(users.deleteUser("dave"));
+        ASSERT_TRUE(users.disableUser("bob"));
+        ASSERT_TRUE(users.addUserToGroup("alice", "staff"));
+        ASSERT_TRUE(users.addUserToGroup("alice", "admins"));
+        ASSERT_TRUE(users.addUserToGroup("carol", "staff"));
+        ASSERT_TRUE(users.addUserToGroup("eve", "emptied"));
+        ASSERT_TRUE(users.removeUserFromGroup("eve", "emptied"));
+        ASSERT_TRUE(users.sendMessage("alice", "first"));
+        ASSERT_TRUE(users.sendMessage("alice", ""));
+        ASSERT_TRUE(users.sendMessage("alice", std::string(300, 'm')));
+        ASSERT_TRUE(users.sendMessage("carol", "hello"));
+        Snapshot::save(users, path, generation);
+    }
+};
+
+TEST_F(SnapshotFixture, RestoresTheSavedState) {
+    UserManager saved;
+    saveSample(saved, 7);
+
+    Snapshot snapshot(path);
+    EXPECT_EQ(snapshot.userCount(), 4u);
+    EXPECT_EQ(snapshot.groupCount(), 2u);
+    EXPECT_EQ(snapshot.generation(), 7u);
+
+    UserManager restored;
+    restored.createUser("stale");
+    snapshot.restore(restored);
+    EXPECT_EQ(strings(restored.getUsers()), strings(saved.getUsers()));
+    EXPECT_EQ(strings(restored.getGroups()), (std::vector<std::string>{"admins", "staff"}));
+    for (const char* name : {"alice", "bob", "carol", "eve"}) {
+        EXPECT_EQ(restored.isUserEnabled(name), saved.isUserEnabled(name)) << name;
+        EXPECT_EQ(strings(restored.getMessageHistory(name)), strings(saved.getMessageHistory(name))) << name;
+    }
+    EXPECT_FALSE(restored.userExists("stale"));
+    EXPECT_FALSE(restored.userExists("dave"));
+
+    // Member counts survive too: a group ends with its last member
+    ASSERT_TRUE(restored.removeUserFromGroup("alice", "admins"));
+    EXPECT_EQ(strings(restored.getGroups()), std::vector<std::string>{"staff"});
+    ASSERT_TRUE(restored.removeUserFromGroup("alice", "staff"));
+    EXPECT_EQ(strings(restored.getGroups()), std::vector<std::string>{"staff"});
+    ASSERT_TRUE(restored.removeUserFromGroup("carol", "staff"));
+    EXPECT_TRUE(restored.getGroups().empty());
+
+    // Saved again, the state gives the same file
+    std::string first = read();
+    UserManager again;
+    snapshot.restore(again);
+    Snapshot::save(again, path, 7);
+    EXPECT_EQ(read(), first);
+}
+
+TEST_F(SnapshotFixture, MatchesTheDocumentedLayout) {
+    Image image;
+    image.group("g0").group("g1").user("b", true, {0, 1}, {"hi"}).user("a", false, {1});
+    UserManager users;
+    write(image.bytes(3));
+    Snapshot snapshot(path);
+    EXPECT_EQ(snapshot.generation(), 3u);
+    snapshot.restore(users);
+    EXPECT_EQ(strings(users.getUsers()), (std::vector<std::string>{"a", "b"}));
+    EXPECT_EQ(strings(users.getGroups()), (std::vector<std::string>{"g0", "g1"}));
+    EXPECT_FALSE(users.isUserEnabled("a"));
+    EXPECT_EQ(strings(users.getMessageHistory("b")), std::vector<std::string>{"hi"});
+}
+
+TEST_F(SnapshotFixture, RejectsAnyChangedByteAndTruncation) {
+    UserManager users;
+    saveSample(users, 1);
+    std::string saved = read();
+    for (size_t i = 0; i < saved.size(); ++i) {
+        std::string damaged = saved;
+        damaged[i] = static_cast<char>(damaged[i] ^ 0x01);
+        // The generation is the caller's to compare
+        if (i >= 24 && i < 32) {
+            continue;
+        }
+        EXPECT_NE(openError(damaged), "") << "byte " << i;
+    }
+    for (size_t length = 0; length < saved.size(); ++length) {
+        EXPECT_NE(openError(saved.substr(0, length)), "") << "length " << length;
+    }
+    EXPECT_EQ(openError(saved), "");
+}
+
+TEST_F(SnapshotFixture, RejectsAnotherVersion) {
+    std::string bytes = Image().bytes();
+    bytes[4] = static_cast<char>(Snapshot::kVersion + 1);
+    EXPECT_EQ(openError(bytes), fmt::format("Snapshot has format version {}, expected {}", Snapshot::kVersion + 1,
+                                               Snapshot::kVersion));
+}
+
+TEST_F(SnapshotFixture, OpeningChecksOrderAndBounds) {
+    EXPECT_EQ(openError(Image().group("g").group("g").user("a", true, {0, 1}).bytes()),
+              "Corrupt snapshot: duplicate group");
+    EXPECT_EQ(openError(Image().user("a", true, {}).user("a", true, {}).bytes()),
+              "Corrupt snapshot: duplicate user");
+    EXPECT_EQ(openError(Image().group("g0").group("g1").user("a", true, {1, 0}).bytes()),
+              "Corrupt snapshot: group index out of order");
+    EXPECT_EQ(openError(Image().group("g0").group("g1").user("a", true, {0, 0}).bytes()),
+              "Corrupt snapshot: group index out of order");
+    EXPECT_EQ(openError(Image().group("g0").user("a", true, {1}).bytes()),
+              "Corrupt snapshot: group index out of order");
+    EXPECT_EQ(openError(Image().group("g0").user("a", true, {0, 0, 0}).bytes()),
+              "Corrupt snapshot: group count out of range");
+    EXPECT_EQ(openError(Image().user("a", true, {}).raw("\x01").bytes()), "Corrupt snapshot: trailing bytes");
+    Image shortNames;
+    shortNames.user("a", true, {});
+    ++shortNames.nameBytes;
+    EXPECT_EQ(openError(shortNames.bytes()), "Corrupt snapshot: name bytes mismatch");
+
+    // Counts that claim more than is there run out of bytes
+    Image extraUser;
+    extraUser.user("a", true, {});
+    ++extraUser.users;
+    EXPECT_EQ(openError(extraUser.bytes()), "Corrupt snapshot: truncated entry");
+    EXPECT_EQ(openError(Image().raw("\x05" "ab").bytes()), "Corrupt snapshot: trailing bytes");
+    Image longName;
+    longName.raw("\x05" "ab");
+    longName.users = 1;
+    EXPECT_EQ(openError(longName.bytes()), "Corrupt snapshot: string out of range");
+    Image manyMessages;
+    manyMessages.raw(std::string("\x01" "a\x01\x00\x7f", 5));
+    manyMessages.users = 1;
+    EXPECT_EQ(openError(manyMessages.bytes()), "Corrupt snapshot: message count out of range");
+    Image hugeCount;
+    hugeCount.users = 1u << 30;
+    EXPECT_EQ(openError(hugeCount.bytes()), "Corrupt snapshot: counts out of range");
+}
+
+} // namespace
@@ -0,0 +1,120 @@
+// Split parsing (ProcessorOptions::parseWorkers) reports the first invalid
+// line in file order, wherever the chunks fall, exactly as the sequential
+// and pipelined paths do
+#include <cstddef>
+#include <cstdio>
+#include <string>
+
+#include <gtest/gtest.h>
+#include <fmt/format.h>
+
+#include "output/sink.hpp"
+#include "task/processor.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#endif
+
+namespace {
+
+constexpr size_t kChunk = TaskProcessor::kSplitBytes;
+
+/// @brief A task text of valid lines, with offsets controlled to the byte
+class TaskBuilder {
+private:
+    std::string text;
+    size_t users = 0;
+
+public:
+    /// @brief Valid lines, then a comment, so that the text ends at offset
+    TaskBuilder& fillTo(size_t offset) {
+        while (text.size() + 64 < offset) {
+            text += fmt::format("CREATE USER user{}\n", users++);
+        }
+        size_t padding = offset - text.size();
+        EXPECT_GE(padding, 2u);
+        text += "#" + std::string(padding - 2, '-') + "\n";
+        EXPECT_EQ(text.size(), offset);
+        return *this;
+    }
+
+    TaskBuilder& line(const std::string& line) {
+        text += line + "\n";
+        return *this;
+    }
+
+    size_t size() const { return text.size(); }
+    const std::string& str() const { return text; }
+};
+
+std::string run(const std::string& task, ProcessorOptions options) {
+    std::string path = fmt::format("{}wzh-split-test-{}.txt", ::testing::TempDir(), ::getpid());
+    FileSink(path).write(task);
+    MemorySink transcript;
+    {
+        TaskProcessor processor(options, transcript);
+        processor.processTask(path);
+    }
+    std::remove(path.c_str());
+    return std::string(transcript.contents());
+}
+
+/// @brief Transcripts of the task split-parsed and parsed in line order
+void expectSameAsSequential(const std::string& task, const std::string& invalid) {
+    ASSERT_GE(task.size(), TaskProcessor::kLargeTaskBytes);
+    ProcessorOptions split;
+    split.parseWorkers = 4;
+    ProcessorOptions pipelined;
+    pipelined.pipeline = true;
+
+    std::string expected = run(task, ProcessorOptions{});
+    ASSERT_NE(expected.find(fmt::format("❌ Invalid command: {}\n", invalid)), std::string::npos);
+    ASSERT_NE(expected.find("stopped due to failure"), std::string::npos);
+    EXPECT_EQ(run(task, split), expected);
+    EXPECT_EQ(run(task, pipelined), expected);
+}
+
+TEST(SplitParse, InvalidLineInALaterChunk) {
+    TaskBuilder task;
+    task.fillTo(5 * kChunk + 1000).line("CREATE USR late").fillTo(8 * kChunk);
+    expectSameAsSequential(task.str(), "CREATE USR late");
+}
+
+TEST(SplitParse, InvalidLineAcrossTheSplitOffset) {
+    // Starts before the first chunk's nominal end and ends after it, so it
+    // is the last line of that chunk
+    TaskBuilder task;
+    task.fillTo(kChunk - 8).line("CREATE USR straddling").fillTo(6 * kChunk);
+    expectSameAsSequential(task.str(), "CREATE USR straddling");
+}
+
+TEST(SplitParse, InvalidLineFirstInItsChunk) {
+    // The first chunk ends at the newline at its nominal end
+    TaskBuilder task;
+    task.fillTo(kChunk + 1).line("CREATE USR first").fillTo(6 * kChunk);
+    expectSameAsSequential(task.str(), "CREATE USR first");
+}
+
+TEST(SplitParse, EarliestOfSeveralInvalidLinesIsReported) {
+    // Helpers parse ahead, so the later chunks' errors are found first
+    TaskBuilder task;
+    task.fillTo(3 * kChunk + 5000).line("CREATE USR second")
+        .fillTo(6 * kChunk).line("CREATE USR third")
+        .fillTo(7 * kChunk - 3).line("ADD USER nobody TO")
+        .fillTo(9 * kChunk);
+    std::string text = task.str();
+    expectSameAsSequential(text, "CREATE USR second");
+    EXPECT_EQ(run(text, ProcessorOptions{}).find("CREATE USR third"), std::string::npos);
+}
+
+TEST(SplitParse, ValidTaskMatchesToo) {
+    TaskBuilder task;
+    task.fillTo(6 * kChunk + 17).line("GET USERS WITH PREFIX user99");
+    ProcessorOptions split;
+    split.parseWorkers = 3;
+    std::string expected = run(task.str(), ProcessorOptions{});
+    EXPECT_NE(expected.find("completed successfully"), std::string::npos);
+    EXPECT_EQ(run(task.str(), split), expected);
+}
+
+} // namespace